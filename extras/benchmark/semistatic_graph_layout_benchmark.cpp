@@ -0,0 +1,197 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the time and the cache misses of a cascaded construction (a visit of all nodes reachable from a root, in DFS
+// order) on a SemistaticGraph, with each of the available node layouts.
+// The number of cache misses is only available on Linux (using perf_event_open), and only if the kernel allows it.
+
+#define IN_FRUIT_CPP_FILE
+#include <fruit/impl/data_structures/semistatic_graph.templates.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+using namespace std;
+using namespace fruit::impl;
+
+struct NodeValue {
+  std::uint32_t num_edges;
+  std::uint32_t last_visit;
+};
+
+using Graph = SemistaticGraph<std::size_t, NodeValue>;
+
+struct BenchmarkNode {
+  std::size_t id;
+  const vector<std::size_t>* neighbors;
+  
+  std::size_t getId() { return id; }
+  NodeValue getValue() { return NodeValue{std::uint32_t(neighbors->size()), 0}; }
+  bool isTerminal() { return neighbors->empty(); }
+  vector<std::size_t>::const_iterator getEdgesBegin() { return neighbors->begin(); }
+  vector<std::size_t>::const_iterator getEdgesEnd() { return neighbors->end(); }
+};
+
+class CacheMissCounter {
+public:
+  CacheMissCounter() {
+#ifdef __linux__
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+  }
+  
+  ~CacheMissCounter() {
+#ifdef __linux__
+    if (fd >= 0) {
+      close(fd);
+    }
+#endif
+  }
+  
+  bool isAvailable() const {
+    return fd >= 0;
+  }
+  
+  void start() {
+#ifdef __linux__
+    if (fd >= 0) {
+      ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+  
+  long long stop() {
+    long long result = 0;
+#ifdef __linux__
+    if (fd >= 0) {
+      ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(fd, &result, sizeof(result)) != sizeof(result)) {
+        result = 0;
+      }
+    }
+#endif
+    return result;
+  }
+  
+private:
+  long fd = -1;
+};
+
+// Visits all nodes reachable from `root' (in the same order as a cascaded construction in an injector) and returns the
+// number of nodes visited.
+std::size_t visit(Graph& graph, Graph::node_iterator root, std::uint32_t visit_id) {
+  std::size_t num_visited = 0;
+  vector<Graph::node_iterator> stack{root};
+  while (!stack.empty()) {
+    Graph::node_iterator node = stack.back();
+    stack.pop_back();
+    NodeValue& value = node.getNode();
+    if (value.last_visit == visit_id) {
+      continue;
+    }
+    value.last_visit = visit_id;
+    ++num_visited;
+    if (!node.isTerminal()) {
+      for (std::size_t i = value.num_edges; i > 0; --i) {
+        stack.push_back(node.neighborsBegin().getNodeIterator(i - 1, graph.begin()));
+      }
+    }
+  }
+  return num_visited;
+}
+
+void runBenchmark(const char* layout_name, Graph::Layout layout, vector<BenchmarkNode>& nodes,
+                  std::size_t num_iterations) {
+  Graph graph(nodes.begin(), nodes.end(), layout);
+  Graph::node_iterator root = graph.at(0);
+  CacheMissCounter cache_miss_counter;
+  
+  std::size_t num_visited = 0;
+  cache_miss_counter.start();
+  auto start_time = std::chrono::high_resolution_clock::now();
+  for (std::size_t i = 1; i <= num_iterations; ++i) {
+    num_visited += visit(graph, root, std::uint32_t(i));
+  }
+  auto end_time = std::chrono::high_resolution_clock::now();
+  long long cache_misses = cache_miss_counter.stop();
+  
+  double time = std::chrono::duration_cast<std::chrono::duration<double>>(end_time - start_time).count();
+  cout << layout_name << ": " << (time / num_visited * 1e9) << " ns/node";
+  if (cache_miss_counter.isAvailable()) {
+    cout << ", " << (double(cache_misses) / num_visited) << " cache misses/node";
+  } else {
+    cout << ", cache misses not available";
+  }
+  cout << endl;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc != 3) {
+    cout << "Usage: " << argv[0] << " <num_nodes> <num_iterations>" << endl;
+    return 1;
+  }
+  std::size_t num_nodes = std::atoi(argv[1]);
+  std::size_t num_iterations = std::atoi(argv[2]);
+  
+  // Each node depends on up to 3 nodes with a higher ID (so that there are no cycles), mostly nearby ones.
+  std::mt19937_64 random_generator(42);
+  vector<vector<std::size_t>> neighbors(num_nodes);
+  for (std::size_t i = 1; i < num_nodes; ++i) {
+    // This ensures that all nodes are reachable from node 0.
+    std::size_t parent = std::uniform_int_distribution<std::size_t>(i > 16 ? i - 16 : 0, i - 1)(random_generator);
+    neighbors[parent].push_back(i);
+  }
+  for (std::size_t i = 0; i + 1 < num_nodes; ++i) {
+    if (random_generator() % 2 == 0) {
+      neighbors[i].push_back(std::uniform_int_distribution<std::size_t>(i + 1, num_nodes - 1)(random_generator));
+    }
+    std::sort(neighbors[i].begin(), neighbors[i].end());
+    neighbors[i].erase(std::unique(neighbors[i].begin(), neighbors[i].end()), neighbors[i].end());
+  }
+  
+  vector<BenchmarkNode> nodes;
+  for (std::size_t i = 0; i < num_nodes; ++i) {
+    nodes.push_back(BenchmarkNode{i, &neighbors[i]});
+  }
+  std::shuffle(nodes.begin(), nodes.end(), random_generator);
+  
+  runBenchmark("Unspecified layout", Graph::Layout::UNSPECIFIED, nodes, num_iterations);
+  runBenchmark("Dependency order layout", Graph::Layout::DEPENDENCY_ORDER, nodes, num_iterations);
+  
+  return 0;
+}
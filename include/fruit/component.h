@@ -80,6 +80,10 @@ class Component {
   friend
   class Injector;
 
+  template<typename... OtherParams>
+  friend
+  class PreparedInjector;
+
   fruit::impl::ComponentStorage storage;
 
   using Comp = fruit::impl::meta::Eval<fruit::impl::meta::ConstructComponentImpl(fruit::impl::meta::Type<Params>...)>;
@@ -419,6 +423,9 @@ class PartialComponent {
    * 
    * Note that non-assisted parameters will be passed automatically by Fruit.
    * 
+   * To bind fruit::Factory<std::unique_ptr<MyClass>(int)> instead (that avoids the overhead of std::function, see
+   * factory.h), use registerFruitFactory().
+   * 
    * Unlike registerProvider(), where the signature is inferred, for this method the signature (including any Assisted
    * annotations) must be specified explicitly, while the second template parameter is inferred.
    * 
@@ -465,6 +472,24 @@ class PartialComponent {
   template<typename DecoratedSignature, typename Factory>
   PartialComponent<fruit::impl::RegisterFactory<DecoratedSignature, Factory>, Bindings...> registerFactory(Factory factory);
 
+  /**
+   * Same as registerFactory(), but this binds a fruit::Factory instead of a std::function. E.g. for the example above:
+   * 
+   * Component<fruit::Factory<std::unique_ptr<MyClass>(int)>> getMyClassComponent() {
+   *   fruit::createComponent()
+   *       ... // Bind Foo
+   *       .registerFruitFactory<std::unique_ptr<MyClass>(Foo*, Assisted<int>)>(
+   *          [](Foo* foo, int n) {
+   *              return std::unique_ptr<MyClass>(new MyClass(foo, n));
+   *          });
+   * }
+   * 
+   * The std::function is not bound, call registerFactory() too with the same lambda if both are needed.
+   */
+  template<typename DecoratedSignature, typename Factory>
+  PartialComponent<fruit::impl::RegisterFruitFactory<DecoratedSignature, Factory>, Bindings...>
+  registerFruitFactory(Factory factory);
+
   /**
    * Adds the bindings (and multibindings) in `component' to the current component.
    * 
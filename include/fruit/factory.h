@@ -0,0 +1,76 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRUIT_FACTORY_H
+#define FRUIT_FACTORY_H
+
+#include <fruit/fruit_forward_decls.h>
+
+#include <utility>
+
+namespace fruit {
+
+/**
+ * A lightweight alternative to std::function for assisted injection.
+ * 
+ * A Factory<C(Args...)> can be injected instead of a std::function<C(Args...)> when the factory is registered with
+ * registerFruitFactory() (instead of registerFactory()), or when C has an INJECT-annotated constructor with ASSISTED
+ * parameters (in that case the Factory is auto-registered when it's needed, like the std::function), e.g.:
+ * 
+ * class Foo {
+ * public:
+ *   INJECT(Foo(fruit::Factory<std::unique_ptr<MyClass>(int)> my_class_factory))
+ *     : my_class_factory(my_class_factory) {
+ *   }
+ * 
+ *   void doSomething() {
+ *     std::unique_ptr<MyClass> x = my_class_factory(42);
+ *     ...
+ *   }
+ * 
+ * private:
+ *   fruit::Factory<std::unique_ptr<MyClass>(int)> my_class_factory;
+ * };
+ * 
+ * The non-assisted parameters of the factory are injected once and stored in the injector, and a Factory only holds a
+ * pointer to them and a pointer to the function that calls the registered factory. So copying a Factory never allocates
+ * memory, and calling it is a single call through a function pointer (instead of going through std::function's type
+ * erasure).
+ * 
+ * A Factory object is only valid as long as the injector that it was obtained from.
+ */
+template <typename C, typename... Args>
+class Factory<C(Args...)> {
+public:
+  C operator()(Args... args) const;
+  
+protected:
+  using invoke_t = C(*)(void* state, Args... args);
+  
+  Factory(void* state, invoke_t invoke);
+  
+private:
+  // The non-assisted arguments of the factory, stored in the injector. This is NOT owned by the Factory object.
+  void* state;
+  
+  invoke_t invoke;
+};
+
+} // namespace fruit
+
+#include <fruit/impl/factory.defn.h>
+
+#endif // FRUIT_FACTORY_H
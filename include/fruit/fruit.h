@@ -26,9 +26,14 @@
 
 #include <fruit/fruit_forward_decls.h>
 #include <fruit/component.h>
+#include <fruit/factory.h>
 #include <fruit/normalized_component.h>
 #include <fruit/macro.h>
+#include <fruit/memory_resource.h>
+#include <fruit/multibindings_view.h>
 #include <fruit/injector.h>
+#include <fruit/leak_safe.h>
+#include <fruit/prepared_injector.h>
 #include <fruit/provider.h>
 
 #endif // FRUIT_FRUIT_H
@@ -47,12 +47,31 @@ class PartialComponent;
 template <typename... Types>
 class NormalizedComponent;
 
+struct NormalizedComponentOptions;
+
+struct BindingLookupStatistics;
+
 template <typename C>
 class Provider;
 
+// A lightweight alternative to std::function<Signature> for assisted injection. See the definition in factory.h.
+template <typename Signature>
+class Factory;
+
+template <typename C>
+class MultibindingsView;
+
+template <typename C>
+class LazyMultibindingsView;
+
 template <typename... P>
 class Injector;
 
+template <typename... P>
+class PreparedInjector;
+
+class MemoryResource;
+
 } // namespace fruit
 
 #endif // FRUIT_FRUIT_FORWARD_DECLS_H
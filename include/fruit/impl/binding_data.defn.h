@@ -24,14 +24,28 @@
 namespace fruit {
 namespace impl {
 
+// Provider<T> deps (possibly annotated) are lazy: T is only injected when the Provider's get() is called.
+template <typename T>
+struct IsLazyDep : public std::false_type {};
+
+template <typename T>
+struct IsLazyDep<fruit::Provider<T>> : public std::true_type {};
+
+template <typename Annotation, typename T>
+struct IsLazyDep<fruit::Annotated<Annotation, fruit::Provider<T>>> : public std::true_type {};
+
 template <typename L>
 struct GetBindingDepsHelper;
 
 template <typename... Ts>
 struct GetBindingDepsHelper<fruit::impl::meta::Vector<fruit::impl::meta::Type<Ts>...>> {
   inline const BindingDeps* operator()() {
-    static const TypeId types[] = {getTypeId<Ts>()..., TypeId{nullptr}};
-    static const BindingDeps deps = {types, sizeof...(Ts)};
+    static const TypeId types[] = {
+        getTypeId<fruit::impl::meta::UnwrapType<fruit::impl::meta::Eval<
+            fruit::impl::meta::NormalizeType(fruit::impl::meta::Type<Ts>)>>>()...,
+        TypeId{nullptr}};
+    static const bool is_lazy[] = {IsLazyDep<Ts>::value..., false};
+    static const BindingDeps deps = {types, sizeof...(Ts), is_lazy};
     return &deps;
   }
 };
@@ -41,7 +55,8 @@ template <>
 struct GetBindingDepsHelper<fruit::impl::meta::Vector<>> {
   inline const BindingDeps* operator()() {
     static const TypeId types[] = {TypeId{nullptr}};
-    static const BindingDeps deps = {types, 0};
+    static const bool is_lazy[] = {false};
+    static const BindingDeps deps = {types, 0, is_lazy};
     return &deps;
   }
 };
@@ -51,52 +66,62 @@ inline const BindingDeps* getBindingDeps() {
   return GetBindingDepsHelper<Deps>()();
 }
 
-inline BindingData::BindingData(create_t create, const BindingDeps* deps, bool needs_allocation)
-: deps_and_needs_allocation(deps, needs_allocation), p(reinterpret_cast<void*>(create)) {
+template <typename Deps, typename Create>
+inline const BindingData::CreateData* getCreateData(Create create) {
+  // Create is a captureless lambda, so there's one of these for each create operation.
+  static const BindingData::CreateData create_data = {create, getBindingDeps<Deps>()};
+  return &create_data;
+}
+
+inline BindingData::BindingData(const CreateData* create_data, bool needs_allocation)
+: create_data_and_needs_allocation(create_data, needs_allocation), object(nullptr) {
 }
   
 inline BindingData::BindingData(object_t object) 
-: deps_and_needs_allocation(nullptr, false), p(reinterpret_cast<void*>(object)) {
+: create_data_and_needs_allocation(nullptr, false), object(object) {
 }
 
 inline bool BindingData::isCreated() const {
-  return deps_and_needs_allocation.getPointer() == nullptr;
+  return create_data_and_needs_allocation.getPointer() == nullptr;
+}
+
+inline const BindingData::CreateData* BindingData::getCreateData() const {
+  FruitAssert(!isCreated());
+  return create_data_and_needs_allocation.getPointer();
 }
 
 inline const BindingDeps* BindingData::getDeps() const {
-  FruitAssert(deps_and_needs_allocation.getPointer() != nullptr);
-  return deps_and_needs_allocation.getPointer();
+  return getCreateData()->deps;
 }
 
 inline BindingData::create_t BindingData::getCreate() const {
-  FruitAssert(!isCreated());
-  return reinterpret_cast<create_t>(p);
+  return getCreateData()->create;
 }
 
 inline BindingData::object_t BindingData::getObject() const {
   FruitAssert(isCreated());
-  return reinterpret_cast<object_t>(p);
+  return object;
 }
 
 inline bool BindingData::needsAllocation() const {
-  return deps_and_needs_allocation.getBool();
+  return create_data_and_needs_allocation.getBool();
 }
 
 inline bool BindingData::operator==(const BindingData& other) const {
-  return std::tie(deps_and_needs_allocation, p)
-      == std::tie(other.deps_and_needs_allocation, other.p);
+  return std::tie(create_data_and_needs_allocation, object)
+      == std::tie(other.create_data_and_needs_allocation, other.object);
 }
 
 inline NormalizedBindingData::NormalizedBindingData(BindingData binding_data) {
   if (binding_data.isCreated()) {
     *this = NormalizedBindingData{binding_data.getObject()};
   } else {
-    *this = NormalizedBindingData{binding_data.getCreate()};
+    *this = NormalizedBindingData{binding_data.getCreateData()};
   }
 }
 
-inline NormalizedBindingData::NormalizedBindingData(BindingData::create_t create)
-: p(reinterpret_cast<void*>(create)) {
+inline NormalizedBindingData::NormalizedBindingData(const BindingData::CreateData* create_data)
+: p(const_cast<void*>(reinterpret_cast<const void*>(create_data))) {
 }
   
 inline NormalizedBindingData::NormalizedBindingData(BindingData::object_t object) 
@@ -104,13 +129,17 @@ inline NormalizedBindingData::NormalizedBindingData(BindingData::object_t object
 }
 
 inline BindingData::create_t NormalizedBindingData::getCreate() const {
-  return reinterpret_cast<BindingData::create_t>(p);
+  return reinterpret_cast<const BindingData::CreateData*>(p)->create;
 }
 
 inline BindingData::object_t NormalizedBindingData::getObject() const {
   return reinterpret_cast<BindingData::object_t>(p);
 }
 
+inline const BindingDeps* NormalizedBindingData::getDeps() const {
+  return reinterpret_cast<const BindingData::CreateData*>(p)->deps;
+}
+
 inline void NormalizedBindingData::create(InjectorStorage& storage,
                                           SemistaticGraph<TypeId, NormalizedBindingData>::node_iterator node_itr) {
   BindingData::object_t obj = getCreate()(storage, node_itr);
@@ -131,9 +160,14 @@ inline MultibindingData::MultibindingData(object_t object, get_multibindings_vec
   : object(object), get_multibindings_vector(get_multibindings_vector), needs_allocation(false) {
 }
 
-inline NormalizedMultibindingData::Elem::Elem(MultibindingData multibinding_data) {
+inline NormalizedMultibindingSet::Elem::Elem(MultibindingData multibinding_data) {
   create = multibinding_data.create;
   object = multibinding_data.object;
+  deps = multibinding_data.deps;
+}
+
+inline const NormalizedMultibindingData* NormalizedMultibindingSet::find(TypeId type) const {
+  return index.find(type);
 }
 
 
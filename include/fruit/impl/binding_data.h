@@ -18,8 +18,10 @@
 #define FRUIT_BINDING_DATA_H
 
 #include <fruit/impl/util/type_info.h>
+#include <fruit/impl/meta/component.h>
 #include <fruit/impl/data_structures/semistatic_graph.h>
 #include <fruit/impl/data_structures/packed_pointer_and_bool.h>
+#include <fruit/impl/data_structures/fixed_size_allocator.h>
 #include <vector>
 #include <memory>
 
@@ -37,14 +39,22 @@ class InjectorStorage;
 
 class NormalizedBindingData;
 
+struct NormalizedMultibindingData;
+
 struct BindingDeps {
   // A C-style array of deps
   const TypeId* deps;
   
   // The size of the above array.
   std::size_t num_deps;
+  
+  // A C-style array with num_deps elements. is_lazy[i] is true iff deps[i] is only injected as a Provider, so it doesn't
+  // have to be constructed before the object that depends on it.
+  const bool* is_lazy;
 };
 
+// Deps is a fruit::impl::meta::Vector of the (possibly non-normalized) types injected by a binding, e.g. Provider<Foo>,
+// const Bar& or Annotated<MyAnnotation, Baz*>.
 template <typename Deps>
 const BindingDeps* getBindingDeps();
 
@@ -56,32 +66,39 @@ public:
   using create_t = object_t(*)(InjectorStorage&,
                                SemistaticGraph<TypeId, NormalizedBindingData>::node_iterator);
   
+  // A create operation, with the type IDs that it injects directly.
+  // There's a single CreateData (with static storage duration) for each create operation (see getCreateData()), so
+  // bindings only store a pointer to it.
+  struct CreateData {
+    // The return type is a pointer to the constructed object (guaranteed to be !=nullptr).
+    create_t create;
+    
+    const BindingDeps* deps;
+  };
+  
 private:
-  // `deps' stores the type IDs that this type depends on.
-  // If `deps' itself is nullptr, this binding stores an object instead of a create operation.
+  // If `create_data' is nullptr, this binding stores an object instead of a create operation.
   // needs_allocation is false for e.g. bindings, instance bindings that don't need to allocate an object.
-  PackedPointerAndBool<const BindingDeps> deps_and_needs_allocation;
+  PackedPointerAndBool<const CreateData> create_data_and_needs_allocation;
   
-  // This stores either:
-  // 
-  // * create, of type create_t if deps!=nullptr
-  //   The return type is a pointer to the constructed object (guaranteed to be !=nullptr).
-  // 
-  // * object, of type object_t if deps==nullptr
-  //   The stored object, a casted T*.
-  void* p;
+  // The stored object (a casted T*) if `create_data' is nullptr. Otherwise this is nullptr.
+  object_t object;
   
 public:
   BindingData() = default;
   
   // Binding data for an object that is not already constructed.
-  BindingData(create_t create, const BindingDeps* deps, bool needs_allocation);
+  // create_data must have static storage duration.
+  BindingData(const CreateData* create_data, bool needs_allocation);
     
   // Binding data for an already constructed object.
   BindingData(object_t object);
   
   bool isCreated() const;
   
+  // This assumes !isCreated().
+  const CreateData* getCreateData() const;
+  
   // This assumes !isCreated().
   const BindingDeps* getDeps() const;
   
@@ -96,6 +113,11 @@ public:
   bool operator==(const BindingData& other) const;
 };
 
+// Returns the CreateData for `create' (a captureless lambda with the signature of create_t), whose direct deps are the
+// types in Deps (as for getBindingDeps()).
+template <typename Deps, typename Create>
+const BindingData::CreateData* getCreateData(Create create);
+
 // A CompressedBinding with interface_id==getTypeId<I>() and class_id==getTypeId<C>() means that if:
 // * C is not exposed by the component 
 // * I is the only node that depends on C
@@ -111,10 +133,10 @@ class NormalizedBindingData {
 private:
   // This stores either:
   // 
-  // * create, of type create_t if deps!=nullptr
-  //   The return type is a pointer to the constructed object (guaranteed to be !=nullptr).
+  // * create_data, of type const BindingData::CreateData*, if the graph node is NOT terminal.
+  //   This is replaced by the object when the object is constructed, so the deps are only available before that.
   // 
-  // * object, of type object_t if deps==nullptr
+  // * object, of type object_t, if the graph node is terminal.
   //   The stored object, a casted T*.
   void* p;
   
@@ -124,7 +146,7 @@ public:
   explicit NormalizedBindingData(BindingData binding_data);
   
   // Binding data for an object that is not already constructed.
-  NormalizedBindingData(BindingData::create_t create);
+  NormalizedBindingData(const BindingData::CreateData* create_data);
     
   // Binding data for an already constructed object.
   NormalizedBindingData(BindingData::object_t object);
@@ -135,19 +157,28 @@ public:
   // This assumes that the graph node is terminal (i.e. that there is an object in this BindingData).
   BindingData::object_t getObject() const;
   
+  // This assumes that the graph node is NOT terminal (i.e. that there is no object yet). In thread-safe mode, the caller
+  // must also ensure that no other thread is constructing the object, e.g. by locking the node.
+  const BindingDeps* getDeps() const;
+  
   // This assumes that the graph node is NOT terminal (i.e. that there is no object yet).
-  // This changes the graph node to terminal. Registers the destroy operation in InjectorStorage if needed.
+  // This does NOT change the graph node to terminal, the caller must do that after this returns (so that in thread-safe
+  // mode, the node is only marked as terminal once the object is stored here).
   void create(InjectorStorage& storage, 
               typename SemistaticGraph<TypeId, NormalizedBindingData>::node_iterator node_itr);
   
   bool operator==(const NormalizedBindingData& other) const;
 };
 
+// This is stored in every node of the injector's graph, so any per-node data that's only needed by some nodes (e.g. the
+// object offsets computed in computeObjectLayout) is stored in a side array indexed by node instead.
+static_assert(sizeof(NormalizedBindingData) == sizeof(void*), "NormalizedBindingData should be as small as a pointer");
+
 struct MultibindingData {
   using object_t = void*;
   using destroy_t = void(*)(void*);
   using create_t = object_t(*)(InjectorStorage&);
-  using get_multibindings_vector_t = std::shared_ptr<char>(*)(InjectorStorage&);
+  using get_multibindings_vector_t = std::shared_ptr<char>(*)(InjectorStorage&, const NormalizedMultibindingData&);
   
   MultibindingData(create_t create, const BindingDeps* deps, get_multibindings_vector_t get_multibindings_vector, 
                    bool needs_allocation);
@@ -163,39 +194,68 @@ struct MultibindingData {
   // If object==nullptr (i.e. create!=nullptr), the types that will be injected directly when `create' is called.
   const BindingDeps* deps = nullptr;
   
-  // Returns the std::vector<T*> of instances, or nullptr if none.
-  // Caches the result in the `v' member of NormalizedMultibindingData.
+  // Returns the std::vector<T*> of instances, caching it in the injector.
   get_multibindings_vector_t get_multibindings_vector;
 
   bool needs_allocation = true;
 };
 
+// The multibindings for a single type, in a NormalizedMultibindingSet.
+// This is trivially copyable, so that it can be stored in a SemistaticMap.
 struct NormalizedMultibindingData {
+  // The elements for this type are elems[elems_begin, elems_end) in the NormalizedMultibindingSet. This range is never
+  // empty.
+  std::size_t elems_begin;
+  std::size_t elems_end;
+  
+  // The index of this type in NormalizedMultibindingSet::types. An injector uses this to find its cached std::vector<T*>.
+  std::size_t type_index;
+  
+  // Returns the std::vector<T*> of instances, caching it in the injector.
+  MultibindingData::get_multibindings_vector_t get_multibindings_vector;
+};
+
+/**
+ * All the multibindings of a normalized component (or of an injector that adds multibindings to it). This is never modified
+ * after construction, so it can be shared by all the injectors created from the same NormalizedComponent; the objects
+ * constructed by each injector are stored in the injector instead (see InjectorStorage::multibinding_objects).
+ * The elements of each type are contiguous in `elems', so looking up the multibindings of a type only takes a single
+ * SemistaticMap lookup.
+ */
+struct NormalizedMultibindingSet {
   
   struct Elem {
     explicit Elem(MultibindingData multibinding_data);
     
-    // This is nullptr if the object is already constructed.
+    // This is nullptr for instance multibindings.
     MultibindingData::create_t create = nullptr;
     
-    // This is nullptr if the object hasn't been constructed yet.
+    // The object of an instance multibinding, or nullptr if the object has to be constructed with `create'.
     MultibindingData::object_t object = nullptr;
+    
+    // The types injected directly by `create' (nullptr for instance multibindings).
+    const BindingDeps* deps = nullptr;
   };
   
-  // Can be empty, but only if v is present and non-empty.
+  // The elements of all types, grouped by type.
   std::vector<Elem> elems;
   
-  // TODO: Check this comment.
-  // Returns the std::vector<T*> of instances, or nullptr if none.
-  // Caches the result in the `v' member.
-  MultibindingData::get_multibindings_vector_t get_multibindings_vector;
+  // The types that have at least one multibinding, with their data.
+  std::vector<std::pair<TypeId, NormalizedMultibindingData>> types;
+  
+  // An index on `types'.
+  SemistaticMap<TypeId, NormalizedMultibindingData> index;
   
-  // A (casted) pointer to the std::vector<T*> of objects, or nullptr if the vector hasn't been constructed yet.
-  // Can't be empty.
-  std::shared_ptr<char> v;
+  // Creates an empty set.
+  NormalizedMultibindingSet();
+  
+  NormalizedMultibindingSet(NormalizedMultibindingSet&&) = default;
+  NormalizedMultibindingSet& operator=(NormalizedMultibindingSet&&) = default;
+  
+  // Returns nullptr if there are no multibindings for `type'.
+  const NormalizedMultibindingData* find(TypeId type) const;
 };
 
-
 } // namespace impl
 } // namespace fruit
 
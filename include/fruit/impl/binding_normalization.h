@@ -39,24 +39,77 @@ struct BindingNormalization {
     BindingData iBinding;
     BindingData cBinding;
   };
-  // Stores an element of the form (cTypeId, (iTypeId, iBinding, cBinding)) for each binding compression that was performed.
+  // Stores an element of the form (cTypeId, (iTypeId, iBinding, cBinding)) for each binding compression that was performed,
+  // sorted by cTypeId. Use findBindingCompressionInfo() to look up an element.
   // These are used to undo binding compression after applying it (if necessary).
-  using BindingCompressionInfoMap = HashMap<TypeId, BindingCompressionInfo>;
+  using BindingCompressionInfoMap = std::vector<std::pair<TypeId, BindingCompressionInfo>>;
+  
+  // Statistics on the bindings removed by normalizeBindings() because they were unreachable.
+  struct PruningStatistics {
+    // The number of removed bindings.
+    std::size_t num_pruned_bindings = 0;
+    
+    // The number of bytes that won't be allocated (in each injector) for the removed bindings.
+    std::size_t num_pruned_bytes = 0;
+  };
+  
+  // Returns the BindingCompressionInfo for cTypeId in the map, or nullptr if there's none.
+  static const BindingCompressionInfo* findBindingCompressionInfo(const BindingCompressionInfoMap& bindingCompressionInfoMap,
+                                                                  TypeId cTypeId);
   
   // bindingCompressionInfoMap is an output parameter. This function will store
   // information on all performed binding compressions
   // in that map, to allow them to be undone later, if necessary.
+  // The bindings are normalized by sorting them by TypeId and then merging/filtering the sorted vectors, so this only
+  // performs a constant number of allocations (excluding the ones in fixed_size_allocator_data).
+  // If num_threads>1, the bindings are partitioned into shards by the hash of their TypeId, and the shards are sorted and
+  // checked for inconsistent bindings in parallel. If num_threads is 0, the number of hardware threads is used.
+  // If pruning_statistics is not nullptr, the bindings that are not reachable from exposed_types or from the multibindings
+  // are removed (and not added to fixed_size_allocator_data), and the number of removed bindings is stored there.
   static std::vector<std::pair<TypeId, BindingData>> normalizeBindings(
       const std::vector<std::pair<TypeId, BindingData>>& bindings_vector,
       FixedSizeAllocator::FixedSizeAllocatorData& fixed_size_allocator_data,
       std::vector<CompressedBinding>&& compressed_bindings_vector,
       const std::vector<std::pair<TypeId, MultibindingData>>& multibindings,
       const std::vector<TypeId>& exposed_types,
-      BindingCompressionInfoMap& bindingCompressionInfoMap);
+      BindingCompressionInfoMap& bindingCompressionInfoMap,
+      std::size_t num_threads = 1,
+      PruningStatistics* pruning_statistics = nullptr);
 
-  static void addMultibindings(std::unordered_map<TypeId, NormalizedMultibindingData>& multibindings,
-                               FixedSizeAllocator::FixedSizeAllocatorData& fixed_size_allocator_data,
-                               const std::vector<std::pair<TypeId, MultibindingData>>& multibindings_vector);
+  // Returns the types in normalized_bindings whose object can be constructed once and shared by all the injectors created
+  // from the normalized component: the bindings (other than instance bindings) that only depend (directly or indirectly)
+  // on instance bindings of the normalized component. A binding is never request-independent if it depends on a type
+  // that is not bound in normalized_bindings (i.e. on a requirement that will be bound by each injector), on a
+  // Provider (since the Provider would refer to a specific injector) or if it's the I type of a binding compression
+  // (since the compression might be undone in some injectors).
+  // The types are returned in the same order as in normalized_bindings.
+  static std::vector<TypeId> findRequestIndependentBindings(
+      const std::vector<std::pair<TypeId, BindingData>>& normalized_bindings,
+      const BindingCompressionInfoMap& bindingCompressionInfoMap);
+  
+  // Assigns a fixed offset in the injectors' FixedSizeAllocator to each binding in `bindings' that allocates an object,
+  // moving that object from the bump-allocated area of fixed_size_allocator_data to its fixed layout.
+  // object_offsets[bindings.indexOf(node_itr)] is set to the offset of the object of node_itr, or to
+  // InjectorStorage::no_object_offset if the object is not in the fixed layout. The offsets are stored in this side array (instead of in the nodes) to keep
+  // the graph nodes small.
+  // The objects of terminal nodes in `bindings' that are not instance bindings in normalized_bindings (i.e. hoisted
+  // request-independent bindings) are already constructed, so they're removed from fixed_size_allocator_data instead.
+  // normalized_bindings and bindingCompressionInfoMap must be the ones used to construct `bindings'.
+  // The objects are sorted by decreasing alignment (so that no space is wasted for padding) and then by the position of
+  // their node in `bindings', so that objects used together are close in memory if `bindings' has the DEPENDENCY_ORDER
+  // layout.
+  static void computeObjectLayout(const std::vector<std::pair<TypeId, BindingData>>& normalized_bindings,
+                                  const BindingCompressionInfoMap& bindingCompressionInfoMap,
+                                  SemistaticGraph<TypeId, NormalizedBindingData>& bindings,
+                                  FixedSizeAllocator::FixedSizeAllocatorData& fixed_size_allocator_data,
+                                  std::vector<std::uint32_t>& object_offsets);
+  
+  // Returns a set with the multibindings in `multibindings' and the ones in multibindings_vector. The new multibindings of
+  // each type come after the ones already in `multibindings', in the order in which they were added. The new multibindings
+  // are also added to fixed_size_allocator_data.
+  static NormalizedMultibindingSet addMultibindings(const NormalizedMultibindingSet& multibindings,
+                                                    FixedSizeAllocator::FixedSizeAllocatorData& fixed_size_allocator_data,
+                                                    const std::vector<std::pair<TypeId, MultibindingData>>& multibindings_vector);
   
 };
 
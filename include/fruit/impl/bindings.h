@@ -109,6 +109,12 @@ struct AddMultibindingProvider<AnnotatedSignature, Lambda> {};
 template <typename DecoratedSignature, typename Lambda>
 struct RegisterFactory {};
 
+/**
+ * Same as RegisterFactory, but binds the corresponding fruit::Factory instead of the std::function.
+ */
+template <typename DecoratedSignature, typename Lambda>
+struct RegisterFruitFactory {};
+
 /**
  * Adds the bindings (and multibindings) in `component' to the current component.
  * OtherComponent must be of the form Component<...>.
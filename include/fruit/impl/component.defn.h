@@ -212,6 +212,16 @@ PartialComponent<Bindings...>::registerFactory(Lambda) {
 
   return {{storage}};
 }
+  
+template <typename... Bindings>
+template <typename DecoratedSignature, typename Lambda>
+inline PartialComponent<fruit::impl::RegisterFruitFactory<DecoratedSignature, Lambda>, Bindings...>
+PartialComponent<Bindings...>::registerFruitFactory(Lambda) {
+  using Op = OpFor<fruit::impl::RegisterFruitFactory<DecoratedSignature, Lambda>>;
+  (void)typename fruit::impl::meta::CheckIfError<Op>::type();
+
+  return {{storage}};
+}
 
 template <typename... Bindings>
 inline PartialComponent<Bindings...>::PartialComponent(fruit::impl::PartialComponentStorage<Bindings...> storage)
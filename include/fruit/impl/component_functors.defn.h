@@ -18,6 +18,7 @@
 #define FRUIT_COMPONENT_FUNCTORS_DEFN_H
 
 #include <fruit/component.h>
+#include <fruit/factory.h>
 
 #include <fruit/impl/injection_errors.h>
 #include <fruit/impl/injection_debug_errors.h>
@@ -346,6 +347,8 @@ struct RegisterFactoryHelper {
   template <typename Comp,
             typename DecoratedSignature,
             typename Lambda,
+            // Bool<true> to bind fruit::Factory<InjectedSignature>, Bool<false> to bind std::function<InjectedSignature>.
+            typename AsFruitFactory,
             // std::function<InjectedSignature> is the injected type (possibly with an Annotation<> wrapping it)
             typename InjectedSignature,
             typename RequiredLambdaSignature,
@@ -355,10 +358,10 @@ struct RegisterFactoryHelper {
             typename IndexSequence>
   struct apply;
   
-  template <typename Comp, typename DecoratedSignature, typename Lambda, typename NakedC, 
+  template <typename Comp, typename DecoratedSignature, typename Lambda, typename AsFruitFactory, typename NakedC, 
       typename... NakedUserProvidedArgs, typename... NakedAllArgs, typename... InjectedAnnotatedArgs,
       typename... NakedInjectedArgs, typename... Indexes>
-  struct apply<Comp, DecoratedSignature, Lambda, Type<NakedC(NakedUserProvidedArgs...)>,
+  struct apply<Comp, DecoratedSignature, Lambda, AsFruitFactory, Type<NakedC(NakedUserProvidedArgs...)>,
                Type<NakedC(NakedAllArgs...)>, Vector<InjectedAnnotatedArgs...>,
                Vector<Type<NakedInjectedArgs>...>, Vector<Indexes...>> {
     // Here we call "decorated" the types that might be wrapped in Annotated<> or Assisted<>,
@@ -369,11 +372,58 @@ struct RegisterFactoryHelper {
     using NakedInjectedSignature = NakedC(NakedUserProvidedArgs...);
     using NakedRequiredSignature = NakedC(NakedAllArgs...);
     using NakedFunctor = std::function<NakedInjectedSignature>;
-    // This is usually the same as Functor, but this might be annotated.
+    using NakedFactory = fruit::Factory<NakedInjectedSignature>;
+    // These are usually the same as NakedFunctor/NakedFactory, but they might be annotated.
     using AnnotatedFunctor = CopyAnnotation(AnnotatedT, Type<NakedFunctor>);
+    using AnnotatedFactory = CopyAnnotation(AnnotatedT, Type<NakedFactory>);
     using FunctorDeps = NormalizeTypeVector(Vector<InjectedAnnotatedArgs...>);
-    using R = AddProvidedType(Comp, AnnotatedFunctor, FunctorDeps);
-    struct Op {
+    using R = If(AsFruitFactory,
+                 AddProvidedType(Comp, AnnotatedFactory, FunctorDeps),
+                 AddProvidedType(Comp, AnnotatedFunctor, FunctorDeps));
+    
+    // Calls Lambda with the injected args and the user-provided params.
+    static NakedC invoke(std::tuple<NakedInjectedArgs...>& injected_args, NakedUserProvidedArgs... params) {
+      auto user_provided_args = std::tie(params...);
+      // These are unused if they are 0-arg tuples. Silence the unused-variable warnings anyway.
+      (void) injected_args;
+      (void) user_provided_args;
+      
+      return LambdaInvoker::invoke<UnwrapType<Lambda>, NakedAllArgs...>(
+          GetAssistedArg<
+            Eval<NumAssistedBefore(Indexes, DecoratedArgs)>::value,
+            Indexes::value - Eval<NumAssistedBefore(Indexes, DecoratedArgs)>::value,
+            // Note that the Assisted<> wrapper (if any) remains, we just remove any wrapping Annotated<>.
+            UnwrapType<Eval<RemoveAnnotations(GetNthType(Indexes, DecoratedArgs))>>
+          >()(injected_args, user_provided_args)...);
+    }
+    
+    // The object bound to AnnotatedFactory. This stores the injected args, and the Factory base points to them, so that
+    // Factory objects copied from this one can call the lambda without storing the args themselves.
+    struct FactoryImpl : public NakedFactory {
+      std::tuple<NakedInjectedArgs...> injected_args;
+      
+      explicit FactoryImpl(NakedInjectedArgs... args)
+        : NakedFactory(&injected_args, &invokeFactory), injected_args(args...) {
+      }
+      
+      // The Factory base must point to the args of this object, not to the ones of `other'.
+      FactoryImpl(const FactoryImpl& other)
+        : NakedFactory(&injected_args, &invokeFactory), injected_args(other.injected_args) {
+      }
+      
+      FactoryImpl(FactoryImpl&& other)
+        : NakedFactory(&injected_args, &invokeFactory), injected_args(std::move(other.injected_args)) {
+      }
+      
+      FactoryImpl& operator=(const FactoryImpl&) = delete;
+      FactoryImpl& operator=(FactoryImpl&&) = delete;
+      
+      static NakedC invokeFactory(void* state, NakedUserProvidedArgs... params) {
+        return invoke(*static_cast<std::tuple<NakedInjectedArgs...>*>(state), std::forward<NakedUserProvidedArgs>(params)...);
+      }
+    };
+    
+    struct FunctorOp {
       using Result = Eval<R>;
       void operator()(ComponentStorage& storage) {
         auto function_provider = [](NakedInjectedArgs... args) {
@@ -381,19 +431,8 @@ struct RegisterFactoryHelper {
           // Check this on later versions and consider filing a bug.
           std::tuple<NakedInjectedArgs...> injected_args(args...);
           auto object_provider = [injected_args](NakedUserProvidedArgs... params) mutable {
-            auto user_provided_args = std::tie(params...);
-			// These are unused if they are 0-arg tuples. Silence the unused-variable warnings anyway.
-			(void) injected_args;
-			(void) user_provided_args;
-
-			return LambdaInvoker::invoke<UnwrapType<Lambda>, NakedAllArgs...>(
-				GetAssistedArg<
-				  Eval<NumAssistedBefore(Indexes, DecoratedArgs)>::value,
-				  Indexes::value - Eval<NumAssistedBefore(Indexes, DecoratedArgs)>::value,
-				  // Note that the Assisted<> wrapper (if any) remains, we just remove any wrapping Annotated<>.
-				  UnwrapType<Eval<RemoveAnnotations(GetNthType(Indexes, DecoratedArgs))>>
-				>()(injected_args, user_provided_args)...);
-		  };
+            return invoke(injected_args, std::forward<NakedUserProvidedArgs>(params)...);
+          };
           return NakedFunctor(object_provider);
         };
         storage.addBinding(InjectorStorage::createBindingDataForProvider<
@@ -401,6 +440,20 @@ struct RegisterFactoryHelper {
             decltype(function_provider)>());
       }
     };
+    
+    struct FactoryOp {
+      using Result = Eval<R>;
+      void operator()(ComponentStorage& storage) {
+        // AnnotatedFactory is bound to FactoryImpl, that is not exposed (it can't be, it's not even nameable outside).
+        auto factory_provider = [](NakedInjectedArgs... args) {
+          return FactoryImpl(args...);
+        };
+        storage.addBinding(InjectorStorage::createBindingDataForProvider<
+            UnwrapType<Eval<ConsSignatureWithVector(Type<FactoryImpl>, Vector<InjectedAnnotatedArgs...>)>>,
+            decltype(factory_provider)>());
+        storage.addBinding(InjectorStorage::createBindingDataForBind<UnwrapType<Eval<AnnotatedFactory>>, FactoryImpl>());
+      }
+    };
     // The first two IsValidSignature checks are a bit of a hack, they are needed to make the F2/RealF2 split
     // work in the caller (we need to allow Lambda to be a function type).
     using type = If(Not(Or(IsEmpty(Lambda), IsValidSignature(Lambda))),
@@ -412,12 +465,15 @@ struct RegisterFactoryHelper {
                  If(IsPointer(T),
                     ConstructError(FactoryReturningPointerErrorTag, DecoratedSignature),
                  PropagateError(R,
-                 Op)))));
+                 If(AsFruitFactory, FactoryOp, FunctorOp))))));
   };
 };
 
+// Registers Lambda as a factory, binding std::function<...> if AsFruitFactory is Bool<false> or fruit::Factory<...> if
+// it's Bool<true>. The fruit::Factory is only bound when it's explicitly registered (with registerFruitFactory()) or
+// when it's needed and auto-registered, so components that only use the std::function don't pay for it.
 struct RegisterFactory {
-  template <typename Comp, typename DecoratedSignature, typename Lambda>
+  template <typename Comp, typename DecoratedSignature, typename Lambda, typename AsFruitFactory = Bool<false>>
   struct apply {
     using type = If(Not(IsValidSignature(DecoratedSignature)),
                     ConstructError(NotASignatureErrorTag, DecoratedSignature),
@@ -428,6 +484,7 @@ struct RegisterFactory {
                  RegisterFactoryHelper(Comp,
                                        DecoratedSignature,
                                        Lambda,
+                                       AsFruitFactory,
                                        InjectedSignatureForAssistedFactory(DecoratedSignature),
                                        RequiredLambdaSignatureForAssistedFactory(DecoratedSignature),
                                        RemoveAssisted(SignatureArgs(DecoratedSignature)),
@@ -531,21 +588,23 @@ struct RegisterInstance {
 struct RegisterConstructorAsValueFactory {
   template<typename Comp, 
            typename DecoratedSignature, 
+           // See RegisterFactory.
+           typename AsFruitFactory = Bool<false>,
            typename RequiredSignature = 
                Eval<RequiredLambdaSignatureForAssistedFactory(DecoratedSignature)>>
   struct apply;
   
-  template <typename Comp, typename DecoratedSignature, typename NakedT, typename... NakedArgs>
-  struct apply<Comp, DecoratedSignature, Type<NakedT(NakedArgs...)>> {
+  template <typename Comp, typename DecoratedSignature, typename AsFruitFactory, typename NakedT, typename... NakedArgs>
+  struct apply<Comp, DecoratedSignature, AsFruitFactory, Type<NakedT(NakedArgs...)>> {
     using RequiredSignature = Type<NakedT(NakedArgs...)>;
-    using Op1 = RegisterFactory(Comp, DecoratedSignature, RequiredSignature);
+    using Op1 = RegisterFactory(Comp, DecoratedSignature, RequiredSignature, AsFruitFactory);
     struct Op {
       using Result = Eval<GetResult(Op1)>;
       void operator()(ComponentStorage& storage) {
         auto provider = [](NakedArgs... args) {
           return NakedT(std::forward<NakedArgs>(args)...);
         };
-        using RealOp = RegisterFactory(Comp, DecoratedSignature, Type<decltype(provider)>);
+        using RealOp = RegisterFactory(Comp, DecoratedSignature, Type<decltype(provider)>, AsFruitFactory);
         FruitStaticAssert(IsSame(GetResult(Op1),
                                  GetResult(RealOp)));
         Eval<RealOp>()(storage);
@@ -560,21 +619,23 @@ struct RegisterConstructorAsValueFactory {
 struct RegisterConstructorAsUniquePtrFactory {
   template<typename Comp, 
            typename DecoratedSignature, 
+           // See RegisterFactory.
+           typename AsFruitFactory = Bool<false>,
            typename RequiredSignature = 
                Eval<RequiredLambdaSignatureForAssistedFactory(DecoratedSignature)>>
   struct apply;
   
-  template <typename Comp, typename DecoratedSignature, typename NakedT, typename... NakedArgs>
-  struct apply<Comp, DecoratedSignature, Type<std::unique_ptr<NakedT>(NakedArgs...)>> {
+  template <typename Comp, typename DecoratedSignature, typename AsFruitFactory, typename NakedT, typename... NakedArgs>
+  struct apply<Comp, DecoratedSignature, AsFruitFactory, Type<std::unique_ptr<NakedT>(NakedArgs...)>> {
     using RequiredSignature = Type<std::unique_ptr<NakedT>(NakedArgs...)>;
-    using Op1 = RegisterFactory(Comp, DecoratedSignature, RequiredSignature);
+    using Op1 = RegisterFactory(Comp, DecoratedSignature, RequiredSignature, AsFruitFactory);
     struct Op {
       using Result = Eval<GetResult(Op1)>;
       void operator()(ComponentStorage& storage) {
         auto provider = [](NakedArgs... args) {
           return std::unique_ptr<NakedT>(new NakedT(std::forward<NakedArgs>(args)...));
         };
-        using RealOp = RegisterFactory(Comp, DecoratedSignature, Type<decltype(provider)>);
+        using RealOp = RegisterFactory(Comp, DecoratedSignature, Type<decltype(provider)>, AsFruitFactory);
         FruitStaticAssert(IsSame(GetResult(Op1),
                                  GetResult(RealOp)));
         Eval<RealOp>()(storage);
@@ -864,6 +925,52 @@ struct AutoRegisterFactoryHelper {
   };
 };
 
+// Auto-registers the fruit::Factory for AnnotatedSignature (as RegisterConstructorAs*Factory with AsFruitFactory=Bool<true>).
+// C must have an Inject typedef.
+struct AutoRegisterFruitFactoryHelper {
+  template <typename Comp, typename TargetRequirements, typename C, typename AnnotatedSignature>
+  struct apply;
+  
+  // unique_ptr case.
+  template <typename Comp, typename TargetRequirements, typename NakedC, typename AnnotatedSignature>
+  struct apply<Comp, TargetRequirements, Type<std::unique_ptr<NakedC>>, AnnotatedSignature> {
+    using AnnotatedCUniquePtr = SignatureType(AnnotatedSignature);
+    using AnnotatedC = CopyAnnotation(AnnotatedCUniquePtr, RemoveUniquePtr(RemoveAnnotations(AnnotatedCUniquePtr)));
+    using DecoratedSignatureReturningValue = GetInjectAnnotation(AnnotatedC);
+    using DecoratedSignature = ConsSignatureWithVector(AnnotatedCUniquePtr,
+                                                       SignatureArgs(DecoratedSignatureReturningValue));
+    using DecoratedSignatureArgs = SignatureArgs(DecoratedSignature);
+    using ActualSignatureInInjectionTypedef = ConsSignatureWithVector(SignatureType(DecoratedSignature),
+                                                                      RemoveNonAssisted(DecoratedSignatureArgs));
+    using NonAssistedArgs = RemoveAssisted(DecoratedSignatureArgs);
+    
+    using F1 = ComponentFunctor(RegisterConstructorAsUniquePtrFactory, DecoratedSignature, Bool<true>);
+    using F2 = ComponentFunctor(EnsureProvidedTypes, TargetRequirements, ExpandProvidersInParams(NonAssistedArgs));
+    
+    using type = If(Not(IsSame(AnnotatedSignature, ActualSignatureInInjectionTypedef)),
+                    ConstructError(FunctorSignatureDoesNotMatchErrorTag, AnnotatedSignature, ActualSignatureInInjectionTypedef),
+                 Call(ComposeFunctors(F1, F2), Comp));
+  };
+  
+  // Value (not unique_ptr) case.
+  template <typename Comp, typename TargetRequirements, typename NakedC, typename AnnotatedSignature>
+  struct apply<Comp, TargetRequirements, Type<NakedC>, AnnotatedSignature> {
+    using AnnotatedC = SignatureType(AnnotatedSignature);
+    using DecoratedSignature = GetInjectAnnotation(AnnotatedC);
+    using DecoratedSignatureArgs = SignatureArgs(DecoratedSignature);
+    using ActualSignatureInInjectionTypedef = ConsSignatureWithVector(SignatureType(DecoratedSignature),
+                                                                      RemoveNonAssisted(DecoratedSignatureArgs));
+    using NonAssistedArgs = RemoveAssisted(DecoratedSignatureArgs);
+    
+    using F1 = ComponentFunctor(RegisterConstructorAsValueFactory, DecoratedSignature, Bool<true>);
+    using F2 = ComponentFunctor(EnsureProvidedTypes, TargetRequirements, ExpandProvidersInParams(NonAssistedArgs));
+    
+    using type = If(Not(IsSame(AnnotatedSignature, ActualSignatureInInjectionTypedef)),
+                    ConstructError(FunctorSignatureDoesNotMatchErrorTag, AnnotatedSignature, ActualSignatureInInjectionTypedef),
+                 Call(ComposeFunctors(F1, F2), Comp));
+  };
+};
+
 struct AutoRegisterHelper {
 
   template <typename Comp, typename TargetRequirements, typename has_inject_annotation, typename AnnotatedC>
@@ -953,6 +1060,51 @@ struct AutoRegister {
                                            Type<fruit::Annotated<Annotation, std::unique_ptr<NakedC>>(NakedArgs...)>,
                                            Id<RemoveAnnotations(Type<NakedArgs>)>...);
   };
+  
+  // A fruit::Factory can only be auto-registered if C has an Inject typedef. Unlike for std::function, there's no
+  // fallback to a factory for an interface bound to C or to a unique_ptr factory built from a value factory.
+  template <typename Comp, typename TargetRequirements, typename NakedC, typename... NakedArgs>
+  struct apply<Comp, TargetRequirements, Type<fruit::Factory<NakedC(NakedArgs...)>>> {
+    using type = If(HasInjectAnnotation(Type<NakedC>),
+                    AutoRegisterFruitFactoryHelper(Comp,
+                                                   TargetRequirements,
+                                                   Type<NakedC>,
+                                                   Type<NakedC(NakedArgs...)>),
+                 ConstructNoBindingFoundError(Type<fruit::Factory<NakedC(NakedArgs...)>>));
+  };
+  
+  template <typename Comp, typename TargetRequirements, typename NakedC, typename... NakedArgs>
+  struct apply<Comp, TargetRequirements, Type<fruit::Factory<std::unique_ptr<NakedC>(NakedArgs...)>>> {
+    using type = If(HasInjectAnnotation(Type<NakedC>),
+                    AutoRegisterFruitFactoryHelper(Comp,
+                                                   TargetRequirements,
+                                                   Type<std::unique_ptr<NakedC>>,
+                                                   Type<std::unique_ptr<NakedC>(NakedArgs...)>),
+                 ConstructNoBindingFoundError(Type<fruit::Factory<std::unique_ptr<NakedC>(NakedArgs...)>>));
+  };
+  
+  template <typename Comp, typename TargetRequirements, typename Annotation, typename NakedC, typename... NakedArgs>
+  struct apply<Comp, TargetRequirements, 
+               Type<fruit::Annotated<Annotation, fruit::Factory<NakedC(NakedArgs...)>>>> {
+    using type = If(HasInjectAnnotation(Type<NakedC>),
+                    AutoRegisterFruitFactoryHelper(Comp,
+                                                   TargetRequirements,
+                                                   Type<NakedC>,
+                                                   Type<fruit::Annotated<Annotation, NakedC>(NakedArgs...)>),
+                 ConstructNoBindingFoundError(Type<fruit::Annotated<Annotation, fruit::Factory<NakedC(NakedArgs...)>>>));
+  };
+  
+  template <typename Comp, typename TargetRequirements, typename Annotation, typename NakedC, typename... NakedArgs>
+  struct apply<Comp, TargetRequirements, 
+               Type<fruit::Annotated<Annotation, fruit::Factory<std::unique_ptr<NakedC>(NakedArgs...)>>>> {
+    using type = If(HasInjectAnnotation(Type<NakedC>),
+                    AutoRegisterFruitFactoryHelper(Comp,
+                                                   TargetRequirements,
+                                                   Type<std::unique_ptr<NakedC>>,
+                                                   Type<fruit::Annotated<Annotation, std::unique_ptr<NakedC>>(NakedArgs...)>),
+                 ConstructNoBindingFoundError(
+                     Type<fruit::Annotated<Annotation, fruit::Factory<std::unique_ptr<NakedC>(NakedArgs...)>>>));
+  };
 };
 
 struct EnsureProvidedTypeHelper {
@@ -1071,6 +1223,11 @@ struct ProcessBinding {
     using type = ComponentFunctor(RegisterFactory, Type<DecoratedSignature>, Type<Lambda>);
   };
 
+  template <typename DecoratedSignature, typename Lambda>
+  struct apply<fruit::impl::RegisterFruitFactory<DecoratedSignature, Lambda>> {
+    using type = ComponentFunctor(RegisterFactory, Type<DecoratedSignature>, Type<Lambda>, Bool<true>);
+  };
+
   template <typename... Params>
   struct apply<fruit::impl::InstallComponent<fruit::Component<Params...>>> {
     using type = ComponentFunctor(InstallComponentHelper, Type<Params>...);
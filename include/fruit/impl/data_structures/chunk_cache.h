@@ -0,0 +1,85 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef FRUIT_CHUNK_CACHE_H
+#define FRUIT_CHUNK_CACHE_H
+
+#include <fruit/memory_resource.h>
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace fruit {
+namespace impl {
+
+/**
+ * A MemoryResource that keeps the chunks deallocated from it (up to a limit) and returns them from later allocate() calls
+ * with the same size, instead of going back to operator new/delete every time.
+ * This is used for the FixedSizeAllocator chunks (and on_destruction vectors) of the injectors created from the same
+ * NormalizedComponent, that all have the same sizes.
+ * 
+ * The cached chunks are split in shards, and each thread uses its own shard (unless there are more threads than shards),
+ * so threads that create and destroy injectors concurrently usually don't contend on the same lock.
+ * allocate() and deallocate() can be called concurrently.
+ */
+class ChunkCache : public MemoryResource {
+private:
+  static constexpr std::size_t num_shards = 8;
+  
+  // Chunks deallocated when the current thread's shard already has this many chunks are freed with operator delete.
+  static constexpr std::size_t max_chunks_per_shard = 8;
+  
+  struct Shard {
+    std::mutex mutex;
+    
+    // The cached chunks, as (size, pointer) pairs.
+    std::vector<std::pair<std::size_t, void*>> chunks;
+  };
+  
+  Shard shards[num_shards];
+  
+  std::atomic<std::size_t> num_hits{0};
+  std::atomic<std::size_t> num_misses{0};
+  
+  // Returns the shard of the current thread.
+  Shard& getShard();
+  
+public:
+  ChunkCache() = default;
+  
+  ChunkCache(const ChunkCache&) = delete;
+  ChunkCache& operator=(const ChunkCache&) = delete;
+  
+  // Frees all the cached chunks. All the chunks allocated from this object must have been deallocated already.
+  ~ChunkCache();
+  
+  void* allocate(std::size_t size, std::size_t alignment) override;
+  
+  void deallocate(void* p, std::size_t size, std::size_t alignment) override;
+  
+  // The number of allocate() calls that returned a cached chunk.
+  std::size_t getNumHits() const;
+  
+  // The number of allocate() calls that had to allocate a new chunk with operator new.
+  std::size_t getNumMisses() const;
+};
+
+} // namespace impl
+} // namespace fruit
+
+#endif // FRUIT_CHUNK_CACHE_H
@@ -18,7 +18,9 @@
 #define FRUIT_FIXED_SIZE_ALLOTATOR_DEFN_H
 
 #include <fruit/impl/fruit_assert.h>
+#include <fruit/leak_safe.h>
 
+#include <algorithm>
 #include <cassert>
 
 #ifdef FRUIT_EXTRA_DEBUG
@@ -32,15 +34,28 @@ namespace fruit {
 namespace impl {
 
 template <typename C>
-void FixedSizeAllocator::destroyObject(void* p) {
-  C* cPtr = reinterpret_cast<C*>(p);
-  cPtr->C::~C();
+void FixedSizeAllocator::destroyObjects(DestructionEntry* begin, DestructionEntry* end, bool fast_exit) {
+  if (fast_exit && fruit::IsLeakSafe<C>::value) {
+    return;
+  }
+  // The destructor call is not indirect here, so it can be inlined.
+  while (end != begin) {
+    --end;
+    C* cPtr = reinterpret_cast<C*>(end->p);
+    cPtr->C::~C();
+  }
 }
 
 template <typename C>
-void FixedSizeAllocator::destroyExternalObject(void* p) {
-  C* cPtr = reinterpret_cast<C*>(p);
-  delete cPtr;
+void FixedSizeAllocator::destroyExternalObjects(DestructionEntry* begin, DestructionEntry* end, bool fast_exit) {
+  if (fast_exit && fruit::IsLeakSafe<C>::value) {
+    return;
+  }
+  while (end != begin) {
+    --end;
+    C* cPtr = reinterpret_cast<C*>(end->p);
+    delete cPtr;
+  }
 }
 
 inline void FixedSizeAllocator::FixedSizeAllocatorData::addType(TypeId typeId) {
@@ -70,6 +85,25 @@ inline void FixedSizeAllocator::FixedSizeAllocatorData::addExternallyAllocatedTy
   num_types_to_destroy++;
 }
 
+inline std::size_t FixedSizeAllocator::FixedSizeAllocatorData::addTypeAtFixedOffset(TypeId typeId) {
+#ifdef FRUIT_EXTRA_DEBUG
+  types[typeId]++;
+#endif
+  if (!typeId.type_info->isTriviallyDestructible()) {
+    num_types_to_destroy++;
+  }
+  std::size_t alignment = typeId.type_info->alignment();
+  std::size_t offset = (fixed_layout_size + alignment - 1) / alignment * alignment;
+  fixed_layout_size = offset + typeId.type_info->size();
+  fixed_layout_alignment = std::max(fixed_layout_alignment, alignment);
+  return offset;
+}
+
+inline std::size_t FixedSizeAllocator::FixedSizeAllocatorData::getAllocatedSize() const {
+  return fixed_layout_alignment - 1 + fixed_layout_size + total_size
+      + num_types_to_destroy * sizeof(DestructionEntry);
+}
+
 inline std::size_t FixedSizeAllocator::FixedSizeAllocatorData::maximumRequiredSpace(TypeId type) {
   return type.type_info->alignment() + type.type_info->size() - 1;
 }
@@ -77,18 +111,48 @@ inline std::size_t FixedSizeAllocator::FixedSizeAllocatorData::maximumRequiredSp
 template <typename AnnotatedT, typename... Args>
 inline fruit::impl::meta::UnwrapType<fruit::impl::meta::Eval<fruit::impl::meta::RemoveAnnotations(fruit::impl::meta::Type<AnnotatedT>)>>* 
 FixedSizeAllocator::constructObject(Args&&... args) {
+  return constructObjectAt<AnnotatedT, Args...>(no_object_offset, std::forward<Args>(args)...);
+}
+
+template <typename AnnotatedT, typename... Args>
+inline fruit::impl::meta::UnwrapType<fruit::impl::meta::Eval<fruit::impl::meta::RemoveAnnotations(fruit::impl::meta::Type<AnnotatedT>)>>* 
+FixedSizeAllocator::constructObjectAt(std::size_t object_offset, Args&&... args) {
   using T = fruit::impl::meta::UnwrapType<fruit::impl::meta::Eval<fruit::impl::meta::RemoveAnnotations(fruit::impl::meta::Type<AnnotatedT>)>>;
   
-  char* p = storage_last_used;
-  size_t misalignment = std::uintptr_t(p) % alignof(T);
+  char* p;
+  if (object_offset != no_object_offset) {
+    // The position of the object was determined at normalization time, so there's no alignment arithmetic to do here
+    // (and nothing to synchronize in thread-safe mode).
+    p = fixed_layout_begin + object_offset;
+    FruitAssert(p + sizeof(T) <= fixed_layout_end);
+#ifdef FRUIT_EXTRA_DEBUG
+    if (!thread_safe) {
+      FruitAssert(remaining_types[getTypeId<AnnotatedT>()] != 0);
+      remaining_types[getTypeId<AnnotatedT>()]--;
+    }
+#endif
+  } else if (thread_safe) {
+    // The bump pointer is shared with other threads, so we reserve the space with a CAS loop instead.
+    static_assert(sizeof(std::atomic<char*>) == sizeof(char*), "std::atomic<char*> has a different size than char*");
+    std::atomic<char*>& atomic_storage_last_used = *reinterpret_cast<std::atomic<char*>*>(&storage_last_used);
+    char* last_used = atomic_storage_last_used.load(std::memory_order_relaxed);
+    do {
+      p = last_used + alignof(T) - std::uintptr_t(last_used) % alignof(T);
+    } while (!atomic_storage_last_used.compare_exchange_weak(last_used, p + sizeof(T) - 1, std::memory_order_relaxed));
+  } else {
+    p = storage_last_used;
+    size_t misalignment = std::uintptr_t(p) % alignof(T);
 #ifdef FRUIT_EXTRA_DEBUG
-  FruitAssert(remaining_types[getTypeId<AnnotatedT>()] != 0);
-  remaining_types[getTypeId<AnnotatedT>()]--;
+    // This bookkeeping is not thread-safe, so it's skipped in thread-safe mode.
+    FruitAssert(remaining_types[getTypeId<AnnotatedT>()] != 0);
+    remaining_types[getTypeId<AnnotatedT>()]--;
 #endif
-  p += alignof(T) - misalignment;
+    p += alignof(T) - misalignment;
+    storage_last_used = p + sizeof(T) - 1;
+  }
   FruitAssert(std::uintptr_t(p) % alignof(T) == 0);
+  FruitAssert(p + sizeof(T) <= storage_begin + storage_size);
   T* x = reinterpret_cast<T*>(p);
-  storage_last_used = p + sizeof(T) - 1;
   
   // This runs arbitrary code (T's constructor), which might end up calling
   // constructObject recursively. We must make sure all invariants are satisfied before
@@ -98,24 +162,38 @@ FixedSizeAllocator::constructObject(Args&&... args) {
   // We still run this later though, since if T's constructor throws we don't want to
   // destruct this object in FixedSizeAllocator's destructor.
   if (!std::is_trivially_destructible<T>::value) {
-    on_destruction.push_back(
-        std::pair<destroy_t, void*>{destroyObject<T>, x});
+    if (thread_safe) {
+      on_destruction.concurrent_push_back(DestructionEntry{destroyObjects<T>, x});
+    } else {
+      on_destruction.push_back(DestructionEntry{destroyObjects<T>, x});
+    }
   }
   return x;
 }
 
 template <typename T>
 inline void FixedSizeAllocator::registerExternallyAllocatedObject(T* p) {
-  on_destruction.push_back(std::pair<destroy_t, void*>{destroyExternalObject<T>, p});
+  if (thread_safe) {
+    on_destruction.concurrent_push_back(DestructionEntry{destroyExternalObjects<T>, p});
+  } else {
+    on_destruction.push_back(DestructionEntry{destroyExternalObjects<T>, p});
+  }
 }
 
-inline FixedSizeAllocator::FixedSizeAllocator(FixedSizeAllocatorData allocator_data)
-  : on_destruction(allocator_data.num_types_to_destroy) {
-  // The +1 is because we waste the first byte (storage_last_used points to the beginning of storage).
-  storage_begin = new char[allocator_data.total_size + 1];
-  storage_last_used = storage_begin;
+inline FixedSizeAllocator::FixedSizeAllocator(FixedSizeAllocatorData allocator_data, MemoryResource* memory_resource)
+  : memory_resource(memory_resource),
+    on_destruction(memory_resource, allocator_data.num_types_to_destroy) {
+  // The +1 is because we waste the first byte (storage_last_used points to the last used byte, so it starts before the
+  // area for the objects that are not in the fixed layout).
+  std::size_t alignment = allocator_data.fixed_layout_alignment;
+  storage_size = 1 + alignment - 1 + allocator_data.fixed_layout_size + allocator_data.total_size;
+  storage_begin = static_cast<char*>(allocateMemory(memory_resource, storage_size, 1));
+  fixed_layout_begin = storage_begin + 1 + (alignment - (std::uintptr_t(storage_begin) + 1) % alignment) % alignment;
+  fixed_layout_end = fixed_layout_begin + allocator_data.fixed_layout_size;
+  storage_last_used = fixed_layout_end - 1;
 #ifdef FRUIT_EXTRA_DEBUG
   remaining_types = allocator_data.types;
+  types = allocator_data.types;
   std::cerr << "Constructing allocator for types:";
   for (auto x : remaining_types) {
     std::cerr << " " << x.first;
@@ -127,19 +205,33 @@ inline FixedSizeAllocator::FixedSizeAllocator(FixedSizeAllocatorData allocator_d
 inline FixedSizeAllocator::FixedSizeAllocator(FixedSizeAllocator&& x)
   : FixedSizeAllocator() {
   std::swap(storage_begin, x.storage_begin);
+  std::swap(storage_size, x.storage_size);
+  std::swap(memory_resource, x.memory_resource);
   std::swap(storage_last_used, x.storage_last_used);
+  std::swap(fixed_layout_begin, x.fixed_layout_begin);
+  std::swap(fixed_layout_end, x.fixed_layout_end);
+  std::swap(thread_safe, x.thread_safe);
+  std::swap(fast_exit, x.fast_exit);
   std::swap(on_destruction, x.on_destruction);
 #ifdef FRUIT_EXTRA_DEBUG
   std::swap(remaining_types, x.remaining_types);
+  std::swap(types, x.types);
 #endif
 }
 
 inline FixedSizeAllocator& FixedSizeAllocator::operator=(FixedSizeAllocator&& x) {
   std::swap(storage_begin, x.storage_begin);
+  std::swap(storage_size, x.storage_size);
+  std::swap(memory_resource, x.memory_resource);
   std::swap(storage_last_used, x.storage_last_used);
+  std::swap(fixed_layout_begin, x.fixed_layout_begin);
+  std::swap(fixed_layout_end, x.fixed_layout_end);
+  std::swap(thread_safe, x.thread_safe);
+  std::swap(fast_exit, x.fast_exit);
   std::swap(on_destruction, x.on_destruction);
 #ifdef FRUIT_EXTRA_DEBUG
   std::swap(remaining_types, x.remaining_types);
+  std::swap(types, x.types);
 #endif
   return *this;
 }
@@ -21,6 +21,8 @@
 #include <fruit/impl/data_structures/fixed_size_vector.h>
 #include <fruit/impl/meta/component.h>
 
+#include <atomic>
+
 #ifdef FRUIT_EXTRA_DEBUG
 #include <unordered_map>
 #endif
@@ -33,38 +35,78 @@ namespace impl {
  */
 class FixedSizeAllocator {
 public:
-  using destroy_t = void(*)(void*);  
+  struct DestructionEntry;
+  
+  // Destroys the objects in [begin, end) (in reverse order), that all have the destroy operation of the entry's type.
+  // If fast_exit is true, this does nothing for the types marked as leak-safe (see fruit::IsLeakSafe).
+  using destroy_t = void(*)(DestructionEntry* begin, DestructionEntry* end, bool fast_exit);
+  
+  struct DestructionEntry {
+    destroy_t destroy;
+    void* p;
+  };
+  
+  // Used as object offset for the objects that are not in the fixed layout, see constructObjectAt().
+  static constexpr std::size_t no_object_offset = ~std::size_t(0);
   
 private:
   // A pointer to the last used byte in the allocated memory chunk starting at storage_begin.
+  // The objects that are not in the fixed layout are allocated after fixed_layout_end by bumping this pointer.
   char* storage_last_used = nullptr;
   
   // The chunk of memory that will be used for all allocations.
   char* storage_begin = nullptr;
+  std::size_t storage_size = 0;
+  
+  // The resource where the chunk (and on_destruction) were allocated, or nullptr if they were allocated with operator new.
+  MemoryResource* memory_resource = nullptr;
+  
+  // The objects in the fixed layout are constructed at fixed offsets from fixed_layout_begin. This is aligned to the
+  // maximum alignment of these objects.
+  char* fixed_layout_begin = nullptr;
+  char* fixed_layout_end = nullptr;
+  
+  // If this is true, constructObject() and registerExternallyAllocatedObject() can be called concurrently.
+  bool thread_safe = false;
+  
+  // If this is true, the leak-safe objects are not destroyed in the destructor, see enableFastExit().
+  bool fast_exit = false;
   
 #ifdef FRUIT_EXTRA_DEBUG
    std::unordered_map<TypeId, std::size_t> remaining_types;
+   
+   // The types in the FixedSizeAllocatorData used to construct this object. Used to restore remaining_types in reset().
+   std::unordered_map<TypeId, std::size_t> types;
 #endif
   
   // This vector contains the destroy operations that have to be performed at destruction, and
   // the pointers that they must be invoked with. Allows destruction in the correct order.
-  // These must be called in reverse order.
-  FixedSizeVector<std::pair<destroy_t, void*>> on_destruction;
+  // These must be called in reverse order. Consecutive entries with the same destroy operation are destroyed with a
+  // single call, see destroyAll().
+  FixedSizeVector<DestructionEntry> on_destruction;
   
-  // Destroys an object previously created using constructObject().
+  // Destroys objects previously created using constructObject().
   template <typename C>
-  static void destroyObject(void* p);
+  static void destroyObjects(DestructionEntry* begin, DestructionEntry* end, bool fast_exit);
   
-  // Calls delete on an object previously allocated using new.
+  // Calls delete on objects previously allocated using new.
   template <typename C>
-  static void destroyExternalObject(void* p);
+  static void destroyExternalObjects(DestructionEntry* begin, DestructionEntry* end, bool fast_exit);
+  
+  // Destroys the objects in on_destruction, in reverse order, and clears it.
+  void destroyAll(bool fast_exit);
   
 public:
   // Data used to construct an allocator for a fixed set of types.
   class FixedSizeAllocatorData {
   private:
+    // The space reserved for the objects that are not in the fixed layout.
     std::size_t total_size = 0;
     std::size_t num_types_to_destroy = 0;
+    
+    // The size and the alignment of the fixed layout (see addTypeAtFixedOffset()).
+    std::size_t fixed_layout_size = 0;
+    std::size_t fixed_layout_alignment = 1;
 #ifdef FRUIT_EXTRA_DEBUG
     std::unordered_map<TypeId, std::size_t> types;
 #endif
@@ -84,13 +126,23 @@ public:
     // Each call to this method with getTypeId<T>() allows 1 registerExternallyAllocatedType<T>(...) call on the resulting
     // allocator.
     void addExternallyAllocatedType(TypeId typeId);
+    
+    // Like addType(), but the object will be constructed at a fixed offset in the allocator's storage (the returned
+    // value), with constructObjectAt(). No space is wasted for alignment if the types are added in order of decreasing
+    // alignment, since the size of a type is always a multiple of its alignment.
+    std::size_t addTypeAtFixedOffset(TypeId typeId);
+    
+    // Returns the number of bytes that a FixedSizeAllocator constructed with this data will allocate (for the objects and
+    // for the destroy operations).
+    std::size_t getAllocatedSize() const;
   };
   
   // Constructs an empty allocator (no allocations are allowed).
   FixedSizeAllocator() = default;
   
   // Constructs an allocator for the type set in FixedSizeAllocatorData.
-  FixedSizeAllocator(FixedSizeAllocatorData allocator_data);
+  // If memory_resource is not nullptr, the memory is allocated from it.
+  FixedSizeAllocator(FixedSizeAllocatorData allocator_data, MemoryResource* memory_resource = nullptr);
   
   FixedSizeAllocator(FixedSizeAllocator&&);
   FixedSizeAllocator& operator=(FixedSizeAllocator&&);
@@ -107,8 +159,27 @@ public:
   template <typename AnnotatedT, typename... Args>
   fruit::impl::meta::UnwrapType<fruit::impl::meta::Eval<fruit::impl::meta::RemoveAnnotations(fruit::impl::meta::Type<AnnotatedT>)>>* constructObject(Args&&... args);
   
+  // Same as constructObject(), but the object is constructed at the specified offset, as returned by
+  // FixedSizeAllocatorData::addTypeAtFixedOffset(). If object_offset is no_object_offset, this is equivalent to
+  // constructObject().
+  template <typename AnnotatedT, typename... Args>
+  fruit::impl::meta::UnwrapType<fruit::impl::meta::Eval<fruit::impl::meta::RemoveAnnotations(fruit::impl::meta::Type<AnnotatedT>)>>* constructObjectAt(std::size_t object_offset, Args&&... args);
+  
   template <typename T>
   void registerExternallyAllocatedObject(T* p);
+  
+  // Destroys all objects allocated with constructObject() and all externally-allocated objects registered with
+  // registerExternallyAllocatedObject() (in reverse order), and then makes the allocated memory available again.
+  // After this call, the allocator can be used as if it was just constructed, but no memory is allocated or freed.
+  void reset();
+  
+  // After this call, constructObject() and registerExternallyAllocatedObject() can be called concurrently from multiple
+  // threads. This must be called before the allocator is shared between threads.
+  void enableThreadSafety();
+  
+  // After this call, the destructor doesn't destroy the objects of the types T with fruit::IsLeakSafe<T>::value==true.
+  // The other objects are still destroyed in reverse order. This doesn't affect reset().
+  void enableFastExit();
 };
 
 } // namespace impl
@@ -20,7 +20,9 @@
 #include <fruit/impl/data_structures/fixed_size_vector.h>
 
 #include <fruit/impl/fruit_assert.h>
+#include <fruit/impl/util/memory_resource_allocator.h>
 
+#include <atomic>
 #include <utility>
 #include <cassert>
 #include <cstring>
@@ -29,22 +31,28 @@ namespace fruit {
 namespace impl {
 
 template <typename T>
-inline FixedSizeVector<T>::FixedSizeVector(std::size_t capacity) {
+inline FixedSizeVector<T>::FixedSizeVector(std::size_t capacity)
+  : FixedSizeVector(nullptr, capacity) {
+}
+
+template <typename T>
+inline FixedSizeVector<T>::FixedSizeVector(MemoryResource* memory_resource, std::size_t capacity)
+  : memory_resource(memory_resource) {
   if (capacity == 0) {
     v_begin = 0;
   } else {
-    v_begin = reinterpret_cast<T*>(operator new(sizeof(T) * capacity));
+    v_begin = reinterpret_cast<T*>(allocateMemory(memory_resource, sizeof(T) * capacity, alignof(T)));
   }
   v_end = v_begin;
-#ifdef FRUIT_EXTRA_DEBUG
   v_end_of_storage = v_begin + capacity;
-#endif
 }
 
 template <typename T>
 inline FixedSizeVector<T>::~FixedSizeVector() {
   clear();
-  operator delete(v_begin);
+  if (v_begin != nullptr) {
+    deallocateMemory(memory_resource, v_begin, sizeof(T) * (v_end_of_storage - v_begin), alignof(T));
+  }
 }
 
 template <typename T>
@@ -80,21 +88,24 @@ template <typename T>
 inline void FixedSizeVector<T>::swap(FixedSizeVector& x) {
   std::swap(v_end, x.v_end);
   std::swap(v_begin, x.v_begin); 
-#ifdef FRUIT_EXTRA_DEBUG
   std::swap(v_end_of_storage, x.v_end_of_storage);
-#endif
+  std::swap(memory_resource, x.memory_resource);
 }
 
 template <typename T>
 inline void FixedSizeVector<T>::push_back(T x) {
-#ifdef FRUIT_EXTRA_DEBUG
   FruitAssert(v_end != v_end_of_storage);
-#endif
   new (v_end) T(x);
   ++v_end;
-#ifdef FRUIT_EXTRA_DEBUG
   FruitAssert(v_end <= v_end_of_storage);
-#endif
+}
+
+template <typename T>
+inline void FixedSizeVector<T>::concurrent_push_back(T x) {
+  static_assert(sizeof(std::atomic<T*>) == sizeof(T*), "std::atomic<T*> has a different size than T*");
+  T* p = reinterpret_cast<std::atomic<T*>*>(&v_end)->fetch_add(1, std::memory_order_relaxed);
+  FruitAssert(p < v_end_of_storage);
+  new (p) T(x);
 }
 
 // This method is covered by tests, even though lcov doesn't detect that.
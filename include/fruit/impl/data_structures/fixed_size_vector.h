@@ -17,6 +17,8 @@
 #ifndef FRUIT_FIXED_SIZE_VECTOR_H
 #define FRUIT_FIXED_SIZE_VECTOR_H
 
+#include <fruit/memory_resource.h>
+
 #include <cstdlib>
 
 namespace fruit {
@@ -25,6 +27,7 @@ namespace impl {
 /**
  * Similar to std::vector<T>, but the capacity is fixed at construction time, and no reallocations ever happen.
  * The type T must be trivially copyable.
+ * The storage is allocated from a MemoryResource if one is specified at construction, or with operator new otherwise.
  */
 template <typename T>
 class FixedSizeVector {
@@ -35,9 +38,10 @@ private:
   // v_end is before v_begin here, because it's the most commonly accessed field.
   T* v_end;
   T* v_begin;
-#ifdef FRUIT_EXTRA_DEBUG
   T* v_end_of_storage;
-#endif
+  
+  // The resource where the storage was allocated, or nullptr if it was allocated with operator new.
+  MemoryResource* memory_resource;
   
 public:
   using iterator = T*;
@@ -46,11 +50,16 @@ public:
   FixedSizeVector(std::size_t capacity = 0);
   // Creates a vector with the specified size (and equal capacity) initialized with the specified value.
   FixedSizeVector(std::size_t size, const T& value);
+  
+  // Same as the constructors above, but the storage is allocated from `memory_resource' (unless it's nullptr).
+  FixedSizeVector(MemoryResource* memory_resource, std::size_t capacity);
+  FixedSizeVector(MemoryResource* memory_resource, std::size_t size, const T& value);
   ~FixedSizeVector();
   
   // Copy construction is not allowed, you need to specify the capacity in order to construct the copy.
   FixedSizeVector(const FixedSizeVector& other) = delete;
   FixedSizeVector(const FixedSizeVector& other, std::size_t capacity);
+  FixedSizeVector(MemoryResource* memory_resource, const FixedSizeVector& other, std::size_t capacity);
   
   FixedSizeVector(FixedSizeVector&& other);
   
@@ -65,6 +74,10 @@ public:
   // This yields undefined behavior (instead of reallocating) if the vector's capacity is exceeded.
   void push_back(T x);
   
+  // Like push_back(), but multiple threads can call this concurrently (as long as no other method is called concurrently).
+  // The relative order of concurrently-added elements is unspecified.
+  void concurrent_push_back(T x);
+  
   void swap(FixedSizeVector& x);
   
   // Removes all elements, so size() becomes 0 (but maintains the capacity).
@@ -30,7 +30,13 @@ namespace impl {
 
 template <typename T>
 FixedSizeVector<T>::FixedSizeVector(const FixedSizeVector& other, std::size_t capacity)
-  : FixedSizeVector(capacity) {
+  : FixedSizeVector(nullptr, other, capacity) {
+}
+
+template <typename T>
+FixedSizeVector<T>::FixedSizeVector(MemoryResource* memory_resource, const FixedSizeVector& other,
+                                    std::size_t capacity)
+  : FixedSizeVector(memory_resource, capacity) {
   FruitAssert(other.size() <= capacity);
   // This is not just an optimization, we also want to make sure that other.capacity (and therefore
   // also this.capacity) is >0, or we'd pass nullptr to memcpy (although with a size of 0).
@@ -44,7 +50,12 @@ FixedSizeVector<T>::FixedSizeVector(const FixedSizeVector& other, std::size_t ca
 
 template <typename T>
 FixedSizeVector<T>::FixedSizeVector(std::size_t size, const T& value)
-  : FixedSizeVector(size) {
+  : FixedSizeVector(nullptr, size, value) {
+}
+
+template <typename T>
+FixedSizeVector<T>::FixedSizeVector(MemoryResource* memory_resource, std::size_t size, const T& value)
+  : FixedSizeVector(memory_resource, size) {
   for (std::size_t i = 0; i < size; ++i) {
     push_back(value);
   }
@@ -53,6 +53,57 @@ inline void SemistaticGraph<NodeId, Node>::node_iterator::setTerminal() {
   itr->edges_begin = 0;
 }
 
+template <typename NodeId, typename Node>
+inline void SemistaticGraph<NodeId, Node>::node_iterator::setNonTerminal(edge_iterator neighbors_begin) {
+  FruitAssert(itr->edges_begin == 0);
+  itr->edges_begin = reinterpret_cast<std::uintptr_t>(neighbors_begin.itr);
+}
+
+template <typename NodeId, typename Node>
+inline std::atomic<std::uintptr_t>& SemistaticGraph<NodeId, Node>::node_iterator::atomicEdgesBegin() {
+  // NodeData must stay trivially copyable, so edges_begin can't be a std::atomic. This relies on std::atomic<uintptr_t>
+  // having the same representation as uintptr_t, which is the case on all supported platforms.
+  static_assert(sizeof(std::atomic<std::uintptr_t>) == sizeof(std::uintptr_t),
+                "std::atomic<std::uintptr_t> has a different size than std::uintptr_t");
+  return *reinterpret_cast<std::atomic<std::uintptr_t>*>(&itr->edges_begin);
+}
+
+template <typename NodeId, typename Node>
+inline bool SemistaticGraph<NodeId, Node>::node_iterator::isTerminalAcquire() {
+  return atomicEdgesBegin().load(std::memory_order_acquire) == 0;
+}
+
+template <typename NodeId, typename Node>
+inline bool SemistaticGraph<NodeId, Node>::node_iterator::tryLock() {
+  std::uintptr_t edges_begin = atomicEdgesBegin().load(std::memory_order_relaxed);
+  FruitAssert(edges_begin != 1);
+  if (edges_begin == 0 || (edges_begin & 1) != 0) {
+    return false;
+  }
+  return atomicEdgesBegin().compare_exchange_strong(edges_begin, edges_begin | 1, std::memory_order_acquire);
+}
+
+template <typename NodeId, typename Node>
+inline bool SemistaticGraph<NodeId, Node>::node_iterator::isLocked() {
+  std::uintptr_t edges_begin = atomicEdgesBegin().load(std::memory_order_relaxed);
+  FruitAssert(edges_begin != 1);
+  return (edges_begin & 1) != 0;
+}
+
+template <typename NodeId, typename Node>
+inline void SemistaticGraph<NodeId, Node>::node_iterator::unlock() {
+  std::uintptr_t edges_begin = atomicEdgesBegin().load(std::memory_order_relaxed);
+  FruitAssert(edges_begin != 1);
+  FruitAssert((edges_begin & 1) != 0);
+  atomicEdgesBegin().store(edges_begin & ~std::uintptr_t(1), std::memory_order_release);
+}
+
+template <typename NodeId, typename Node>
+inline void SemistaticGraph<NodeId, Node>::node_iterator::setTerminalAndUnlock() {
+  FruitAssert(isLocked());
+  atomicEdgesBegin().store(0, std::memory_order_release);
+}
+
 template <typename NodeId, typename Node>
 inline bool SemistaticGraph<NodeId, Node>::node_iterator::operator==(const node_iterator& other) const {
   return itr == other.itr;
@@ -85,7 +136,7 @@ template <typename NodeId, typename Node>
 inline typename SemistaticGraph<NodeId, Node>::edge_iterator SemistaticGraph<NodeId, Node>::node_iterator::neighborsBegin() {
   FruitAssert(itr->edges_begin != 0);
   FruitAssert(itr->edges_begin != 1);
-  return edge_iterator{reinterpret_cast<InternalNodeId*>(itr->edges_begin)};
+  return edge_iterator{reinterpret_cast<InternalNodeId*>(itr->edges_begin & ~std::uintptr_t(1))};
 }
 
 template <typename NodeId, typename Node>
@@ -132,6 +183,19 @@ inline typename SemistaticGraph<NodeId, Node>::node_iterator SemistaticGraph<Nod
   return node_iterator{nodeAtId(internalNodeId)};
 }
 
+template <typename NodeId, typename Node>
+inline typename SemistaticGraph<NodeId, Node>::node_iterator SemistaticGraph<NodeId, Node>::atDenseIndex(
+    std::size_t dense_index, NodeId nodeId) {
+  if (dense_index < dense_index_map_size) {
+    InternalNodeId internalNodeId = dense_index_map[dense_index];
+    if (internalNodeId.id != missing_dense_index_entry) {
+      FruitAssert(internalNodeId == node_index_map.at(nodeId));
+      return node_iterator{nodeAtId(internalNodeId)};
+    }
+  }
+  return at(nodeId);
+}
+
 template <typename NodeId, typename Node>
 inline typename SemistaticGraph<NodeId, Node>::const_node_iterator SemistaticGraph<NodeId, Node>::find(NodeId nodeId) const {
   const InternalNodeId* internalNodeIdPtr = node_index_map.find(nodeId);
@@ -160,6 +224,16 @@ inline typename SemistaticGraph<NodeId, Node>::node_iterator SemistaticGraph<Nod
   }
 }
 
+template <typename NodeId, typename Node>
+inline std::size_t SemistaticGraph<NodeId, Node>::size() const {
+  return nodes.size();
+}
+
+template <typename NodeId, typename Node>
+inline std::size_t SemistaticGraph<NodeId, Node>::indexOf(node_iterator itr) const {
+  return itr.itr - nodes.data();
+}
+
 template <typename NodeId, typename Node>
 inline typename SemistaticGraph<NodeId, Node>::NodeData* SemistaticGraph<NodeId, Node>::nodeAtId(InternalNodeId internalNodeId) {
   return nodeAtId(nodes.data(), internalNodeId);
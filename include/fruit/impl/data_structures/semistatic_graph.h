@@ -19,6 +19,8 @@
 
 #include <fruit/impl/data_structures/semistatic_map.h>
 
+#include <atomic>
+
 #ifdef FRUIT_EXTRA_DEBUG
 #include <iostream>
 #endif
@@ -27,14 +29,21 @@ namespace fruit {
 namespace impl {
 
 // The alignas ensures that a SemistaticGraphInternalNodeId* always has 0 in the low-order bit.
-struct alignas(2) alignas(alignof(std::size_t)) SemistaticGraphInternalNodeId {
+struct alignas(2) alignas(alignof(std::uint32_t)) SemistaticGraphInternalNodeId {
   // This stores the index in the vector times sizeof(NodeData).
-  std::size_t id;
+  // This is 32-bit to halve the size of edges and of the node index map (compared to a std::size_t), so graphs can have
+  // at most max_id/sizeof(NodeData) nodes.
+  std::uint32_t id;
+  
+  static constexpr std::uint32_t max_id = ~std::uint32_t(0);
   
   bool operator==(const SemistaticGraphInternalNodeId& x) const;
   bool operator<(const SemistaticGraphInternalNodeId& x) const;
 };
 
+static_assert(sizeof(SemistaticGraphInternalNodeId) == sizeof(std::uint32_t),
+              "Unexpected padding in SemistaticGraphInternalNodeId.");
+
 /**
  * A direct graph implementation where most of the graph is fixed at construction time, but a few nodes and edges can be added
  * later.
@@ -68,7 +77,8 @@ private:
   public:
     // If edges_begin==0, this is a terminal node.
     // If edges_begin==1, this node doesn't exist, it's just referenced by another node.
-    // Otherwise, reinterpret_cast<InternalNodeId*>(edges_begin) is the beginning of the edges range.
+    // Otherwise, reinterpret_cast<InternalNodeId*>(edges_begin & ~1) is the beginning of the edges range, and the low-order
+    // bit is 1 iff the node is locked (see node_iterator::tryLock()).
     std::uintptr_t edges_begin;
   
   // An explicit "public" specifier here prevents the compiler from reordering the fields.
@@ -79,6 +89,9 @@ private:
   
   std::size_t first_unused_index;
   
+  // The resource where the vectors below are allocated (or nullptr to use operator new).
+  MemoryResource* memory_resource = nullptr;
+  
   FixedSizeVector<NodeData> nodes;
   
   // Stores vectors of edges as contiguous chunks of node IDs.
@@ -86,11 +99,32 @@ private:
   // The first element is unused.
   FixedSizeVector<InternalNodeId> edges_storage;
   
+  // An optional alternative to node_index_map, see buildDenseIndex(). If dense_index_map_size!=0, the node with dense
+  // index i (if any) is nodes[dense_index_map[i]/sizeof(NodeData)]. Missing entries have id==missing_dense_index_entry.
+  // dense_index_map points to dense_index_map_storage, but it might be either the one of this object or the one of an
+  // object that was shallow-copied into this one.
+  static constexpr std::uint32_t missing_dense_index_entry = InternalNodeId::max_id;
+  const InternalNodeId* dense_index_map = nullptr;
+  std::size_t dense_index_map_size = 0;
+  FixedSizeVector<InternalNodeId> dense_index_map_storage;
+  
 #ifdef FRUIT_EXTRA_DEBUG
   template <typename NodeIter>
   void printGraph(NodeIter first, NodeIter last);
 #endif
   
+  // Appends to node_ids the IDs of all nodes (including those that are only neighbors of other nodes) in DFS pre-order,
+  // i.e. each node comes before the nodes reachable from it that weren't visited yet. Also appends to node_iters the
+  // iterators of the nodes in [first, last), in the same order.
+  template <typename NodeIter>
+  static void computeDependencyOrder(NodeIter first, NodeIter last, std::vector<NodeId>& node_ids,
+                                     std::vector<NodeIter>& node_iters);
+  
+  // Node IDs are 32-bit, so a graph can't have more than max_id/sizeof(NodeData) nodes. Since exceeding that would
+  // silently truncate the IDs, this is checked in release builds too: if num_nodes is too big, this reports an error and
+  // calls exit(1).
+  static void checkNumNodes(std::size_t num_nodes);
+  
   NodeData* nodeAtId(InternalNodeId internalNodeId);
   const NodeData* nodeAtId(InternalNodeId internalNodeId) const;
   
@@ -116,12 +150,38 @@ public:
     
     // Turns the node into a terminal node, also removing all the deps.
     void setTerminal();
+    
+    // Turns a terminal node back into a non-terminal one, with the neighbors starting at neighbors_begin.
+    // neighbors_begin must be the value returned by neighborsBegin() before the node was made terminal.
+    void setNonTerminal(edge_iterator neighbors_begin);
   
     // Assumes !isTerminal().
     // neighborsEnd() is NOT provided/stored for efficiency, the client code is expected to know the number of neighbors.
     edge_iterator neighborsBegin();
     
+    // The following methods can be used when the node is accessed concurrently by multiple threads. In that case, all
+    // accesses to the node's terminal/locked state must use these methods (and not isTerminal() or setTerminal()).
+    
+    // Like isTerminal(), but with acquire semantics: if this returns true, all writes to the node done before the
+    // corresponding setTerminalAndUnlock() are visible to the caller.
+    bool isTerminalAcquire();
+    
+    // Atomically locks the node, if it's non-terminal and not already locked. Returns true iff the node was locked by
+    // this call.
+    bool tryLock();
+    
+    bool isLocked();
+    
+    // Unlocks a node locked with tryLock(), leaving it non-terminal.
+    void unlock();
+    
+    // Turns a node locked with tryLock() into a terminal node (that is then no longer locked), with release semantics.
+    void setTerminalAndUnlock();
+    
     bool operator==(const node_iterator&) const;
+    
+  private:
+    std::atomic<std::uintptr_t>& atomicEdgesBegin();
   };
   
   class const_node_iterator {
@@ -160,6 +220,16 @@ public:
     node_iterator getNodeIterator(std::size_t i, node_iterator nodes_begin);
   };
   
+  // The order of the nodes (and of their edges) in memory.
+  enum class Layout {
+    // An unspecified order.
+    UNSPECIFIED,
+    // Each node is stored right before the nodes reachable from it (except for nodes already reachable from a previous
+    // node), in the order in which a recursive visit would first reach them. This is the order in which cascaded
+    // construction in an injector touches the nodes, so a subtree of nodes occupies consecutive cache lines.
+    DEPENDENCY_ORDER,
+  };
+  
   // Constructs an *invalid* graph (as if this graph was just moved from).
   SemistaticGraph() = default;
   
@@ -171,8 +241,11 @@ public:
   // 
   // This constructor is *not* defined in semistatic_graph.templates.h, but only in semistatic_graph.cc.
   // All instantiations must have a matching instantiation in semistatic_graph.cc.
+  // If num_threads>1, the nodes and edges are stored using that many threads.
+  // If memory_resource is not nullptr, the graph's storage is allocated from it.
   template <typename NodeIter>
-  SemistaticGraph(NodeIter first, NodeIter last);
+  SemistaticGraph(NodeIter first, NodeIter last, Layout layout = Layout::UNSPECIFIED, std::size_t num_threads = 1,
+                  MemoryResource* memory_resource = nullptr);
   
   SemistaticGraph(SemistaticGraph&&) = default;
   SemistaticGraph(const SemistaticGraph&) = delete;
@@ -182,8 +255,12 @@ public:
   // The nodes in [first, last) must NOT be already in x, but can be neighbors of nodes in x.
   // The new graph will share data with `x', so must be destroyed before `x' is destroyed.
   // Also, after this is called, `x' must not be modified until this object has been destroyed.
+  // max_bucketed_elems is passed to the SemistaticMap that maps node IDs to nodes, see the corresponding SemistaticMap
+  // constructor.
   template <typename NodeIter>
-  SemistaticGraph(const SemistaticGraph& x, NodeIter first, NodeIter last);
+  SemistaticGraph(const SemistaticGraph& x, NodeIter first, NodeIter last,
+                  std::size_t max_bucketed_elems = SemistaticMap<NodeId, InternalNodeId>::default_max_bucketed_elems,
+                  MemoryResource* memory_resource = nullptr);
   
   ~SemistaticGraph();
   
@@ -205,6 +282,27 @@ public:
   node_iterator find(NodeId nodeId);
   const_node_iterator find(NodeId nodeId) const;
   
+  // Builds a dense index of the nodes in [first, last) (that must be the nodes passed to the constructor), so that they can
+  // be looked up with atDenseIndex() without hashing. get_dense_index(nodeId) must return a small integer, different for
+  // each NodeId.
+  // Graphs created later as copies of this one will share the dense index (that only contains the nodes of this graph).
+  template <typename NodeIter, typename GetDenseIndex>
+  void buildDenseIndex(NodeIter first, NodeIter last, GetDenseIndex get_dense_index);
+  
+  // Equivalent to at(nodeId), but if the node is in the dense index it's looked up there instead.
+  // `dense_index' must be the dense index of `nodeId'.
+  node_iterator atDenseIndex(std::size_t dense_index, NodeId nodeId);
+  
+  // Returns an upper bound on the number of nodes in the graph (nodes that are only referenced by other nodes might also be
+  // counted).
+  std::size_t size() const;
+  
+  // Returns the position of the node in this graph, in [0, size()). This can be used to index per-node side arrays.
+  std::size_t indexOf(node_iterator itr) const;
+  
+  // Returns statistics about the hash tables used to look up node IDs. This is O(n), it's meant for tuning and debugging.
+  typename SemistaticMap<NodeId, InternalNodeId>::Statistics getLookupStatistics() const;
+  
 #ifdef FRUIT_EXTRA_DEBUG
   // Emits a runtime error if some node was not created but there is an edge pointing to it.
   void checkFullyConstructed();
@@ -25,10 +25,10 @@
 #include <fruit/impl/data_structures/semistatic_map.templates.h>
 #include <fruit/impl/util/hash_helpers.h>
 #include <fruit/impl/data_structures/fixed_size_vector.templates.h>
+#include <fruit/impl/util/parallel_ranges.h>
 
-#ifdef FRUIT_EXTRA_DEBUG
+#include <cstdlib>
 #include <iostream>
-#endif
 
 namespace fruit {
 namespace impl {
@@ -43,11 +43,21 @@ struct indexing_iterator {
     index += index_increment;
   }
   
-  auto operator*() -> decltype(std::make_pair(*iter, SemistaticGraphInternalNodeId{index})) {
-    return std::make_pair(*iter, SemistaticGraphInternalNodeId{index});
+  auto operator*() -> decltype(std::make_pair(*iter, SemistaticGraphInternalNodeId{std::uint32_t(index)})) {
+    return std::make_pair(*iter, SemistaticGraphInternalNodeId{std::uint32_t(index)});
   }
 };
 
+template <typename NodeId, typename Node>
+void SemistaticGraph<NodeId, Node>::checkNumNodes(std::size_t num_nodes) {
+  // The last ID is reserved, see missing_dense_index_entry.
+  if (num_nodes >= InternalNodeId::max_id / sizeof(NodeData)) {
+    std::cerr << "Fatal injection error: the injection graph would have " << num_nodes << " nodes, but at most "
+              << (InternalNodeId::max_id / sizeof(NodeData) - 1) << " are supported." << std::endl;
+    exit(1);
+  }
+}
+
 #ifdef FRUIT_EXTRA_DEBUG
 template <typename NodeId, typename Node>
 template <typename NodeIter>
@@ -75,7 +85,49 @@ void SemistaticGraph<NodeId, Node>::printGraph(NodeIter first, NodeIter last) {
 
 template <typename NodeId, typename Node>
 template <typename NodeIter>
-SemistaticGraph<NodeId, Node>::SemistaticGraph(NodeIter first, NodeIter last) {
+void SemistaticGraph<NodeId, Node>::computeDependencyOrder(NodeIter first, NodeIter last, std::vector<NodeId>& node_ids,
+                                                           std::vector<NodeIter>& node_iters) {
+  HashMap<NodeId, NodeIter> node_iter_by_id = createHashMap<NodeId, NodeIter>(last - first);
+  for (NodeIter i = first; i != last; ++i) {
+    node_iter_by_id.insert(std::make_pair(i->getId(), i));
+  }
+  
+  HashSet<NodeId> visited = createHashSet<NodeId>(last - first);
+  // We use an explicit stack instead of recursion, since the graph might be very deep.
+  std::vector<NodeId> stack;
+  for (NodeIter root = first; root != last; ++root) {
+    stack.push_back(root->getId());
+    while (!stack.empty()) {
+      NodeId node_id = stack.back();
+      stack.pop_back();
+      if (!visited.insert(node_id).second) {
+        continue;
+      }
+      node_ids.push_back(node_id);
+      auto node_iter_itr = node_iter_by_id.find(node_id);
+      if (node_iter_itr == node_iter_by_id.end()) {
+        // This node is only a neighbor of other nodes.
+        continue;
+      }
+      NodeIter i = node_iter_itr->second;
+      node_iters.push_back(i);
+      if (!i->isTerminal()) {
+        // The neighbors are pushed in reverse order, so that the first one is visited first.
+        std::size_t stack_size = stack.size();
+        for (auto j = i->getEdgesBegin(); j != i->getEdgesEnd(); ++j) {
+          stack.push_back(*j);
+        }
+        std::reverse(stack.begin() + stack_size, stack.end());
+      }
+    }
+  }
+}
+
+template <typename NodeId, typename Node>
+template <typename NodeIter>
+SemistaticGraph<NodeId, Node>::SemistaticGraph(NodeIter first, NodeIter last, Layout layout, std::size_t num_threads,
+                                               MemoryResource* memory_resource)
+  : memory_resource(memory_resource) {
   std::size_t num_edges = 0;
   
   // Step 1: assign IDs to all nodes, fill node_index_map and set first_unused_index.
@@ -90,16 +142,34 @@ SemistaticGraph<NodeId, Node>::SemistaticGraph(NodeIter first, NodeIter last) {
     }
   }
   
-  using itr_t = typename HashSet<NodeId>::iterator;
-  node_index_map = SemistaticMap<NodeId, InternalNodeId>(indexing_iterator<itr_t, sizeof(NodeData)>{node_ids.begin(), 0},
-                                                         node_ids.size());
+  checkNumNodes(node_ids.size());
+  
+  std::vector<NodeId> ordered_node_ids;
+  std::vector<NodeIter> ordered_node_iters;
+  if (layout == Layout::DEPENDENCY_ORDER) {
+    computeDependencyOrder(first, last, ordered_node_ids, ordered_node_iters);
+    FruitAssert(ordered_node_ids.size() == node_ids.size());
+    using itr_t = typename std::vector<NodeId>::iterator;
+    node_index_map = SemistaticMap<NodeId, InternalNodeId>(
+        indexing_iterator<itr_t, sizeof(NodeData)>{ordered_node_ids.begin(), 0},
+        ordered_node_ids.size(),
+        SemistaticMap<NodeId, InternalNodeId>::default_seed,
+        memory_resource);
+  } else {
+    using itr_t = typename HashSet<NodeId>::iterator;
+    node_index_map = SemistaticMap<NodeId, InternalNodeId>(
+        indexing_iterator<itr_t, sizeof(NodeData)>{node_ids.begin(), 0},
+        node_ids.size(),
+        SemistaticMap<NodeId, InternalNodeId>::default_seed,
+        memory_resource);
+  }
   
   first_unused_index = node_ids.size();
   
   // Step 2: fill `nodes' and edges_storage.
   
   // Note that not all of these will be assigned in the loop below.
-  nodes = FixedSizeVector<NodeData>(first_unused_index, NodeData{
+  nodes = FixedSizeVector<NodeData>(memory_resource, first_unused_index, NodeData{
 #ifdef FRUIT_EXTRA_DEBUG
     NodeId(),
 #endif
@@ -107,21 +177,57 @@ SemistaticGraph<NodeId, Node>::SemistaticGraph(NodeIter first, NodeIter last) {
     Node()});
   
   // edges_storage[0] is unused, that's the reason for the +1
-  edges_storage = FixedSizeVector<InternalNodeId>(num_edges + 1);
-  edges_storage.push_back(InternalNodeId());
+  edges_storage = FixedSizeVector<InternalNodeId>(memory_resource, num_edges + 1, InternalNodeId());
   
-  for (NodeIter i = first; i != last; ++i) {
+  // Adds the node `i', storing its edges starting at `edges'. Returns the end of the stored edges.
+  auto add_node = [this](NodeIter i, InternalNodeId* edges) {
     NodeData& nodeData = *nodeAtId(node_index_map.at(i->getId()));
     nodeData.node = i->getValue();
     if (i->isTerminal()) {
       nodeData.edges_begin = 0;
     } else {
-      nodeData.edges_begin = reinterpret_cast<std::uintptr_t>(edges_storage.data() + edges_storage.size());
+      nodeData.edges_begin = reinterpret_cast<std::uintptr_t>(edges);
       for (auto j = i->getEdgesBegin(); j != i->getEdgesEnd(); ++j) {
-        InternalNodeId other_node_id = node_index_map.at(*j);
-        edges_storage.push_back(other_node_id);
+        *edges = node_index_map.at(*j);
+        ++edges;
+      }
+    }
+    return edges;
+  };
+  
+  if (num_threads > 1) {
+    // Each thread adds a range of nodes, so we first compute where the edges of each node will be stored.
+    if (layout != Layout::DEPENDENCY_ORDER) {
+      ordered_node_iters.reserve(last - first);
+      for (NodeIter i = first; i != last; ++i) {
+        ordered_node_iters.push_back(i);
       }
     }
+    std::vector<std::size_t> edges_offset(ordered_node_iters.size() + 1);
+    edges_offset[0] = 1;
+    for (std::size_t k = 0; k < ordered_node_iters.size(); ++k) {
+      NodeIter i = ordered_node_iters[k];
+      edges_offset[k + 1] = edges_offset[k] + (i->isTerminal() ? 0 : std::distance(i->getEdgesBegin(), i->getEdgesEnd()));
+    }
+    FruitAssert(edges_offset.back() == num_edges + 1);
+    forEachRangeInParallel(ordered_node_iters.size(), num_threads,
+                           [this, &ordered_node_iters, &edges_offset, &add_node](std::size_t, std::size_t begin,
+                                                                                 std::size_t end) {
+                             for (std::size_t k = begin; k < end; ++k) {
+                               add_node(ordered_node_iters[k], edges_storage.data() + edges_offset[k]);
+                             }
+                           });
+  } else if (layout == Layout::DEPENDENCY_ORDER) {
+    // The edges are stored in the same order as the nodes.
+    InternalNodeId* edges = edges_storage.data() + 1;
+    for (NodeIter i : ordered_node_iters) {
+      edges = add_node(i, edges);
+    }
+  } else {
+    InternalNodeId* edges = edges_storage.data() + 1;
+    for (NodeIter i = first; i != last; ++i) {
+      edges = add_node(i, edges);
+    }
   }
   
 #ifdef FRUIT_EXTRA_DEBUG
@@ -131,8 +237,13 @@ SemistaticGraph<NodeId, Node>::SemistaticGraph(NodeIter first, NodeIter last) {
 
 template <typename NodeId, typename Node>
 template <typename NodeIter>
-SemistaticGraph<NodeId, Node>::SemistaticGraph(const SemistaticGraph& x, NodeIter first, NodeIter last)
-  : first_unused_index(x.first_unused_index) {
+SemistaticGraph<NodeId, Node>::SemistaticGraph(const SemistaticGraph& x, NodeIter first, NodeIter last,
+                                               std::size_t max_bucketed_elems,
+                                               MemoryResource* memory_resource)
+  : first_unused_index(x.first_unused_index),
+    memory_resource(memory_resource),
+    dense_index_map(x.dense_index_map),
+    dense_index_map_size(x.dense_index_map_size) {
   
   // TODO: The code below is very similar to the other constructor, extract the common parts in separate functions.
   
@@ -161,16 +272,18 @@ SemistaticGraph<NodeId, Node>::SemistaticGraph(const SemistaticGraph& x, NodeIte
   node_ids.erase(std::unique(node_ids.begin(), node_ids.end()), node_ids.end());
   
   // Step 1c: assign new IDs.
+  checkNumNodes(first_unused_index + node_ids.size());
   for (auto& p : node_ids) {
-    p.second = InternalNodeId{first_unused_index*sizeof(NodeData)};
+    p.second = InternalNodeId{std::uint32_t(first_unused_index*sizeof(NodeData))};
     ++first_unused_index;
   }
   
   // Step 1d: actually populate node_index_map.
-  node_index_map = SemistaticMap<NodeId, InternalNodeId>(x.node_index_map, std::move(node_ids));
+  node_index_map = SemistaticMap<NodeId, InternalNodeId>(
+      x.node_index_map, std::move(node_ids), max_bucketed_elems, memory_resource);
   
   // Step 2: fill `nodes' and `edges_storage'
-  nodes = FixedSizeVector<NodeData>(x.nodes, first_unused_index);
+  nodes = FixedSizeVector<NodeData>(memory_resource, x.nodes, first_unused_index);
   // Note that the loop below does not necessarily assign all of these.
   for (std::size_t i = x.nodes.size(); i < first_unused_index; ++i) {
     nodes.push_back(NodeData{
@@ -182,7 +295,7 @@ SemistaticGraph<NodeId, Node>::SemistaticGraph(const SemistaticGraph& x, NodeIte
   }
   
   // edges_storage[0] is unused, that's the reason for the +1
-  edges_storage = FixedSizeVector<InternalNodeId>(num_new_edges + 1);
+  edges_storage = FixedSizeVector<InternalNodeId>(memory_resource, num_new_edges + 1);
   edges_storage.push_back(InternalNodeId());
   
   for (NodeIter i = first; i != last; ++i) {
@@ -204,6 +317,29 @@ SemistaticGraph<NodeId, Node>::SemistaticGraph(const SemistaticGraph& x, NodeIte
 #endif  
 }
 
+template <typename NodeId, typename Node>
+template <typename NodeIter, typename GetDenseIndex>
+void SemistaticGraph<NodeId, Node>::buildDenseIndex(NodeIter first, NodeIter last, GetDenseIndex get_dense_index) {
+  FruitAssert(dense_index_map_size == 0);
+  std::size_t size = 0;
+  for (NodeIter i = first; i != last; ++i) {
+    size = std::max(size, std::size_t(get_dense_index(i->getId())) + 1);
+  }
+  dense_index_map_storage = FixedSizeVector<InternalNodeId>(memory_resource, size,
+                                                            InternalNodeId{missing_dense_index_entry});
+  for (NodeIter i = first; i != last; ++i) {
+    dense_index_map_storage[get_dense_index(i->getId())] = node_index_map.at(i->getId());
+  }
+  dense_index_map = dense_index_map_storage.data();
+  dense_index_map_size = size;
+}
+
+template <typename NodeId, typename Node>
+typename SemistaticMap<NodeId, SemistaticGraphInternalNodeId>::Statistics
+SemistaticGraph<NodeId, Node>::getLookupStatistics() const {
+  return node_index_map.getStatistics();
+}
+
 #ifdef FRUIT_EXTRA_DEBUG
 template <typename NodeId, typename Node>
 void SemistaticGraph<NodeId, Node>::checkFullyConstructed() {
@@ -37,6 +37,12 @@ inline typename SemistaticMap<Key, Value>::Unsigned SemistaticMap<Key, Value>::h
   return hash_function.hash(std::hash<typename std::remove_cv<Key>::type>()(key));
 }
 
+template <typename Key, typename Value>
+inline const typename SemistaticMap<Key, Value>::value_type& SemistaticMap<Key, Value>::perfectHashSlot(const Key& key) const {
+  Unsigned h = std::hash<typename std::remove_cv<Key>::type>()(key);
+  return perfect_hash_slots[slot_hash_function.hash(h) ^ perfect_hash_displacements[bucket_hash_function.hash(h)]];
+}
+
 } // namespace impl
 } // namespace fruit
 
@@ -29,11 +29,22 @@ namespace impl {
 
 /**
  * Provides a subset of the interface of std::map, and also has these additional assumptions:
- * - Key must be default constructible and trivially copyable
+ * - Key must be default constructible and trivially copyable, and its operator== must be equivalent to comparing the
+ *   object representations (as for integers, pointers and TypeId).
  * - Value must be default constructible and trivially copyable
  * 
  * Also, while insertion of elements after construction is supported, inserting more than O(1) elements
- * after construction will raise the cost of any further lookups to more than O(1).
+ * after construction will raise the cost of any further insertions to more than O(1). When too many elements have been
+ * inserted, a new perfect hash table is built with all the elements (see the constructor that copies another map).
+ * 
+ * The elements passed to the constructor are stored using a perfect hash function (in the style of CHD, "hash, displace
+ * and compress"), so looking them up takes a single probe and a single key comparison. Elements inserted later are stored
+ * in a separate bucketed hash table, that is only checked when the perfect hash lookup fails. The keys of that table are
+ * stored separately from the values, in fixed-size buckets, so that a bucket can be checked with a single SIMD comparison
+ * (when available).
+ * All the hash functions are picked using a pseudo-random generator with a fixed seed, so for the same key hashes the
+ * construction is deterministic. Note that this doesn't make it reproducible across runs: e.g. for TypeId keys the hashes
+ * are computed from addresses, that can change between runs (e.g. with ASLR).
  */
 template <typename Key, typename Value>
 class SemistaticMap {
@@ -43,6 +54,38 @@ private:
   using value_type = std::pair<Key, Value>;
   
   static constexpr unsigned char beta = 4;
+  
+public:
+  // How the elements of a map are stored.
+  enum class Strategy {
+    // All the elements are in a perfect hash table owned by this map, except for any elements inserted later.
+    PERFECT_HASH,
+    // The perfect hash table is shared with the map that this map was copied from, and the elements inserted later are in
+    // the bucketed hash table.
+    SHARED_PERFECT_HASH,
+    // No perfect hash function was found, all elements are in the bucketed hash table.
+    BUCKETED,
+  };
+  
+  // Statistics about the hash tables of a map, useful to tune max_bucketed_elems.
+  struct Statistics {
+    Strategy strategy;
+    std::size_t num_perfect_hash_elems;
+    // This is 0 if there is no perfect hash table.
+    std::size_t num_perfect_hash_slots;
+    std::size_t num_bucketed_elems;
+    // This is 0 if there is no bucketed hash table.
+    std::size_t num_buckets;
+    std::size_t max_bucket_size;
+  };
+  
+private:
+  
+  // The alignment of bucket_keys.
+  static constexpr std::size_t cache_line_size = 64;
+  
+  // If no perfect hash function is found after this many attempts, only the bucketed hash table is used.
+  static constexpr unsigned max_perfect_hash_attempts = 64;
     
   static_assert(std::numeric_limits<NumBits>::max() >= sizeof(Unsigned)*CHAR_BIT,
                 "An unsigned char is not enough to contain the number of bits in your platform. Please report this issue.");
@@ -58,38 +101,89 @@ private:
   
   static NumBits pickNumBits(std::size_t n);
   
-  struct CandidateValuesRange {
-    value_type* begin;
-    value_type* end;
-  };
-
+  // Picks the multiplier of a HashFunction.
+  template <typename RandomGenerator>
+  static Unsigned pickMultiplier(RandomGenerator& random_generator);
+  
+  // Returns a bitmask where the i-th bit is set iff keys[i]==key, for 0<=i<beta.
+  static unsigned bucketMatches(const Key* keys, const Key& key);
+  
+  // Returns the index of the lowest set bit in `mask'. Assumes that mask!=0.
+  static std::size_t lowestSetBit(unsigned mask);
+  
+  // The bucketed hash table. The element with key x (if any) is at index i in bucket h=hash_function.hash(x), i.e. its key
+  // is bucket_keys[h*beta+i] and its value is bucket_values[h*beta+i].
+  // Each bucket has beta slots but contains at most beta-1 elements. Unused slots contain a copy of another element (that
+  // is in a different bucket, or in the same bucket at a lower index), so a bucket can always be checked as a whole.
+  // bucket_keys points into bucket_keys_storage, and it's aligned to a cache line (when possible). It's nullptr if the
+  // table is empty.
   HashFunction hash_function;
-  // Given a key x, if p=lookup_table[hash_function.hash(x)] the candidate places for x are [p.first, p.second). These pointers
-  // point to the values[] vector, but it might be either the one of this object or the one of an object that was shallow-copied
-  // into this one.
-  FixedSizeVector<CandidateValuesRange> lookup_table;
-  FixedSizeVector<value_type> values;
+  // The resource where the tables below are allocated (or nullptr to use operator new).
+  MemoryResource* memory_resource = nullptr;
+  Key* bucket_keys = nullptr;
+  FixedSizeVector<Key> bucket_keys_storage;
+  FixedSizeVector<Value> bucket_values;
+  
+  // The perfect hash table. The element with key x (if any) is in
+  // perfect_hash_slots[slot_hash_function.hash(h) ^ perfect_hash_displacements[bucket_hash_function.hash(h)]]
+  // where h is std::hash<Key>()(x).
+  // Unused slots contain a copy of another element, so a key comparison is enough to tell if the key is in the slot.
+  // These pointers point to the vectors below, but they might be either the ones of this object or the ones of an object
+  // that was shallow-copied into this one.
+  // If perfect_hash_slots is nullptr, only the bucketed hash table is used.
+  Strategy strategy = Strategy::PERFECT_HASH;
+  HashFunction bucket_hash_function;
+  HashFunction slot_hash_function;
+  const Unsigned* perfect_hash_displacements = nullptr;
+  const value_type* perfect_hash_slots = nullptr;
+  FixedSizeVector<Unsigned> perfect_hash_displacements_storage;
+  FixedSizeVector<value_type> perfect_hash_slots_storage;
   
   Unsigned hash(const Key& key) const;
   
-  // Inserts a range [elems_begin, elems_end) of new (key,value) pairs with hash h. The keys must not exist in the map.
-  // Before calling this, ensure that the capacity of `values' is sufficient to contain the new values without re-allocating.
-  void insert(std::size_t h, const value_type* elems_begin, const value_type* elems_end);
+  // Returns the perfect hash slot that might contain `key'. Assumes that perfect_hash_slots is not nullptr.
+  const value_type& perfectHashSlot(const Key& key) const;
+  
+  // Tries to build a perfect hash table for the specified elements. Returns false if no perfect hash function was found.
+  template <typename Iter, typename RandomGenerator>
+  bool buildPerfectHashTable(Iter values_begin, std::size_t num_values, RandomGenerator& random_generator);
+  
+  // Builds the bucketed hash table with the specified elements.
+  template <typename Iter, typename RandomGenerator>
+  void buildLookupTable(Iter values_begin, std::size_t num_values, RandomGenerator& random_generator);
+  
+  // Appends the elements in the bucketed hash table to `elems'.
+  void appendBucketedElems(std::vector<value_type>& elems) const;
+  
+  // Appends the elements in the perfect hash table (if any) to `elems'.
+  void appendPerfectHashElems(std::vector<value_type>& elems) const;
   
 public:
+  // The seed used by default for the pseudo-random generator that picks the hash functions.
+  static constexpr std::uint_fast64_t default_seed = 0x5eed;
+  
+  // The default value of the max_bucketed_elems parameter of the 2-arg constructor.
+  static constexpr std::size_t default_max_bucketed_elems = 64;
+  
   // Constructs an *invalid* map (as if this map was just moved from).
   SemistaticMap() = default;
   
   // Iter must be a forward iterator with value type std::pair<Key, Value>.
+  // The construction only depends on the elements (through std::hash<Key>, see above) and on `seed'.
+  // If memory_resource is not nullptr, the tables are allocated from it.
   template <typename Iter>
-  SemistaticMap(Iter begin, std::size_t num_values);
+  SemistaticMap(Iter begin, std::size_t num_values, std::uint_fast64_t seed = default_seed,
+                MemoryResource* memory_resource = nullptr);
   
   // Creates a shallow copy of `map' with the additional elements in new_elements.
   // The keys in new_elements must be unique and must not be present in `map'.
   // The new map will share data with `map', so must be destroyed before `map' is destroyed.
-  // NOTE: If more than O(1) elements are added, calls to at() and find() on the result will *not* be O(1).
-  // This is O(new_elements.size()*log(new_elements.size())).
-  SemistaticMap(const SemistaticMap<Key, Value>& map, std::vector<value_type>&& new_elements);
+  // The perfect hash table is shared, while the bucketed hash table is rebuilt, so this is O(new_elements.size()) plus the
+  // number of elements inserted in `map' after its construction (if any).
+  // If the bucketed hash table would contain more than max_bucketed_elems elements, a new perfect hash table is built
+  // instead with all the elements (in O(n) time). Then the new map doesn't share data with `map'.
+  SemistaticMap(const SemistaticMap<Key, Value>& map, std::vector<value_type>&& new_elements,
+                std::size_t max_bucketed_elems = default_max_bucketed_elems, MemoryResource* memory_resource = nullptr);
   
   SemistaticMap(SemistaticMap&&) = default;
   SemistaticMap(const SemistaticMap&) = delete;
@@ -106,6 +200,9 @@ public:
   // Prefer using at() when possible, this is slightly slower.
   // Returns nullptr if the key was not found.
   const Value* find(Key key) const;
+  
+  // This is O(n), it's meant for tuning and debugging.
+  Statistics getStatistics() const;
 };
 
 } // namespace impl
@@ -23,7 +23,7 @@
 
 #include <algorithm>
 #include <cassert>
-#include <chrono>
+#include <cstring>
 #include <random>
 #include <utility>
 // This include is not necessary for GCC/Clang, but it's necessary for MSVC.
@@ -34,12 +34,143 @@
 #include <fruit/impl/fruit_assert.h>
 #include <fruit/impl/data_structures/fixed_size_vector.templates.h>
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace fruit {
 namespace impl {
 
 template <typename Key, typename Value>
 template <typename Iter>
-SemistaticMap<Key, Value>::SemistaticMap(Iter values_begin, std::size_t num_values) {
+SemistaticMap<Key, Value>::SemistaticMap(Iter values_begin, std::size_t num_values, std::uint_fast64_t seed,
+                                         MemoryResource* memory_resource)
+  : memory_resource(memory_resource) {
+  // std::mt19937_64 is fully specified by the standard (unlike e.g. std::default_random_engine), so the same seed gives the
+  // same sequence of candidate hash functions on all platforms. Which candidate is picked still depends on the key
+  // hashes, so it might differ between runs.
+  std::mt19937_64 random_generator(seed);
+  if (num_values == 0 || buildPerfectHashTable(values_begin, num_values, random_generator)) {
+    // The lookup table will only contain the elements inserted later (if any).
+    strategy = Strategy::PERFECT_HASH;
+    buildLookupTable(values_begin, 0, random_generator);
+  } else {
+    strategy = Strategy::BUCKETED;
+    buildLookupTable(values_begin, num_values, random_generator);
+  }
+}
+
+template <typename Key, typename Value>
+template <typename Iter, typename RandomGenerator>
+bool SemistaticMap<Key, Value>::buildPerfectHashTable(Iter values_begin, std::size_t num_values,
+                                                      RandomGenerator& random_generator) {
+  FruitAssert(num_values != 0);
+  
+  // On average there are at most 2 elements per bucket, and at least 20% of the slots are unused.
+  NumBits num_bucket_bits = pickNumBits((num_values + 1) / 2);
+  NumBits num_slot_bits = pickNumBits(num_values + num_values / 4 + 1);
+  std::size_t num_buckets = std::size_t(1) << num_bucket_bits;
+  std::size_t num_slots = std::size_t(1) << num_slot_bits;
+  bucket_hash_function.shift = (sizeof(Unsigned)*CHAR_BIT - num_bucket_bits);
+  slot_hash_function.shift = (sizeof(Unsigned)*CHAR_BIT - num_slot_bits);
+  
+  std::vector<Unsigned> key_hashes;
+  key_hashes.reserve(num_values);
+  Iter itr = values_begin;
+  for (std::size_t i = 0; i < num_values; ++i, ++itr) {
+    key_hashes.push_back(std::hash<typename std::remove_cv<Key>::type>()((*itr).first));
+  }
+  
+  // bucket_begin[b] is the index in elems_by_bucket of the first element in bucket b.
+  std::vector<std::size_t> bucket_begin(num_buckets + 1);
+  std::vector<std::size_t> next_in_bucket(num_buckets);
+  std::vector<std::size_t> elems_by_bucket(num_values);
+  std::vector<std::size_t> buckets_by_size(num_buckets);
+  std::vector<bool> slot_used(num_slots);
+  FixedSizeVector<Unsigned> displacements(memory_resource, num_buckets, 0);
+  
+  for (unsigned attempt = 0; attempt < max_perfect_hash_attempts; ++attempt) {
+    bucket_hash_function.a = pickMultiplier(random_generator);
+    slot_hash_function.a = pickMultiplier(random_generator);
+    
+    // Step 1: group the elements by bucket (with a counting sort).
+    std::fill(bucket_begin.begin(), bucket_begin.end(), 0);
+    for (Unsigned key_hash : key_hashes) {
+      ++bucket_begin[bucket_hash_function.hash(key_hash) + 1];
+    }
+    std::partial_sum(bucket_begin.begin(), bucket_begin.end(), bucket_begin.begin());
+    std::copy(bucket_begin.begin(), bucket_begin.end() - 1, next_in_bucket.begin());
+    for (std::size_t i = 0; i < num_values; ++i) {
+      elems_by_bucket[next_in_bucket[bucket_hash_function.hash(key_hashes[i])]++] = i;
+    }
+    
+    // Step 2: find a displacement for each bucket, starting from the biggest ones (that are the hardest to place).
+    std::iota(buckets_by_size.begin(), buckets_by_size.end(), 0);
+    std::stable_sort(buckets_by_size.begin(), buckets_by_size.end(), [&](std::size_t x, std::size_t y) {
+      return bucket_begin[x + 1] - bucket_begin[x] > bucket_begin[y + 1] - bucket_begin[y];
+    });
+    std::fill(slot_used.begin(), slot_used.end(), false);
+    std::fill(displacements.begin(), displacements.end(), 0);
+    
+    bool all_placed = true;
+    for (std::size_t bucket : buckets_by_size) {
+      std::size_t begin = bucket_begin[bucket];
+      std::size_t end = bucket_begin[bucket + 1];
+      if (begin == end) {
+        // All the remaining buckets are empty too.
+        break;
+      }
+      bool placed = false;
+      for (Unsigned displacement = 0; displacement < num_slots && !placed; ++displacement) {
+        std::size_t j = begin;
+        for (; j < end; ++j) {
+          Unsigned slot = slot_hash_function.hash(key_hashes[elems_by_bucket[j]]) ^ displacement;
+          if (slot_used[slot]) {
+            break;
+          }
+          slot_used[slot] = true;
+        }
+        if (j == end) {
+          displacements[bucket] = displacement;
+          placed = true;
+        } else {
+          // Undo the partial placement.
+          for (std::size_t k = begin; k < j; ++k) {
+            slot_used[slot_hash_function.hash(key_hashes[elems_by_bucket[k]]) ^ displacement] = false;
+          }
+        }
+      }
+      if (!placed) {
+        all_placed = false;
+        break;
+      }
+    }
+    
+    if (all_placed) {
+      // Unused slots contain a copy of the first element, see perfect_hash_slots.
+      perfect_hash_slots_storage = FixedSizeVector<value_type>(memory_resource, num_slots, *values_begin);
+      itr = values_begin;
+      for (std::size_t i = 0; i < num_values; ++i, ++itr) {
+        Unsigned slot = slot_hash_function.hash(key_hashes[i])
+            ^ displacements[bucket_hash_function.hash(key_hashes[i])];
+        perfect_hash_slots_storage[slot] = *itr;
+      }
+      perfect_hash_displacements_storage = std::move(displacements);
+      perfect_hash_slots = perfect_hash_slots_storage.data();
+      perfect_hash_displacements = perfect_hash_displacements_storage.data();
+      return true;
+    }
+  }
+  
+  return false;
+}
+
+template <typename Key, typename Value>
+template <typename Iter, typename RandomGenerator>
+void SemistaticMap<Key, Value>::buildLookupTable(Iter values_begin, std::size_t num_values,
+                                                 RandomGenerator& random_generator) {
   NumBits num_bits = pickNumBits(num_values);
   std::size_t num_buckets = size_t(1) << num_bits;
   
@@ -47,13 +178,8 @@ SemistaticMap<Key, Value>::SemistaticMap(Iter values_begin, std::size_t num_valu
   
   hash_function.shift = (sizeof(Unsigned)*CHAR_BIT - num_bits);
   
-  // The cast is a no-op in some systems (e.g. GCC and Clang under Linux 64bit) but it's needed in other systems (e.g. MSVC).
-  unsigned seed = (unsigned) std::chrono::system_clock::now().time_since_epoch().count();
-  std::default_random_engine random_generator(seed);
-  std::uniform_int_distribution<Unsigned> random_distribution;
-  
   while (1) {
-    hash_function.a = random_distribution(random_generator);
+    hash_function.a = pickMultiplier(random_generator);
     
     Iter itr = values_begin;
     for (std::size_t i = 0; i < num_values; ++i, ++itr) {
@@ -71,113 +197,238 @@ pick_another:
     }
   }
   
-  values = FixedSizeVector<value_type>(num_values, value_type());
+  if (num_values == 0) {
+    bucket_keys = nullptr;
+    bucket_keys_storage = FixedSizeVector<Key>();
+    bucket_values = FixedSizeVector<Value>();
+    return;
+  }
   
-  std::partial_sum(count.begin(), count.end(), count.begin());
-  lookup_table = FixedSizeVector<CandidateValuesRange>(count.size());
-  for (Unsigned n : count) {
-    lookup_table.push_back(CandidateValuesRange{values.data() + n, values.data() + n});
+  // Unused slots contain a copy of the first element, see bucket_keys.
+  // The keys are over-allocated so that bucket_keys can be aligned to a cache line.
+  const value_type& first_value = *values_begin;
+  std::size_t num_padding_keys = (cache_line_size % sizeof(Key) == 0) ? cache_line_size / sizeof(Key) : 0;
+  bucket_keys_storage = FixedSizeVector<Key>(memory_resource, num_buckets * beta + num_padding_keys, first_value.first);
+  bucket_values = FixedSizeVector<Value>(memory_resource, num_buckets * beta, first_value.second);
+  bucket_keys = bucket_keys_storage.data();
+  if (num_padding_keys != 0) {
+    std::size_t misalignment = reinterpret_cast<std::uintptr_t>(bucket_keys) % cache_line_size;
+    if (misalignment % sizeof(Key) == 0 && misalignment != 0) {
+      bucket_keys += (cache_line_size - misalignment) / sizeof(Key);
+    }
   }
   
-  // At this point lookup_table[h] is the number of keys in [first, last) that have a hash <=h.
-  // Note that even though we ensure this after construction, it is not maintained by insert() so it's not an invariant.
+  // Now `count' is re-used to store the number of elements already stored in each bucket.
+  for (std::size_t i = 0; i < num_buckets; ++i) {
+    count[i] = 0;
+  }
   
   Iter itr = values_begin;
   for (std::size_t i = 0; i < num_values; ++i, ++itr) {
-    value_type*& first_value_ptr = lookup_table[hash((*itr).first)].begin;
-    --first_value_ptr;
-    FruitAssert(values.data() <= first_value_ptr);
-    FruitAssert(first_value_ptr < values.data() + values.size());
-    *first_value_ptr = *itr;
+    Unsigned h = hash((*itr).first);
+    std::size_t index = h * beta + count[h];
+    ++count[h];
+    FruitAssert(count[h] < beta);
+    bucket_keys[index] = (*itr).first;
+    bucket_values[index] = (*itr).second;
   }
 }
 
 template <typename Key, typename Value>
 SemistaticMap<Key, Value>::SemistaticMap(const SemistaticMap<Key, Value>& map,
-                                         std::vector<value_type>&& new_elements)
-  : hash_function(map.hash_function), lookup_table(map.lookup_table, map.lookup_table.size()) {
-    
-  // Sort by hash.
-  std::sort(new_elements.begin(), new_elements.end(), [this](const value_type& x, const value_type& y) {
-    return hash(x.first) < hash(y.first);
-  });
+                                         std::vector<value_type>&& new_elements,
+                                         std::size_t max_bucketed_elems,
+                                         MemoryResource* memory_resource)
+  : memory_resource(memory_resource) {
+  std::vector<value_type> elems;
+  map.appendBucketedElems(elems);
+  elems.insert(elems.end(), new_elements.begin(), new_elements.end());
   
-  std::size_t num_additional_values = new_elements.size();
-  // Add the space needed to store copies of the old buckets.
-  for (auto itr = new_elements.begin(), itr_end = new_elements.end(); itr != itr_end; /* no increment */) {
-    Unsigned h = hash(itr->first);
-    auto p = map.lookup_table[h];
-    num_additional_values += (p.end - p.begin);
-    for (; itr != itr_end && hash(itr->first) == h; ++itr) {
-    }
+  if (elems.size() > max_bucketed_elems && map.strategy != Strategy::BUCKETED) {
+    // Too many elements would end up in the bucketed hash table, so we build a new perfect hash table with all the
+    // elements instead. This is not done if a perfect hash function couldn't be found for `map', it's unlikely to be
+    // found now.
+    map.appendPerfectHashElems(elems);
+    *this = SemistaticMap(elems.begin(), elems.size(), default_seed, memory_resource);
+    return;
   }
   
-  values = FixedSizeVector<value_type>(num_additional_values);
+  if (map.perfect_hash_slots != nullptr) {
+    // Share the perfect hash table with `map'.
+    bucket_hash_function = map.bucket_hash_function;
+    slot_hash_function = map.slot_hash_function;
+    perfect_hash_displacements = map.perfect_hash_displacements;
+    perfect_hash_slots = map.perfect_hash_slots;
+    strategy = Strategy::SHARED_PERFECT_HASH;
+  } else {
+    strategy = map.strategy;
+  }
   
-  // Now actually perform the insertions.
+  // The bucketed hash table is rebuilt from scratch. When `map' has a perfect hash table, this only contains the elements
+  // inserted after the construction of the original map, so it's small.
+  std::mt19937_64 random_generator(default_seed);
+  buildLookupTable(elems.begin(), elems.size(), random_generator);
+}
 
-  if (new_elements.empty()) {
-    // This is to workaround a bug in the STL shipped with GCC <4.8.2, where calling data() on an
-    // empty vector causes undefined behavior (https://gcc.gnu.org/bugzilla/show_bug.cgi?id=59829).
+template <typename Key, typename Value>
+void SemistaticMap<Key, Value>::appendBucketedElems(std::vector<value_type>& elems) const {
+  if (bucket_keys == nullptr) {
     return;
   }
-  for (value_type *itr = new_elements.data(), *itr_end = new_elements.data() + new_elements.size();
-       itr != itr_end;
-       /* no increment */) {
-    Unsigned h = hash(itr->first);
-    auto p = map.lookup_table[h];
-    num_additional_values += (p.end - p.begin);
-    value_type* first = itr;
-    for (; itr != itr_end && hash(itr->first) == h; ++itr) {
+  std::size_t num_buckets = std::size_t(1) << (sizeof(Unsigned)*CHAR_BIT - hash_function.shift);
+  for (std::size_t h = 0; h < num_buckets; ++h) {
+    for (std::size_t i = 0; i < beta; ++i) {
+      const Key& key = bucket_keys[h * beta + i];
+      // Skip unused slots (that contain a copy of another element).
+      if (hash(key) == h
+          && (bucketMatches(bucket_keys + h * beta, key) & ((1U << i) - 1)) == 0) {
+        elems.push_back(value_type(key, bucket_values[h * beta + i]));
+      }
     }
-    value_type* last = itr;
-    insert(h, first, last);
   }
 }
 
 template <typename Key, typename Value>
-void SemistaticMap<Key, Value>::insert(std::size_t h, const value_type* elems_begin, const value_type* elems_end) {
-  
-  value_type* old_bucket_begin = lookup_table[h].begin;
-  value_type* old_bucket_end = lookup_table[h].end;
-  
-  lookup_table[h].begin = values.data() + values.size();
-  
-  // Step 1: re-insert all keys with the same hash at the end (if any).
-  for (value_type* p = old_bucket_begin; p != old_bucket_end; ++p) {
-    values.push_back(*p);
+void SemistaticMap<Key, Value>::appendPerfectHashElems(std::vector<value_type>& elems) const {
+  if (perfect_hash_slots == nullptr) {
+    return;
   }
-  
-  // Step 2: also insert the new keys and values
-  for (auto itr = elems_begin; itr != elems_end; ++itr) {
-    values.push_back(*itr);
+  std::size_t num_slots = std::size_t(1) << (sizeof(Unsigned)*CHAR_BIT - slot_hash_function.shift);
+  for (std::size_t i = 0; i < num_slots; ++i) {
+    // Skip unused slots (that contain a copy of an element stored in another slot).
+    if (&perfectHashSlot(perfect_hash_slots[i].first) == &perfect_hash_slots[i]) {
+      elems.push_back(perfect_hash_slots[i]);
+    }
   }
-  
-  lookup_table[h].end = values.data() + values.size();
-  
-  // The old sequence is no longer pointed to by any index in the lookup table, but recompacting the vectors would be too slow.
+}
+
+template <typename Key, typename Value>
+typename SemistaticMap<Key, Value>::Statistics SemistaticMap<Key, Value>::getStatistics() const {
+  Statistics statistics;
+  statistics.strategy = strategy;
+  std::vector<value_type> elems;
+  appendPerfectHashElems(elems);
+  statistics.num_perfect_hash_elems = elems.size();
+  statistics.num_perfect_hash_slots = (perfect_hash_slots == nullptr)
+      ? 0
+      : (std::size_t(1) << (sizeof(Unsigned)*CHAR_BIT - slot_hash_function.shift));
+  elems.clear();
+  appendBucketedElems(elems);
+  statistics.num_bucketed_elems = elems.size();
+  statistics.num_buckets = (bucket_keys == nullptr)
+      ? 0
+      : (std::size_t(1) << (sizeof(Unsigned)*CHAR_BIT - hash_function.shift));
+  std::vector<std::size_t> bucket_sizes(statistics.num_buckets);
+  statistics.max_bucket_size = 0;
+  for (const value_type& elem : elems) {
+    std::size_t& bucket_size = bucket_sizes[hash(elem.first)];
+    ++bucket_size;
+    statistics.max_bucket_size = std::max(statistics.max_bucket_size, bucket_size);
+  }
+  return statistics;
+}
+
+// Checks a bucket of 4 keys of size key_size, returning a bitmask of the matching keys. This is the portable version, that
+// compares one key at a time.
+template <typename Key, std::size_t key_size = sizeof(Key)>
+struct SemistaticMapBucketProbe {
+  static unsigned matches(const Key* keys, const Key& key) {
+    return unsigned(keys[0] == key)
+        | (unsigned(keys[1] == key) << 1)
+        | (unsigned(keys[2] == key) << 2)
+        | (unsigned(keys[3] == key) << 3);
+  }
+};
+
+#ifdef __SSE2__
+
+// These compare the object representations, see the requirements on Key in semistatic_map.h.
+
+template <typename Key>
+struct SemistaticMapBucketProbe<Key, 4> {
+  static unsigned matches(const Key* keys, const Key& key) {
+    std::int32_t key_bits;
+    std::memcpy(&key_bits, &key, sizeof(key_bits));
+    __m128i bucket = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys));
+    __m128i equal = _mm_cmpeq_epi32(bucket, _mm_set1_epi32(key_bits));
+    return unsigned(_mm_movemask_ps(_mm_castsi128_ps(equal)));
+  }
+};
+
+template <typename Key>
+struct SemistaticMapBucketProbe<Key, 8> {
+  static unsigned matches(const Key* keys, const Key& key) {
+    long long key_bits;
+    std::memcpy(&key_bits, &key, sizeof(key_bits));
+#ifdef __AVX2__
+    __m256i bucket = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys));
+    __m256i equal = _mm256_cmpeq_epi64(bucket, _mm256_set1_epi64x(key_bits));
+    return unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(equal)));
+#else
+    // SSE2 has no 64-bit comparison, so we compare the 32-bit halves and then require both halves to be equal.
+    __m128i key_vector = _mm_set1_epi64x(key_bits);
+    __m128i equal_low = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys)), key_vector);
+    __m128i equal_high = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + 2)), key_vector);
+    equal_low = _mm_and_si128(equal_low, _mm_shuffle_epi32(equal_low, 0xB1));
+    equal_high = _mm_and_si128(equal_high, _mm_shuffle_epi32(equal_high, 0xB1));
+    return unsigned(_mm_movemask_pd(_mm_castsi128_pd(equal_low)))
+        | (unsigned(_mm_movemask_pd(_mm_castsi128_pd(equal_high))) << 2);
+#endif
+  }
+};
+
+#endif // __SSE2__
+
+template <typename Key, typename Value>
+inline unsigned SemistaticMap<Key, Value>::bucketMatches(const Key* keys, const Key& key) {
+  static_assert(beta == 4, "SemistaticMapBucketProbe assumes buckets of 4 keys.");
+  return SemistaticMapBucketProbe<Key>::matches(keys, key);
+}
+
+template <typename Key, typename Value>
+inline std::size_t SemistaticMap<Key, Value>::lowestSetBit(unsigned mask) {
+  FruitAssert(mask != 0);
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctz(mask);
+#else
+  std::size_t result = 0;
+  for (; (mask & 1) == 0; mask >>= 1) {
+    ++result;
+  }
+  return result;
+#endif
 }
 
 template <typename Key, typename Value>
 const Value& SemistaticMap<Key, Value>::at(Key key) const {
-  Unsigned h = hash(key);
-  for (const value_type* p = lookup_table[h].begin; /* p!=lookup_table[h].end but no need to check */; ++p) {
-    FruitAssert(p != lookup_table[h].end);
-    if (p->first == key) {
-      return p->second;
+  if (perfect_hash_slots != nullptr) {
+    const value_type& slot = perfectHashSlot(key);
+    if (slot.first == key) {
+      return slot.second;
     }
   }
+  std::size_t bucket_begin = hash(key) * beta;
+  unsigned matches = bucketMatches(bucket_keys + bucket_begin, key);
+  return bucket_values[bucket_begin + lowestSetBit(matches)];
 }
 
 template <typename Key, typename Value>
 const Value* SemistaticMap<Key, Value>::find(Key key) const {
-  Unsigned h = hash(key);
-  for (const value_type *p = lookup_table[h].begin, *p_end = lookup_table[h].end; p != p_end; ++p) {
-    if (p->first == key) {
-      return &(p->second);
+  if (perfect_hash_slots != nullptr) {
+    const value_type& slot = perfectHashSlot(key);
+    if (slot.first == key) {
+      return &(slot.second);
     }
   }
-  return nullptr;
+  if (bucket_keys == nullptr) {
+    return nullptr;
+  }
+  std::size_t bucket_begin = hash(key) * beta;
+  unsigned matches = bucketMatches(bucket_keys + bucket_begin, key);
+  if (matches == 0) {
+    return nullptr;
+  }
+  return &(bucket_values[bucket_begin + lowestSetBit(matches)]);
 }
 
 template <typename Key, typename Value>
@@ -189,6 +440,13 @@ typename SemistaticMap<Key, Value>::NumBits SemistaticMap<Key, Value>::pickNumBi
   return result;
 }
 
+template <typename Key, typename Value>
+template <typename RandomGenerator>
+typename SemistaticMap<Key, Value>::Unsigned SemistaticMap<Key, Value>::pickMultiplier(RandomGenerator& random_generator) {
+  // Odd multipliers give a better distribution of the high-order bits.
+  return Unsigned(random_generator()) | 1;
+}
+
 // This is here so that we don't have to include fixed_size_vector.templates.h in fruit.h.
 template <typename Key, typename Value>
 SemistaticMap<Key, Value>::~SemistaticMap() {
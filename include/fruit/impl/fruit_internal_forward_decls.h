@@ -25,6 +25,7 @@ namespace impl {
 
 class ComponentStorage;
 class NormalizedComponentStorage;
+class PreparedInjectorStorage;
 class InjectorStorage;
 struct TypeId;
 
@@ -188,6 +188,14 @@ struct UnsatisfiedRequirementsInNormalizedComponentError {
     "not provided by the Component (second parameter of the Injector constructor).");
 };
 
+template <typename... UnsatisfiedRequirements>
+struct UnsatisfiedRequirementsInChildInjectorError {
+  static_assert(
+    AlwaysFalse<UnsatisfiedRequirements...>::value,
+    "The requirements in UnsatisfiedRequirements are required by the Component used to create a "
+    "child injector but are not provided by the parent Injector.");
+};
+
 template <typename... TypesNotProvided>
 struct TypesInInjectorNotProvidedError {
   static_assert(
@@ -379,6 +387,11 @@ struct UnsatisfiedRequirementsInNormalizedComponentErrorTag {
   using apply = UnsatisfiedRequirementsInNormalizedComponentError<UnsatisfiedRequirements...>;
 };
 
+struct UnsatisfiedRequirementsInChildInjectorErrorTag {
+  template <typename... UnsatisfiedRequirements>
+  using apply = UnsatisfiedRequirementsInChildInjectorError<UnsatisfiedRequirements...>;
+};
+
 struct TypesInInjectorNotProvidedErrorTag {
   template <typename... TypesNotProvided>
   using apply = TypesInInjectorNotProvidedError<TypesNotProvided...>;
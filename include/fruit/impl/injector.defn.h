@@ -30,6 +30,13 @@ inline Injector<P...>::Injector(const Component<P...>& component)
                                              std::initializer_list<fruit::impl::TypeId>{fruit::impl::getTypeId<P>()...})) {
 }
 
+template <typename... P>
+inline Injector<P...>::Injector(const Component<P...>& component, MemoryResource& memory_resource)
+  : storage(new fruit::impl::InjectorStorage(component.storage,
+                                             std::initializer_list<fruit::impl::TypeId>{fruit::impl::getTypeId<P>()...},
+                                             &memory_resource)) {
+}
+
 namespace impl {
 namespace meta {
 
@@ -59,6 +66,25 @@ struct InjectorImplHelper {
         None)))>;
   };
   
+  // This performs all checks needed in the constructor of Injector that takes a parent Injector.
+  template <typename ParentComp, typename Comp>
+  struct CheckConstructionFromParentInjector {
+    using CompRs = SetDifference(GetComponentRsSuperset(Comp),
+                                 GetComponentPs(Comp));
+    using UnsatisfiedRs = SetDifference(CompRs,
+                                        GetComponentPs(ParentComp));
+    using TypesNotProvided = SetDifference(SetDifference(Vector<Type<P>...>,
+                                                         GetComponentPs(Comp)),
+                                           GetComponentPs(ParentComp));
+    
+    using type = Eval<
+        If(Not(IsEmptySet(UnsatisfiedRs)),
+           ConstructErrorWithArgVector(UnsatisfiedRequirementsInChildInjectorErrorTag, SetToVector(UnsatisfiedRs)),
+        If(Not(IsEmptySet(TypesNotProvided)),
+           ConstructErrorWithArgVector(TypesInInjectorNotProvidedErrorTag, SetToVector(TypesNotProvided)),
+        None))>;
+  };
+  
   template <typename T>
   struct CheckGet {
     using Comp = ConstructComponentImpl(Type<P>...);
@@ -94,6 +120,87 @@ inline Injector<P...>::Injector(const NormalizedComponent<NormalizedComponentPar
   (void)typename fruit::impl::meta::CheckIfError<E>::type();
 }
 
+template <typename... P>
+template <typename... NormalizedComponentParams, typename... ComponentParams>
+inline Injector<P...>::Injector(const NormalizedComponent<NormalizedComponentParams...>& normalized_component,
+                                Component<ComponentParams...> component,
+                                MemoryResource& memory_resource)
+  : storage(new fruit::impl::InjectorStorage(*(normalized_component.storage.storage),
+                                             std::move(component.storage), 
+                                             fruit::impl::getTypeIdsForList<fruit::impl::meta::Eval<
+                                                 fruit::impl::meta::ConcatVectors(
+                                                    fruit::impl::meta::SetToVector(fruit::impl::meta::GetComponentPs(fruit::impl::meta::ConstructComponentImpl(fruit::impl::meta::Type<ComponentParams>...))),
+                                                    fruit::impl::meta::SetToVector(fruit::impl::meta::GetComponentPs(fruit::impl::meta::ConstructComponentImpl(fruit::impl::meta::Type<NormalizedComponentParams>...))))
+                                             >>(),
+                                             &memory_resource)) {
+  // These checks are the same as in the constructor above. They're not in a separate function so that errors are reported
+  // close to the user's code.
+  using NormalizedComp = fruit::impl::meta::ConstructComponentImpl(fruit::impl::meta::Type<NormalizedComponentParams>...);
+  using Comp1 = fruit::impl::meta::ConstructComponentImpl(fruit::impl::meta::Type<ComponentParams>...);
+  using E = typename fruit::impl::meta::InjectorImplHelper<P...>::template CheckConstructionFromNormalizedComponent<NormalizedComp, Comp1>::type;
+  (void)typename fruit::impl::meta::CheckIfError<E>::type();
+}
+
+template <typename... P>
+template <typename... ComponentParams>
+inline Injector<P...>::Injector(const PreparedInjector<P...>& prepared_injector, Component<ComponentParams...> component)
+  : storage(new fruit::impl::InjectorStorage(*(prepared_injector.storage.storage), std::move(component.storage))) {
+  
+  using Comp1 = fruit::impl::meta::ConstructComponentImpl(fruit::impl::meta::Type<ComponentParams>...);
+  // The other checks were already done when constructing the PreparedInjector. The bindings in `component' are checked
+  // against the ones in the sample component at runtime.
+  using E = fruit::impl::meta::Eval<fruit::impl::meta::If(
+      fruit::impl::meta::Not(fruit::impl::meta::IsEmptySet(fruit::impl::meta::GetComponentRsSuperset(Comp1))),
+      fruit::impl::meta::ConstructErrorWithArgVector(fruit::impl::ComponentWithRequirementsInInjectorErrorTag,
+                                                     fruit::impl::meta::SetToVector(fruit::impl::meta::GetComponentRsSuperset(Comp1))),
+      fruit::impl::meta::None)>;
+  (void)typename fruit::impl::meta::CheckIfError<E>::type();
+}
+
+template <typename... P>
+template <typename... ComponentParams>
+inline Injector<P...>::Injector(const PreparedInjector<P...>& prepared_injector, Component<ComponentParams...> component,
+                                MemoryResource& memory_resource)
+  : storage(new fruit::impl::InjectorStorage(*(prepared_injector.storage.storage), std::move(component.storage),
+                                             &memory_resource)) {
+  // Same as in the constructor above.
+  using Comp1 = fruit::impl::meta::ConstructComponentImpl(fruit::impl::meta::Type<ComponentParams>...);
+  using E = fruit::impl::meta::Eval<fruit::impl::meta::If(
+      fruit::impl::meta::Not(fruit::impl::meta::IsEmptySet(fruit::impl::meta::GetComponentRsSuperset(Comp1))),
+      fruit::impl::meta::ConstructErrorWithArgVector(fruit::impl::ComponentWithRequirementsInInjectorErrorTag,
+                                                     fruit::impl::meta::SetToVector(fruit::impl::meta::GetComponentRsSuperset(Comp1))),
+      fruit::impl::meta::None)>;
+  (void)typename fruit::impl::meta::CheckIfError<E>::type();
+}
+
+template <typename... P>
+template <typename... ParentP, typename... ComponentParams>
+inline Injector<P...>::Injector(Injector<ParentP...>& parent, Component<ComponentParams...> component)
+  : storage(new fruit::impl::InjectorStorage(*(parent.storage),
+                                             std::move(component.storage),
+                                             std::initializer_list<fruit::impl::TypeId>{fruit::impl::getTypeId<P>()...})) {
+  
+  using ParentComp = fruit::impl::meta::ConstructComponentImpl(fruit::impl::meta::Type<ParentP>...);
+  using Comp1 = fruit::impl::meta::ConstructComponentImpl(fruit::impl::meta::Type<ComponentParams>...);
+  using E = typename fruit::impl::meta::InjectorImplHelper<P...>::template CheckConstructionFromParentInjector<ParentComp, Comp1>::type;
+  (void)typename fruit::impl::meta::CheckIfError<E>::type();
+}
+
+template <typename... P>
+template <typename... ParentP, typename... ComponentParams>
+inline Injector<P...>::Injector(Injector<ParentP...>& parent, Component<ComponentParams...> component,
+                                MemoryResource& memory_resource)
+  : storage(new fruit::impl::InjectorStorage(*(parent.storage),
+                                             std::move(component.storage),
+                                             std::initializer_list<fruit::impl::TypeId>{fruit::impl::getTypeId<P>()...},
+                                             &memory_resource)) {
+  // Same as in the constructor above.
+  using ParentComp = fruit::impl::meta::ConstructComponentImpl(fruit::impl::meta::Type<ParentP>...);
+  using Comp1 = fruit::impl::meta::ConstructComponentImpl(fruit::impl::meta::Type<ComponentParams>...);
+  using E = typename fruit::impl::meta::InjectorImplHelper<P...>::template CheckConstructionFromParentInjector<ParentComp, Comp1>::type;
+  (void)typename fruit::impl::meta::CheckIfError<E>::type();
+}
+
 template <typename... P>
 template <typename T>
 inline Injector<P...>::RemoveAnnotations<T> Injector<P...>::get() {
@@ -124,6 +231,33 @@ inline const std::vector<
   return storage->template getMultibindings<AnnotatedC>();
 }
 
+template <typename... P>
+template <typename AnnotatedC>
+inline const std::vector<
+	fruit::impl::meta::UnwrapType<fruit::impl::meta::Eval<
+	    fruit::impl::meta::RemoveAnnotations(fruit::impl::meta::Type<AnnotatedC>)
+	>>*>& Injector<P...>::getMultibindingsParallel(std::size_t num_threads) {
+  return storage->template getMultibindingsParallel<AnnotatedC>(num_threads);
+}
+
+template <typename... P>
+template <typename AnnotatedC>
+inline MultibindingsView<
+	fruit::impl::meta::UnwrapType<fruit::impl::meta::Eval<
+	    fruit::impl::meta::RemoveAnnotations(fruit::impl::meta::Type<AnnotatedC>)
+	>>> Injector<P...>::getMultibindingsView() {
+  return storage->template getMultibindingsView<AnnotatedC>();
+}
+
+template <typename... P>
+template <typename AnnotatedC>
+inline LazyMultibindingsView<
+	fruit::impl::meta::UnwrapType<fruit::impl::meta::Eval<
+	    fruit::impl::meta::RemoveAnnotations(fruit::impl::meta::Type<AnnotatedC>)
+	>>> Injector<P...>::getLazyMultibindings() {
+  return storage->template getLazyMultibindings<AnnotatedC>();
+}
+
 template <typename... P>
 inline void Injector<P...>::eagerlyInjectAll() {
   // Eagerly inject normal bindings.
@@ -133,6 +267,44 @@ inline void Injector<P...>::eagerlyInjectAll() {
   storage->eagerlyInjectMultibindings();
 }
 
+template <typename... P>
+inline void Injector<P...>::eagerlyInjectAll(std::size_t num_threads) {
+  storage->eagerlyInjectAll(
+      std::vector<fruit::impl::TypeId>{
+          fruit::impl::getTypeId<fruit::impl::InjectorStorage::NormalizeType<P>>()...},
+      num_threads);
+}
+
+template <typename... P>
+inline void Injector<P...>::enableReset() {
+  storage->enableReset();
+}
+
+template <typename... P>
+inline void Injector<P...>::reset() {
+  storage->reset();
+}
+
+template <typename... P>
+inline void Injector<P...>::enableThreadSafety() {
+  storage->enableThreadSafety();
+}
+
+template <typename... P>
+inline void Injector<P...>::enableIterativeConstruction() {
+  storage->enableIterativeConstruction();
+}
+
+template <typename... P>
+inline void Injector<P...>::enableFastExit() {
+  storage->enableFastExit();
+}
+
+template <typename... P>
+inline BindingLookupStatistics Injector<P...>::getBindingLookupStatistics() const {
+  return storage->getBindingLookupStatistics();
+}
+
 } // namespace fruit
 
 
@@ -0,0 +1,245 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRUIT_MULTIBINDINGS_VIEW_DEFN_H
+#define FRUIT_MULTIBINDINGS_VIEW_DEFN_H
+
+#include <fruit/impl/storage/injector_storage.h>
+
+// Redundant, but makes KDevelop happy.
+#include <fruit/multibindings_view.h>
+
+namespace fruit {
+
+template <typename C>
+inline MultibindingsView<C>::iterator::iterator(void* const* p)
+  : p(p) {
+}
+
+template <typename C>
+inline C* MultibindingsView<C>::iterator::operator*() const {
+  return reinterpret_cast<C*>(*p);
+}
+
+template <typename C>
+inline C* MultibindingsView<C>::iterator::operator[](difference_type n) const {
+  return reinterpret_cast<C*>(p[n]);
+}
+
+template <typename C>
+inline typename MultibindingsView<C>::iterator& MultibindingsView<C>::iterator::operator++() {
+  ++p;
+  return *this;
+}
+
+template <typename C>
+inline typename MultibindingsView<C>::iterator MultibindingsView<C>::iterator::operator++(int) {
+  iterator result = *this;
+  ++p;
+  return result;
+}
+
+template <typename C>
+inline typename MultibindingsView<C>::iterator& MultibindingsView<C>::iterator::operator--() {
+  --p;
+  return *this;
+}
+
+template <typename C>
+inline typename MultibindingsView<C>::iterator MultibindingsView<C>::iterator::operator--(int) {
+  iterator result = *this;
+  --p;
+  return result;
+}
+
+template <typename C>
+inline typename MultibindingsView<C>::iterator& MultibindingsView<C>::iterator::operator+=(difference_type n) {
+  p += n;
+  return *this;
+}
+
+template <typename C>
+inline typename MultibindingsView<C>::iterator& MultibindingsView<C>::iterator::operator-=(difference_type n) {
+  p -= n;
+  return *this;
+}
+
+template <typename C>
+inline typename MultibindingsView<C>::iterator MultibindingsView<C>::iterator::operator+(difference_type n) const {
+  return iterator(p + n);
+}
+
+template <typename C>
+inline typename MultibindingsView<C>::iterator MultibindingsView<C>::iterator::operator-(difference_type n) const {
+  return iterator(p - n);
+}
+
+template <typename C>
+inline typename MultibindingsView<C>::iterator::difference_type
+MultibindingsView<C>::iterator::operator-(const iterator& other) const {
+  return p - other.p;
+}
+
+template <typename C>
+inline bool MultibindingsView<C>::iterator::operator==(const iterator& other) const {
+  return p == other.p;
+}
+
+template <typename C>
+inline bool MultibindingsView<C>::iterator::operator!=(const iterator& other) const {
+  return p != other.p;
+}
+
+template <typename C>
+inline bool MultibindingsView<C>::iterator::operator<(const iterator& other) const {
+  return p < other.p;
+}
+
+template <typename C>
+inline bool MultibindingsView<C>::iterator::operator<=(const iterator& other) const {
+  return p <= other.p;
+}
+
+template <typename C>
+inline bool MultibindingsView<C>::iterator::operator>(const iterator& other) const {
+  return p > other.p;
+}
+
+template <typename C>
+inline bool MultibindingsView<C>::iterator::operator>=(const iterator& other) const {
+  return p >= other.p;
+}
+
+template <typename C>
+inline MultibindingsView<C>::MultibindingsView(void* const* elems_begin, void* const* elems_end)
+  : elems_begin(elems_begin), elems_end(elems_end) {
+}
+
+template <typename C>
+inline typename MultibindingsView<C>::iterator MultibindingsView<C>::begin() const {
+  return iterator(elems_begin);
+}
+
+template <typename C>
+inline typename MultibindingsView<C>::iterator MultibindingsView<C>::end() const {
+  return iterator(elems_end);
+}
+
+template <typename C>
+inline std::size_t MultibindingsView<C>::size() const {
+  return elems_end - elems_begin;
+}
+
+template <typename C>
+inline bool MultibindingsView<C>::empty() const {
+  return elems_begin == elems_end;
+}
+
+template <typename C>
+inline C* MultibindingsView<C>::operator[](std::size_t i) const {
+  return reinterpret_cast<C*>(elems_begin[i]);
+}
+
+template <typename C>
+inline std::vector<C*> MultibindingsView<C>::toVector() const {
+  return std::vector<C*>(begin(), end());
+}
+
+template <typename C>
+inline LazyMultibindingsView<C>::iterator::iterator(fruit::impl::InjectorStorage* storage, std::size_t elem_index)
+  : storage(storage), elem_index(elem_index) {
+}
+
+template <typename C>
+inline C* LazyMultibindingsView<C>::iterator::operator*() const {
+  return LazyMultibindingsView::getElem(storage, elem_index);
+}
+
+template <typename C>
+inline typename LazyMultibindingsView<C>::iterator& LazyMultibindingsView<C>::iterator::operator++() {
+  ++elem_index;
+  return *this;
+}
+
+template <typename C>
+inline typename LazyMultibindingsView<C>::iterator LazyMultibindingsView<C>::iterator::operator++(int) {
+  iterator result = *this;
+  ++elem_index;
+  return result;
+}
+
+template <typename C>
+inline bool LazyMultibindingsView<C>::iterator::operator==(const iterator& other) const {
+  return elem_index == other.elem_index;
+}
+
+template <typename C>
+inline bool LazyMultibindingsView<C>::iterator::operator!=(const iterator& other) const {
+  return elem_index != other.elem_index;
+}
+
+template <typename C>
+inline LazyMultibindingsView<C>::LazyMultibindingsView(fruit::impl::InjectorStorage* storage,
+                                                       std::size_t elems_begin,
+                                                       std::size_t elems_end)
+  : storage(storage), elems_begin(elems_begin), elems_end(elems_end) {
+}
+
+template <typename C>
+inline C* LazyMultibindingsView<C>::getElem(fruit::impl::InjectorStorage* storage, std::size_t elem_index) {
+  return reinterpret_cast<C*>(storage->getMultibindingObject(elem_index));
+}
+
+template <typename C>
+inline typename LazyMultibindingsView<C>::iterator LazyMultibindingsView<C>::begin() const {
+  return iterator(storage, elems_begin);
+}
+
+template <typename C>
+inline typename LazyMultibindingsView<C>::iterator LazyMultibindingsView<C>::end() const {
+  return iterator(storage, elems_end);
+}
+
+template <typename C>
+inline std::size_t LazyMultibindingsView<C>::size() const {
+  return elems_end - elems_begin;
+}
+
+template <typename C>
+inline bool LazyMultibindingsView<C>::empty() const {
+  return elems_begin == elems_end;
+}
+
+template <typename C>
+inline C* LazyMultibindingsView<C>::operator[](std::size_t i) const {
+  return getElem(storage, elems_begin + i);
+}
+
+template <typename C>
+template <typename Predicate>
+inline C* LazyMultibindingsView<C>::findFirst(Predicate predicate) const {
+  for (std::size_t i = elems_begin; i < elems_end; ++i) {
+    C* c = getElem(storage, i);
+    if (predicate(c)) {
+      return c;
+    }
+  }
+  return nullptr;
+}
+
+} // namespace fruit
+
+#endif // FRUIT_MULTIBINDINGS_VIEW_DEFN_H
@@ -30,7 +30,73 @@ inline NormalizedComponent<Params...>::NormalizedComponent(const Component<Param
         typename fruit::impl::meta::Eval<fruit::impl::meta::SetToVector(
             typename fruit::impl::meta::Eval<
                 fruit::impl::meta::ConstructComponentImpl(fruit::impl::meta::Type<Params>...)
-            >::Ps)>>()) {
+            >::Ps)>>(),
+      NormalizedComponentOptions()) {
+}
+
+template <typename... Params>
+inline NormalizedComponent<Params...>::NormalizedComponent(const Component<Params...>& component,
+                                                           const NormalizedComponentOptions& options)
+  : storage(
+      component.storage,
+      fruit::impl::getTypeIdsForList<
+        typename fruit::impl::meta::Eval<fruit::impl::meta::SetToVector(
+            typename fruit::impl::meta::Eval<
+                fruit::impl::meta::ConstructComponentImpl(fruit::impl::meta::Type<Params>...)
+            >::Ps)>>(),
+      options) {
+}
+
+template <typename... Params>
+inline NormalizedComponent<Params...>::NormalizedComponent(const Component<Params...>& component, std::size_t num_threads)
+  : NormalizedComponent(component, [num_threads]() {
+      NormalizedComponentOptions options;
+      options.num_threads = num_threads;
+      return options;
+    }()) {
+}
+template <typename... Params>
+inline NormalizedComponent<Params...>::NormalizedComponent(const Component<Params...>& component,
+                                                           MemoryResource& memory_resource)
+  : storage(
+      component.storage,
+      fruit::impl::getTypeIdsForList<
+        typename fruit::impl::meta::Eval<fruit::impl::meta::SetToVector(
+            typename fruit::impl::meta::Eval<
+                fruit::impl::meta::ConstructComponentImpl(fruit::impl::meta::Type<Params>...)
+            >::Ps)>>(),
+      NormalizedComponentOptions(),
+      &memory_resource) {
+}
+
+template <typename... Params>
+inline std::size_t NormalizedComponent<Params...>::getNumPrunedBindings() const {
+  return storage.getNumPrunedBindings();
+}
+
+template <typename... Params>
+inline std::size_t NormalizedComponent<Params...>::getNumPrunedBytes() const {
+  return storage.getNumPrunedBytes();
+}
+
+template <typename... Params>
+inline std::size_t NormalizedComponent<Params...>::getNumHoistedBindings() const {
+  return storage.getNumHoistedBindings();
+}
+
+template <typename... Params>
+inline BindingLookupStatistics NormalizedComponent<Params...>::getBindingLookupStatistics() const {
+  return storage.getBindingLookupStatistics();
+}
+
+template <typename... Params>
+inline std::size_t NormalizedComponent<Params...>::getNumAllocatorCacheHits() const {
+  return storage.getNumChunkCacheHits();
+}
+
+template <typename... Params>
+inline std::size_t NormalizedComponent<Params...>::getNumAllocatorCacheMisses() const {
+  return storage.getNumChunkCacheMisses();
 }
 
 } // namespace fruit
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRUIT_PREPARED_INJECTOR_DEFN_H
+#define FRUIT_PREPARED_INJECTOR_DEFN_H
+
+#include <fruit/impl/util/type_info.h>
+
+// Redundant, but makes KDevelop happy.
+#include <fruit/prepared_injector.h>
+
+namespace fruit {
+
+template <typename... P>
+template <typename... NormalizedComponentParams, typename... ComponentParams>
+inline PreparedInjector<P...>::PreparedInjector(const NormalizedComponent<NormalizedComponentParams...>& normalized_component,
+                                                Component<ComponentParams...> component)
+  : storage(*(normalized_component.storage.storage),
+            std::move(component.storage), 
+            fruit::impl::getTypeIdsForList<fruit::impl::meta::Eval<
+                fruit::impl::meta::ConcatVectors(
+                   fruit::impl::meta::SetToVector(fruit::impl::meta::GetComponentPs(fruit::impl::meta::ConstructComponentImpl(fruit::impl::meta::Type<ComponentParams>...))),
+                   fruit::impl::meta::SetToVector(fruit::impl::meta::GetComponentPs(fruit::impl::meta::ConstructComponentImpl(fruit::impl::meta::Type<NormalizedComponentParams>...))))
+            >>()) {
+    
+  using NormalizedComp = fruit::impl::meta::ConstructComponentImpl(fruit::impl::meta::Type<NormalizedComponentParams>...);
+  using Comp1 = fruit::impl::meta::ConstructComponentImpl(fruit::impl::meta::Type<ComponentParams>...);
+  // We don't check whether the construction of NormalizedComp or Comp resulted in errors here; if they did, the instantiation
+  // of NormalizedComponent<NormalizedComponentParams...> or Component<ComponentParams...> would have resulted in an error already.
+  
+  using E = typename fruit::impl::meta::InjectorImplHelper<P...>::template CheckConstructionFromNormalizedComponent<NormalizedComp, Comp1>::type;
+  (void)typename fruit::impl::meta::CheckIfError<E>::type();
+}
+
+} // namespace fruit
+
+#endif // FRUIT_PREPARED_INJECTOR_DEFN_H
@@ -53,6 +53,7 @@ private:
   
   friend class NormalizedComponentStorage;
   friend class InjectorStorage;
+  friend class PreparedInjectorStorage;
 
 public:
   ~ComponentStorage();
@@ -20,6 +20,7 @@
 #include <fruit/impl/util/demangle_type_name.h>
 #include <fruit/impl/util/type_info.h>
 #include <fruit/impl/util/lambda_invoker.h>
+#include <fruit/impl/util/memory_resource_allocator.h>
 #include <fruit/impl/fruit_assert.h>
 #include <fruit/impl/meta/vector.h>
 #include <fruit/impl/meta/component.h>
@@ -154,7 +155,7 @@ inline T InjectorStorage::get(InjectorStorage::Graph::node_iterator node_iterato
 
 template <typename AnnotatedC>
 inline InjectorStorage::Graph::node_iterator InjectorStorage::lazyGetPtr() {
-  return lazyGetPtr(getTypeId<AnnotatedC>());
+  return bindings.atDenseIndex(getDenseTypeIndex<AnnotatedC>(), getTypeId<AnnotatedC>());
 }
 
 template <typename AnnotatedC>
@@ -186,7 +187,7 @@ inline InjectorStorage::Graph::node_iterator InjectorStorage::lazyGetPtr(TypeId
 inline void* InjectorStorage::unsafeGetPtr(TypeId type) {
   Graph::node_iterator itr = bindings.find(type);
   if (itr == bindings.end()) {
-    return nullptr;
+    return parent != nullptr ? parent->unsafeGetPtr(type) : nullptr;
   }
   return getPtrInternal(itr);
 }
@@ -203,50 +204,99 @@ inline const std::vector<InjectorStorage::RemoveAnnotations<AnnotatedC>*>& Injec
   }
 }
 
+template <typename AnnotatedC>
+inline const std::vector<InjectorStorage::RemoveAnnotations<AnnotatedC>*>&
+InjectorStorage::getMultibindingsParallel(std::size_t num_threads) {
+  constructMultibindingsInParallel(getTypeId<AnnotatedC>(), num_threads);
+  // This only creates the vector, all the objects are already constructed.
+  return getMultibindings<AnnotatedC>();
+}
+
+template <typename AnnotatedC>
+inline MultibindingsView<InjectorStorage::RemoveAnnotations<AnnotatedC>> InjectorStorage::getMultibindingsView() {
+  std::pair<void* const*, void* const*> objects = getMultibindingObjects(getTypeId<AnnotatedC>());
+  return MultibindingsView<RemoveAnnotations<AnnotatedC>>(objects.first, objects.second);
+}
+
+template <typename AnnotatedC>
+inline LazyMultibindingsView<InjectorStorage::RemoveAnnotations<AnnotatedC>> InjectorStorage::getLazyMultibindings() {
+  std::size_t elems_begin;
+  std::size_t elems_end;
+  InjectorStorage* storage = findMultibindingElems(getTypeId<AnnotatedC>(), elems_begin, elems_end);
+  return LazyMultibindingsView<RemoveAnnotations<AnnotatedC>>(storage, elems_begin, elems_end);
+}
+
+inline std::size_t InjectorStorage::getObjectOffset(Graph::node_iterator node_itr) const {
+  std::size_t index = bindings.indexOf(node_itr);
+  if (index >= num_object_offsets || object_offsets[index] == no_object_offset) {
+    return FixedSizeAllocator::no_object_offset;
+  }
+  return object_offsets[index];
+}
+
 inline void* InjectorStorage::getPtrInternal(Graph::node_iterator node_itr) {
   NormalizedBindingData& bindingData = node_itr.getNode();
-  if (!node_itr.isTerminal()) {
-    bindingData.create(*this, node_itr);
-    FruitAssert(node_itr.isTerminal());
+  if (thread_safe) {
+    if (!node_itr.isTerminalAcquire()) {
+      if (iterative_construction) {
+        constructIteratively(node_itr);
+      } else {
+        constructNodeConcurrently(node_itr);
+      }
+    }
+  } else if (!node_itr.isTerminal()) {
+    if (iterative_construction) {
+      constructIteratively(node_itr);
+    } else {
+      constructNode(node_itr);
+    }
   }
   return bindingData.getObject();
 }
 
-inline NormalizedMultibindingData* InjectorStorage::getNormalizedMultibindingData(TypeId type) {
-  auto itr = multibindings.find(type);
-  if (itr != multibindings.end())
-    return &(itr->second);
-  else
-    return nullptr;
+inline void InjectorStorage::constructNode(Graph::node_iterator node_itr) {
+  NormalizedBindingData& bindingData = node_itr.getNode();
+  if (reset_enabled) {
+    // The state of the node is saved before the construction, so that reset() can restore it.
+    ConstructedNode constructed_node{node_itr, bindingData, node_itr.neighborsBegin()};
+    bindingData.create(*this, node_itr);
+    node_itr.setTerminal();
+    constructed_nodes.push_back(constructed_node);
+    return;
+  }
+  constructed_before_enable_reset.store(true, std::memory_order_relaxed);
+  bindingData.create(*this, node_itr);
+  node_itr.setTerminal();
+}
+
+inline const NormalizedMultibindingData* InjectorStorage::getNormalizedMultibindingData(TypeId type) {
+  return multibindings->find(type);
 }
 
 template <typename AnnotatedC>
-inline std::shared_ptr<char> InjectorStorage::createMultibindingVector(InjectorStorage& storage) {
+inline std::shared_ptr<char> InjectorStorage::createMultibindingVector(InjectorStorage& storage,
+                                                                       const NormalizedMultibindingData& multibinding) {
   using C = RemoveAnnotations<AnnotatedC>;
-  TypeId type = getTypeId<AnnotatedC>();
-  NormalizedMultibindingData* multibinding = storage.getNormalizedMultibindingData(type);
-  
-  // This method is only called if there was at least 1 multibinding (otherwise the would-be caller would have returned nullptr
-  // instead of calling this).
-  FruitAssert(multibinding != nullptr);
-  
-  if (multibinding->v.get() != nullptr) {
+  std::shared_ptr<char>& cached_vector = storage.multibinding_vectors[multibinding.type_index];
+  if (cached_vector.get() != nullptr) {
     // Result cached, return early.
-    return multibinding->v;
+    return cached_vector;
   }
   
-  storage.ensureConstructedMultibinding(*multibinding);
+  storage.ensureConstructedMultibinding(multibinding);
   
   std::vector<C*> s;
-  s.reserve(multibinding->elems.size());
-  for (const NormalizedMultibindingData::Elem& elem : multibinding->elems) {
-    s.push_back(reinterpret_cast<C*>(elem.object));
+  s.reserve(multibinding.elems_end - multibinding.elems_begin);
+  for (std::size_t i = multibinding.elems_begin; i < multibinding.elems_end; ++i) {
+    s.push_back(reinterpret_cast<C*>(storage.multibinding_objects[i]));
   }
   
-  std::shared_ptr<std::vector<C*>> vector_ptr = std::make_shared<std::vector<C*>>(std::move(s));
+  // The elements of the vector are allocated with operator new, since getMultibindings() returns a std::vector<C*>.
+  std::shared_ptr<std::vector<C*>> vector_ptr = std::allocate_shared<std::vector<C*>>(
+      MemoryResourceAllocator<std::vector<C*>>(storage.memory_resource), std::move(s));
   std::shared_ptr<char> result(vector_ptr, reinterpret_cast<char*>(vector_ptr.get()));
   
-  multibinding->v = result;
+  cached_vector = result;
   
   return result;
 }
@@ -261,13 +311,12 @@ inline std::tuple<TypeId, BindingData> InjectorStorage::createBindingDataForBind
   auto create = [](InjectorStorage& injector, Graph::node_iterator node_itr) {
     InjectorStorage::Graph::node_iterator bindings_begin = injector.bindings.begin();
     C* cPtr = injector.get<C*>(injector.lazyGetPtr<AnnotatedC>(node_itr.neighborsBegin(), 0, bindings_begin));
-    node_itr.setTerminal();
     // This step is needed when the cast C->I changes the pointer
     // (e.g. for multiple inheritance).
     I* iPtr = static_cast<I*>(cPtr);
     return reinterpret_cast<BindingData::object_t>(iPtr);
   };
-  return std::make_tuple(getTypeId<AnnotatedI>(), BindingData(create, getBindingDeps<fruit::impl::meta::Vector<fruit::impl::meta::Type<AnnotatedC>>>(), false /* needs_allocation */));
+  return std::make_tuple(getTypeId<AnnotatedI>(), BindingData(getCreateData<fruit::impl::meta::Vector<fruit::impl::meta::Type<AnnotatedC>>>(create), false /* needs_allocation */));
 }
 
 template <typename AnnotatedC, typename C>
@@ -322,8 +371,10 @@ struct InvokeLambdaWithInjectedArgVector<AnnotatedSignature, Lambda, true /* lam
         ...);
   }
 
+  // object_offset is unused, the object is allocated by the lambda.
   CPtr operator()(InjectorStorage& injector, SemistaticGraph<TypeId, NormalizedBindingData>& bindings,
-                  FixedSizeAllocator& allocator, InjectorStorage::Graph::edge_iterator deps) {
+                  FixedSizeAllocator& allocator, std::size_t /* object_offset */,
+                  InjectorStorage::Graph::edge_iterator deps) {
     // `deps' *is* used below, but when there are no AnnotatedArgs some compilers report it as unused.
     (void)deps;
     
@@ -360,16 +411,17 @@ struct InvokeLambdaWithInjectedArgVector<AnnotatedSignature, Lambda, false /* la
   // with the get() calls). The lazyGetPtr() calls don't branch, while the get() calls branch on the result of the
   // lazyGetPtr()s, so it's faster to execute them in this order.
   template <typename... NodeItrs>
-  C* constructHelper(InjectorStorage& injector, FixedSizeAllocator& allocator, NodeItrs... nodeItrs) {
+  C* constructHelper(InjectorStorage& injector, FixedSizeAllocator& allocator, std::size_t object_offset,
+                     NodeItrs... nodeItrs) {
 	// `injector' *is* used below, but when there are no AnnotatedArgs some compilers report it as unused.
 	(void)injector;
-	return allocator.constructObject<AnnotatedC, C&&>(LambdaInvoker::invoke<Lambda, InjectorStorage::RemoveAnnotations<fruit::impl::meta::UnwrapType<AnnotatedArgs>>...>(
+	return allocator.constructObjectAt<AnnotatedC, C&&>(object_offset, LambdaInvoker::invoke<Lambda, InjectorStorage::RemoveAnnotations<fruit::impl::meta::UnwrapType<AnnotatedArgs>>...>(
         injector.get<InjectorStorage::RemoveAnnotations<fruit::impl::meta::UnwrapType<AnnotatedArgs>>>(nodeItrs)
         ...));
   }
 
   C* operator()(InjectorStorage& injector, SemistaticGraph<TypeId, NormalizedBindingData>& bindings,
-                FixedSizeAllocator& allocator, InjectorStorage::Graph::edge_iterator deps) {
+                FixedSizeAllocator& allocator, std::size_t object_offset, InjectorStorage::Graph::edge_iterator deps) {
     InjectorStorage::Graph::node_iterator bindings_begin = bindings.begin();
     // `bindings_begin' *is* used below, but when there are no AnnotatedArgs some compilers report it as unused.
     (void) bindings_begin;
@@ -379,7 +431,7 @@ struct InvokeLambdaWithInjectedArgVector<AnnotatedSignature, Lambda, false /* la
     
 	// `injector' *is* used below, but when there are no AnnotatedArgs some compilers report it as unused.
 	(void)injector;
-	C* p = constructHelper(injector, allocator,
+	C* p = constructHelper(injector, allocator, object_offset,
         injector.lazyGetPtr<InjectorStorage::NormalizeType<fruit::impl::meta::UnwrapType<AnnotatedArgs>>>(deps, Indexes::value, bindings_begin)
         ...);
     return p;
@@ -399,13 +451,13 @@ inline std::tuple<TypeId, BindingData> InjectorStorage::createBindingDataForProv
   using C          = NormalizeType<T>;
   auto create = [](InjectorStorage& injector, Graph::node_iterator node_itr) {
     C* cPtr = InvokeLambdaWithInjectedArgVector<AnnotatedSignature, Lambda, std::is_pointer<T>::value>()(
-        injector, injector.bindings, injector.allocator, node_itr.neighborsBegin());
-    node_itr.setTerminal();
+        injector, injector.bindings, injector.allocator, injector.getObjectOffset(node_itr),
+        node_itr.neighborsBegin());
     return reinterpret_cast<BindingData::object_t>(cPtr);
   };
-  const BindingDeps* deps = getBindingDeps<NormalizedSignatureArgs<AnnotatedSignature>>();
+  const BindingData::CreateData* create_data = getCreateData<SignatureArgs<AnnotatedSignature>>(create);
   bool needs_allocation = !std::is_pointer<T>::value;
-  return std::make_tuple(getTypeId<AnnotatedC>(), BindingData(create, deps, needs_allocation));
+  return std::make_tuple(getTypeId<AnnotatedC>(), BindingData(create_data, needs_allocation));
 }
 
 template <typename AnnotatedSignature, typename Lambda, typename AnnotatedI>
@@ -422,14 +474,14 @@ inline std::tuple<TypeId, TypeId, BindingData> InjectorStorage::createBindingDat
   using I          = RemoveAnnotations<AnnotatedI>;
   auto create = [](InjectorStorage& injector, Graph::node_iterator node_itr) {
     C* cPtr = InvokeLambdaWithInjectedArgVector<AnnotatedSignature, Lambda, std::is_pointer<T>::value>()(
-        injector, injector.bindings, injector.allocator, node_itr.neighborsBegin());
-    node_itr.setTerminal();
+        injector, injector.bindings, injector.allocator, injector.getObjectOffset(node_itr),
+        node_itr.neighborsBegin());
     I* iPtr = static_cast<I*>(cPtr);
     return reinterpret_cast<BindingData::object_t>(iPtr);
   };
-  const BindingDeps* deps = getBindingDeps<NormalizedSignatureArgs<AnnotatedSignature>>();
+  const BindingData::CreateData* create_data = getCreateData<SignatureArgs<AnnotatedSignature>>(create);
   bool needs_allocation = !std::is_pointer<T>::value;
-  return std::make_tuple(getTypeId<AnnotatedI>(), getTypeId<AnnotatedC>(), BindingData(create, deps, needs_allocation));
+  return std::make_tuple(getTypeId<AnnotatedI>(), getTypeId<AnnotatedC>(), BindingData(create_data, needs_allocation));
 }
 
 // The inner operator() takes an InjectorStorage& and a Graph::edge_iterator (the type's deps) and
@@ -450,16 +502,18 @@ struct InvokeConstructorWithInjectedArgVector<AnnotatedC(AnnotatedArgs...), frui
   // with the get() calls). The lazyGetPtr() calls don't branch, while the get() calls branch on the result of the
   // lazyGetPtr()s, so it's faster to execute them in this order.
   template <typename... NodeItrs>
-  C* constructHelper(InjectorStorage& injector, FixedSizeAllocator& allocator, NodeItrs... nodeItrs) {
+  C* constructHelper(InjectorStorage& injector, FixedSizeAllocator& allocator, std::size_t object_offset,
+                     NodeItrs... nodeItrs) {
 	// `injector' *is* used below, but when there are no AnnotatedArgs some compilers report it as unused.
 	(void)injector;
-    return allocator.constructObject<AnnotatedC, InjectorStorage::RemoveAnnotations<AnnotatedArgs>...>(
+    return allocator.constructObjectAt<AnnotatedC, InjectorStorage::RemoveAnnotations<AnnotatedArgs>...>(
+        object_offset,
         injector.get<InjectorStorage::RemoveAnnotations<AnnotatedArgs>>(nodeItrs)
         ...);
   }
 
   C* operator()(InjectorStorage& injector, SemistaticGraph<TypeId, NormalizedBindingData>& bindings,
-                FixedSizeAllocator& allocator, InjectorStorage::Graph::edge_iterator deps) {
+                FixedSizeAllocator& allocator, std::size_t object_offset, InjectorStorage::Graph::edge_iterator deps) {
     
     // `deps' *is* used below, but when there are no Args some compilers report it as unused.
     (void)deps;
@@ -467,7 +521,7 @@ struct InvokeConstructorWithInjectedArgVector<AnnotatedC(AnnotatedArgs...), frui
     InjectorStorage::Graph::node_iterator bindings_begin = bindings.begin();
     // `bindings_begin' *is* used below, but when there are no Args some compilers report it as unused.
     (void) bindings_begin;
-    C* p = constructHelper(injector, allocator,
+    C* p = constructHelper(injector, allocator, object_offset,
         injector.lazyGetPtr<InjectorStorage::NormalizeType<AnnotatedArgs>>(deps, Indexes::value, bindings_begin)
         ...);
     return p;
@@ -480,12 +534,12 @@ inline std::tuple<TypeId, BindingData> InjectorStorage::createBindingDataForCons
   using C          = RemoveAnnotations<AnnotatedC>;
   auto create = [](InjectorStorage& injector, Graph::node_iterator node_itr) {
     C* cPtr = InvokeConstructorWithInjectedArgVector<AnnotatedSignature>()(injector, 
-                  injector.bindings, injector.allocator, node_itr.neighborsBegin());
-    node_itr.setTerminal();
+                  injector.bindings, injector.allocator, injector.getObjectOffset(node_itr),
+                  node_itr.neighborsBegin());
     return reinterpret_cast<BindingData::object_t>(cPtr);
   };
-  const BindingDeps* deps = getBindingDeps<NormalizedSignatureArgs<AnnotatedSignature>>();
-  return std::make_tuple(getTypeId<AnnotatedC>(), BindingData(create, deps, true /* needs_allocation */));
+  const BindingData::CreateData* create_data = getCreateData<SignatureArgs<AnnotatedSignature>>(create);
+  return std::make_tuple(getTypeId<AnnotatedC>(), BindingData(create_data, true /* needs_allocation */));
 }
 
 template <typename AnnotatedSignature, typename AnnotatedI>
@@ -495,13 +549,13 @@ inline std::tuple<TypeId, TypeId, BindingData> InjectorStorage::createBindingDat
   using I          = RemoveAnnotations<AnnotatedI>;
   auto create = [](InjectorStorage& injector, Graph::node_iterator node_itr) {
     C* cPtr = InvokeConstructorWithInjectedArgVector<AnnotatedSignature>()(injector, 
-                  injector.bindings, injector.allocator, node_itr.neighborsBegin());
-    node_itr.setTerminal();
+                  injector.bindings, injector.allocator, injector.getObjectOffset(node_itr),
+                  node_itr.neighborsBegin());
     I* iPtr = static_cast<I*>(cPtr);
     return reinterpret_cast<BindingData::object_t>(iPtr);
   };
-  const BindingDeps* deps = getBindingDeps<NormalizedSignatureArgs<AnnotatedSignature>>();
-  return std::make_tuple(getTypeId<AnnotatedI>(), getTypeId<AnnotatedC>(), BindingData(create, deps, true /* needs_allocation */));
+  const BindingData::CreateData* create_data = getCreateData<SignatureArgs<AnnotatedSignature>>(create);
+  return std::make_tuple(getTypeId<AnnotatedI>(), getTypeId<AnnotatedC>(), BindingData(create_data, true /* needs_allocation */));
 }
 
 template <typename AnnotatedI, typename AnnotatedC>
@@ -543,7 +597,7 @@ inline std::tuple<TypeId, MultibindingData> InjectorStorage::createMultibindingD
   };
   bool needs_allocation = !std::is_pointer<T>::value;
   return std::make_tuple(getTypeId<AnnotatedC>(),
-                         MultibindingData(create, getBindingDeps<NormalizedSignatureArgs<AnnotatedSignature>>(), InjectorStorage::createMultibindingVector<AnnotatedC>,
+                         MultibindingData(create, getBindingDeps<SignatureArgs<AnnotatedSignature>>(), InjectorStorage::createMultibindingVector<AnnotatedC>,
                                           needs_allocation));
 }
 
@@ -21,9 +21,12 @@
 #include <fruit/impl/binding_data.h>
 #include <fruit/impl/data_structures/fixed_size_allocator.h>
 #include <fruit/impl/meta/component.h>
+#include <fruit/impl/util/memory_resource_allocator.h>
 
+#include <atomic>
+#include <cstdint>
 #include <vector>
-#include <unordered_map>
+#include <mutex>
 
 namespace fruit {
   
@@ -46,6 +49,10 @@ public:
                                    std::vector<std::pair<TypeId, MultibindingData>>>;
   using Graph = SemistaticGraph<TypeId, NormalizedBindingData>;
   
+  // Used in the object_offsets side array of a NormalizedComponentStorage for the objects that are not in the fixed
+  // layout of the injectors' FixedSizeAllocator.
+  static constexpr std::uint32_t no_object_offset = ~std::uint32_t(0);
+  
   template <typename AnnotatedT>
   using RemoveAnnotations = fruit::impl::meta::UnwrapType<fruit::impl::meta::Eval<
       fruit::impl::meta::RemoveAnnotations(fruit::impl::meta::Type<AnnotatedT>)
@@ -62,8 +69,8 @@ public:
       >>;
       
   template <typename Signature>
-  using NormalizedSignatureArgs = fruit::impl::meta::Eval<
-      fruit::impl::meta::NormalizeTypeVector(fruit::impl::meta::SignatureArgs(fruit::impl::meta::Type<Signature>))
+  using SignatureArgs = fruit::impl::meta::Eval<
+      fruit::impl::meta::SignatureArgs(fruit::impl::meta::Type<Signature>)
       >;
   
   // Prints the specified error and calls exit(1).
@@ -106,26 +113,129 @@ public:
   static std::tuple<TypeId, MultibindingData> createMultibindingDataForProvider();
 
 private:
+  // The resource where the allocator's memory, the graph and the multibinding vectors are allocated, or nullptr to use
+  // operator new. This is declared first since the fields below use it.
+  MemoryResource* memory_resource = nullptr;
+  
   // The NormalizedComponentStorage owned by this object (if any).
   // Only used for the 1-argument constructor, otherwise it's nullptr.
   std::unique_ptr<NormalizedComponentStorage> normalized_component_storage_ptr;
   
   FixedSizeAllocator allocator;
   
+  // The object offsets of the NormalizedComponentStorage that `bindings' was copied from (see
+  // NormalizedComponentStorage::object_offsets), or nullptr if there's none. The nodes at positions
+  // >=num_object_offsets were added by this injector, so their objects are not in the fixed layout.
+  // The node of the I type of an undone binding compression keeps the offset of the C object, but it's unused since
+  // the binding for I doesn't allocate anything.
+  const std::uint32_t* object_offsets = nullptr;
+  std::size_t num_object_offsets = 0;
+  
   // A graph with injected types as nodes (each node stores the NormalizedBindingData for the type) and dependencies as edges.
   // For types that have a constructed object already, the corresponding node is stored as terminal node.
   SemistaticGraph<TypeId, NormalizedBindingData> bindings;
   
-  // Maps the type index of a type T to the corresponding NormalizedMultibindingData object (that stores all multibindings).
-  std::unordered_map<TypeId, NormalizedMultibindingData> multibindings;
+  // The multibindings of this injector. This points to the multibindings of the NormalizedComponentStorage or
+  // PreparedInjectorStorage used to create this injector, or to owned_multibindings.
+  const NormalizedMultibindingSet* multibindings = nullptr;
+  
+  // The multibindings owned by this object (if any). Only used if this injector adds multibindings to the ones of the
+  // NormalizedComponentStorage, or if this is a child injector.
+  std::unique_ptr<NormalizedMultibindingSet> owned_multibindings;
+  
+  // multibinding_objects[i] is the object for multibindings->elems[i], or nullptr if it hasn't been constructed yet.
+  FixedSizeVector<MultibindingData::object_t> multibinding_objects;
+  
+  // multibinding_vectors[i] is the (casted) std::vector<T*> for the type multibindings->types[i], or nullptr if it hasn't
+  // been created yet.
+  std::vector<std::shared_ptr<char>, MemoryResourceAllocator<std::shared_ptr<char>>> multibinding_vectors;
+  
+  // Information needed to undo the construction of the object for a node of `bindings', see reset().
+  struct ConstructedNode {
+    Graph::node_iterator node_itr;
+    
+    // The binding data and the neighbors of the node before it was turned into a terminal node.
+    NormalizedBindingData binding_data;
+    Graph::edge_iterator neighbors_begin;
+  };
+  
+  // The nodes of `bindings' that were turned into terminal nodes when constructing their object, in construction order.
+  // Each node is constructed at most once, so the capacity of this vector is the number of nodes in `bindings'.
+  // This is only allocated (and filled) after enableReset().
+  FixedSizeVector<ConstructedNode> constructed_nodes;
+  
+  // If this is true, constructed_nodes is allocated and the constructed nodes are recorded there. See enableReset().
+  bool reset_enabled = false;
+  
+  // Set when the object of a node is constructed while reset_enabled is false, so that enableReset() can report an error
+  // (reset() couldn't restore that node). This is atomic because in thread-safe mode it can be set by several threads.
+  std::atomic<bool> constructed_before_enable_reset{false};
+  
+  // If this is true, the graph nodes are accessed using the atomic methods of node_iterator, and a non-terminal node is
+  // locked while its object is being constructed. See enableThreadSafety().
+  bool thread_safe = false;
+  
+  // If this is true, objects are constructed by constructIteratively() instead of recursively. See
+  // enableIterativeConstruction().
+  bool iterative_construction = false;
+  
+  // A node being constructed by constructIteratively().
+  struct ConstructionFrame {
+    Graph::node_iterator node_itr;
+    
+    // The deps of the node, or nullptr if the node hasn't been visited yet. In thread-safe mode, the node is locked by
+    // this thread iff this is not nullptr.
+    const BindingDeps* deps;
+    
+    // The index of the next dep of node_itr to check.
+    std::size_t next_dep_index;
+  };
+  
+  // The stack used by constructIteratively() when thread_safe is false, kept here so that its memory is reused by
+  // later constructions. In thread-safe mode, each thread uses its own stack instead.
+  std::vector<ConstructionFrame> construction_stack;
+  
+  // Only used if thread_safe is true, protects `multibindings'.
+  std::mutex multibindings_mutex;
+  
+  // The parent injector, if this is a child injector (see the constructor that takes a parent InjectorStorage).
+  // Otherwise nullptr.
+  InjectorStorage* parent = nullptr;
+  
+  // A type that is bound in `parent' and injected in this (child) injector.
+  struct ParentBinding {
+    TypeId type;
+    
+    // Deps with num_deps==0, but with deps[0]==type, so that createFromParent() can find the type from the node.
+    BindingDeps deps;
+    
+    // The create data of the node, with createFromParent() and `deps'.
+    BindingData::CreateData create_data;
+  };
+  
+  // Each of these has a node in `bindings', with createFromParent() as create operation.
+  // This vector is never resized after the construction (the nodes point to its elements).
+  std::vector<ParentBinding> parent_bindings;
   
 private:
   
   template <typename AnnotatedC>
-  static std::shared_ptr<char> createMultibindingVector(InjectorStorage& storage);
+  static std::shared_ptr<char> createMultibindingVector(InjectorStorage& storage,
+                                                        const NormalizedMultibindingData& multibinding_data);
+  
+  // Initializes multibinding_objects and multibinding_vectors, once `multibindings' has been set.
+  void initMultibindingState();
+  
+  // Returns the offset of the object of node_itr in the allocator's fixed layout, or FixedSizeAllocator::no_object_offset
+  // if the object is not in the fixed layout.
+  std::size_t getObjectOffset(Graph::node_iterator node_itr) const;
+  
+  // The create operation of the nodes for the types in parent_bindings: returns the object in the parent injector
+  // (constructing it if needed). The object is owned by the parent injector, so it's not destroyed by this injector.
+  static BindingData::object_t createFromParent(InjectorStorage& storage, Graph::node_iterator node_itr);
   
   // If not bound, returns nullptr.
-  NormalizedMultibindingData* getNormalizedMultibindingData(TypeId type);
+  const NormalizedMultibindingData* getNormalizedMultibindingData(TypeId type);
   
   // Looks up the location where the type is (or will be) stored, but does not construct the class.
   template <typename AnnotatedC>
@@ -138,6 +248,23 @@ private:
   // Similar to the previous, but takes a node_iterator. Use this when the node_iterator is known, it's faster.
   void* getPtrInternal(Graph::node_iterator itr);
   
+  // Used by getPtrInternal() in thread-safe mode when the node is not (yet) terminal. Constructs the object, or waits for
+  // another thread that is already constructing it.
+  void constructNodeConcurrently(Graph::node_iterator itr);
+  
+  // Constructs the object for a non-terminal node and turns the node into a terminal one. Not thread-safe.
+  void constructNode(Graph::node_iterator itr);
+  
+  // Constructs the object for a node locked by this thread (see node_iterator::tryLock()) and turns the node into a
+  // terminal (unlocked) one. If the construction throws, the node is left locked.
+  void constructLockedNode(Graph::node_iterator itr);
+  
+  // Used by getPtrInternal() instead of constructing the object directly when iterative_construction is true.
+  // Walks the non-lazy dependencies of the node (in post-order, using an explicit stack) and constructs the objects in
+  // that order, so that when a create operation is called its dependencies have already been constructed and it doesn't
+  // recurse into this method.
+  void constructIteratively(Graph::node_iterator itr);
+  
   // getPtr(typeInfo) is equivalent to getPtr(lazyGetPtr(typeInfo)).
   Graph::node_iterator lazyGetPtr(TypeId type);
   
@@ -152,8 +279,24 @@ private:
   // Returns a std::vector<T*>*, or nullptr if there are no multibindings.
   void* getMultibindings(TypeId type);
   
+  // Constructs the multibindings of `type' (if needed) and returns the range of multibinding_objects where they're stored.
+  // Returns an empty range if there are no multibindings.
+  std::pair<void* const*, void* const*> getMultibindingObjects(TypeId type);
+  
+  // Finds the multibindings of `type' without constructing them. Sets [elems_begin, elems_end) to the range of their
+  // indexes in the multibindings of the returned InjectorStorage, that's this one or (for child injectors) an ancestor.
+  // If there are no multibindings, the range is empty.
+  InjectorStorage* findMultibindingElems(TypeId type, std::size_t& elems_begin, std::size_t& elems_end);
+  
+  // Constructs the object for multibindings->elems[elem_index] (if needed) and returns it.
+  MultibindingData::object_t getMultibindingObject(std::size_t elem_index);
+  
+  // Enables thread safety and constructs the multibindings of `type' that are not constructed yet using num_threads
+  // threads (or std::thread::hardware_concurrency() if num_threads is 0).
+  void constructMultibindingsInParallel(TypeId type, std::size_t num_threads);
+  
   // Constructs any necessary instances, but NOT the instance set.
-  void ensureConstructedMultibinding(NormalizedMultibindingData& multibinding_data);
+  void ensureConstructedMultibinding(const NormalizedMultibindingData& multibinding_data);
   
   template <typename T>
   friend struct GetHelper;
@@ -161,6 +304,26 @@ private:
   template <typename T>
   friend class fruit::Provider;
   
+  template <typename C>
+  friend class fruit::LazyMultibindingsView;
+  
+  friend class PreparedInjectorStorage;
+  friend class NormalizedComponentStorage;
+  
+  // Performs the first steps of the construction of an injector from a NormalizedComponentStorage and a ComponentStorage:
+  // normalizes the bindings in `component', removes the ones already in `normalized_component' and undoes any binding
+  // compressions in `normalized_component' that are no longer valid.
+  // Returns the bindings that must be added to normalized_component.bindings.
+  static std::vector<std::pair<TypeId, BindingData>> normalizeComponentBindings(
+      const NormalizedComponentStorage& normalized_component,
+      const ComponentStorage& component,
+      std::vector<TypeId>&& exposed_types,
+      FixedSizeAllocator::FixedSizeAllocatorData& fixed_size_allocator_data);
+  
+  // Creates an injector with just the bindings of `normalized_component' (that can still have requirements).
+  // Used by NormalizedComponentStorage to construct the objects of the hoisted request-independent bindings.
+  InjectorStorage(const NormalizedComponentStorage& normalized_component, MemoryResource* memory_resource);
+  
 public:
   
   // Wraps a std::vector<std::pair<TypeId, BindingData>>::iterator as an iterator on tuples
@@ -184,11 +347,34 @@ public:
     const TypeId* getEdgesEnd();
   };
   
-  InjectorStorage(const ComponentStorage& storage, const std::vector<TypeId>& exposed_types);
+  // If memory_resource is not nullptr, the injector's memory is allocated from it (see fruit::MemoryResource).
+  InjectorStorage(const ComponentStorage& storage, const std::vector<TypeId>& exposed_types,
+                  MemoryResource* memory_resource = nullptr);
   
   InjectorStorage(const NormalizedComponentStorage& normalized_storage, 
                   const ComponentStorage& storage,
-                  std::vector<TypeId>&& exposed_types);
+                  std::vector<TypeId>&& exposed_types,
+                  MemoryResource* memory_resource = nullptr);
+  
+  // Creates an injector from a PreparedInjectorStorage and a component with the same bindings as the one used to construct
+  // the PreparedInjectorStorage (except that instance bindings can bind different objects).
+  // This only copies the prepared graph and fills in the objects of the instance bindings, so it's much faster than the
+  // constructor above.
+  InjectorStorage(const PreparedInjectorStorage& prepared_storage,
+                  const ComponentStorage& storage,
+                  MemoryResource* memory_resource = nullptr);
+  
+  // Creates a child injector of `parent', with the bindings in `component'. The graph of this injector only contains
+  // the bindings in `component' and a node for each type that they (or exposed_types) need and that is only bound in
+  // `parent', so the cost of this doesn't depend on the number of bindings in `parent'. Those types (and any type
+  // passed to unsafeGetPtr() or getMultibindings() that this injector doesn't bind) are looked up in `parent', so the
+  // objects of `parent' are shared instead of being constructed again. A binding in `component' for a type also bound
+  // in `parent' overrides the parent's binding in this injector.
+  // `parent' must outlive this object.
+  InjectorStorage(InjectorStorage& parent,
+                  const ComponentStorage& component,
+                  const std::vector<TypeId>& exposed_types,
+                  MemoryResource* memory_resource = nullptr);
   
   // This is just the default destructor, but we declare it here to avoid including
   // normalized_component_storage.h in fruit.h.
@@ -224,7 +410,45 @@ public:
   template <typename AnnotatedC>
   const std::vector<RemoveAnnotations<AnnotatedC>*>& getMultibindings();
   
+  template <typename AnnotatedC>
+  MultibindingsView<RemoveAnnotations<AnnotatedC>> getMultibindingsView();
+  
+  template <typename AnnotatedC>
+  LazyMultibindingsView<RemoveAnnotations<AnnotatedC>> getLazyMultibindings();
+  
+  template <typename AnnotatedC>
+  const std::vector<RemoveAnnotations<AnnotatedC>*>& getMultibindingsParallel(std::size_t num_threads);
+  
   void eagerlyInjectMultibindings();
+  
+  // Enables thread safety and then constructs the objects for the types in `types' (and their non-lazy dependencies) and
+  // all multibindings, using num_threads threads (or std::thread::hardware_concurrency() if num_threads is 0).
+  // Each graph node and each multibinding element is a separate task, started once all its dependencies are constructed.
+  void eagerlyInjectAll(const std::vector<TypeId>& types, std::size_t num_threads);
+  
+  // See Injector::enableReset().
+  void enableReset();
+  
+  // Destroys all the objects constructed by this injector and restores the state that this injector had right after
+  // construction, reusing the same memory. enableReset() must have been called before constructing any object.
+  void reset();
+  
+  // After this call, the object getters (including the ones of Providers) and getMultibindings() can be called
+  // concurrently from multiple threads. This also enables thread safety in all the ancestors of a child injector.
+  // See Injector::enableThreadSafety().
+  void enableThreadSafety();
+  
+  // See Injector::enableIterativeConstruction().
+  void enableIterativeConstruction();
+  
+  // See Injector::enableFastExit().
+  void enableFastExit();
+  
+  // See Injector::getBindingLookupStatistics().
+  BindingLookupStatistics getBindingLookupStatistics() const;
+  
+  // Returns the BindingLookupStatistics of `graph'.
+  static BindingLookupStatistics getBindingLookupStatistics(const Graph& graph);
 };
 
 } // namespace impl
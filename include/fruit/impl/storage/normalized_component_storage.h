@@ -29,9 +29,9 @@
 #include <fruit/impl/fruit_internal_forward_decls.h>
 #include <fruit/impl/storage/injector_storage.h>
 #include <fruit/impl/binding_normalization.h>
+#include <fruit/impl/data_structures/chunk_cache.h>
 
 #include <memory>
-#include <unordered_map>
 
 namespace fruit {
 namespace impl {
@@ -50,23 +50,67 @@ private:
   // For types that have a constructed object already, the corresponding node is stored as terminal node.
   SemistaticGraph<TypeId, NormalizedBindingData> bindings;
   
-  // Maps the type index of a type T to a set of the corresponding BindingData objects (for multibindings).
-  std::unordered_map<TypeId, NormalizedMultibindingData> multibindings;
+  // The multibindings of this component. Injectors created from this component share this (unless they add multibindings).
+  NormalizedMultibindingSet multibindings;
   
   // Contains data on the set of types that can be allocated using this component.
   FixedSizeAllocator::FixedSizeAllocatorData fixed_size_allocator_data;
   
   // Stores information on binding compression that was performed in bindings of this object.
   // See also the documentation for BindingCompressionInfoMap.
-  // We hold this via a unique_ptr to avoid including Boost's hashmap implementation.
-  std::unique_ptr<BindingNormalization::BindingCompressionInfoMap> bindingCompressionInfoMap;
+  BindingNormalization::BindingCompressionInfoMap bindingCompressionInfoMap;
+  
+  // The max_bucketed_elems used when adding the bindings of an injector's component to `bindings' (see the
+  // SemistaticGraph constructor that copies another graph). See NormalizedComponentOptions::max_bucketed_bindings.
+  std::size_t max_bucketed_bindings;
+  
+  // The offsets of the objects in the injectors' FixedSizeAllocator, indexed by node position in `bindings' (see
+  // BindingNormalization::computeObjectLayout()). The graphs of the injectors created from this component copy the
+  // nodes of `bindings' at the same positions, so they use this too.
+  std::vector<std::uint32_t> object_offsets;
+  
+  // The bindings removed because they were unreachable (all zero if unreachable bindings were not pruned).
+  BindingNormalization::PruningStatistics pruning_statistics;
+  
+  // The chunks of the FixedSizeAllocator-s of the injectors created from this component (when no MemoryResource is
+  // specified) are allocated from here, so that they can be reused by later injectors.
+  mutable ChunkCache chunk_cache;
+  
+  // The original bindings of the hoisted request-independent bindings, sorted by TypeId. The corresponding nodes in
+  // `bindings' are terminal and store the objects constructed in hoisted_objects_storage.
+  std::vector<std::pair<TypeId, BindingData>> hoisted_bindings;
+  
+  // Owns the objects of the hoisted bindings. This is declared after chunk_cache so that it's destroyed first.
+  std::unique_ptr<InjectorStorage> hoisted_objects_storage;
+  
+  // Constructs the objects of the request-independent bindings (see
+  // BindingNormalization::findRequestIndependentBindings()) and stores them in the corresponding nodes of `bindings'.
+  void hoistRequestIndependentBindings(const std::vector<std::pair<TypeId, BindingData>>& normalized_bindings,
+                                       MemoryResource* memory_resource);
   
   friend class InjectorStorage;
+  friend class PreparedInjectorStorage;
+  friend class NormalizedComponentStorageHolder;
   
 public:
   NormalizedComponentStorage() = delete;
   
-  NormalizedComponentStorage(const ComponentStorage& component, const std::vector<TypeId>& exposed_types);
+  // If num_threads>1 (or 0, meaning the number of hardware threads), the component is normalized using that many threads.
+  // If prune_unreachable_bindings is true, the bindings that are not reachable from the exposed types or from the
+  // multibindings are removed.
+  // If hoist_request_independent_bindings is true, the objects of the request-independent bindings are constructed
+  // here, and then shared by all injectors created from this object.
+  // max_bucketed_bindings is used when creating injectors from this object, see max_bucketed_bindings below.
+  // If memory_resource is not nullptr, the binding graph is allocated from it.
+  NormalizedComponentStorage(const ComponentStorage& component, const std::vector<TypeId>& exposed_types,
+                             std::size_t num_threads = 1, bool prune_unreachable_bindings = false,
+                             bool hoist_request_independent_bindings = false,
+                             std::size_t max_bucketed_bindings =
+                                 SemistaticMap<TypeId, SemistaticGraphInternalNodeId>::default_max_bucketed_elems,
+                             MemoryResource* memory_resource = nullptr);
+  
+  // Returns true if `binding' is the original binding of the hoisted binding for `type'.
+  bool isHoistedBinding(TypeId type, const BindingData& binding) const;
 
   NormalizedComponentStorage(NormalizedComponentStorage&&) = delete;
   NormalizedComponentStorage(const NormalizedComponentStorage&) = delete;
@@ -17,6 +17,7 @@
 #ifndef FRUIT_NORMALIZED_COMPONENT_STORAGE_HOLDER_H
 #define FRUIT_NORMALIZED_COMPONENT_STORAGE_HOLDER_H
 
+#include <cstddef>
 #include <memory>
 #include <fruit/impl/fruit_internal_forward_decls.h>
 #include <fruit/fruit_forward_decls.h>
@@ -38,10 +39,15 @@ private:
   template <typename... P>
   friend class fruit::Injector;
   
+  template <typename... P>
+  friend class fruit::PreparedInjector;
+  
 public:
   NormalizedComponentStorageHolder() = delete;
   
-  NormalizedComponentStorageHolder(const ComponentStorage& component, const std::vector<TypeId>& exposed_types);
+  NormalizedComponentStorageHolder(const ComponentStorage& component, const std::vector<TypeId>& exposed_types,
+                                   const NormalizedComponentOptions& options,
+                                   MemoryResource* memory_resource = nullptr);
 
   NormalizedComponentStorageHolder(NormalizedComponentStorage&&) = delete;
   NormalizedComponentStorageHolder(const NormalizedComponentStorage&) = delete;
@@ -49,6 +55,20 @@ public:
   NormalizedComponentStorageHolder& operator=(NormalizedComponentStorageHolder&&) = default;
   NormalizedComponentStorageHolder& operator=(const NormalizedComponentStorageHolder&) = default;
   
+  // See NormalizedComponentStorage::pruning_statistics.
+  std::size_t getNumPrunedBindings() const;
+  std::size_t getNumPrunedBytes() const;
+  
+  // See NormalizedComponentStorage::hoisted_bindings.
+  std::size_t getNumHoistedBindings() const;
+  
+  // See NormalizedComponent::getBindingLookupStatistics().
+  BindingLookupStatistics getBindingLookupStatistics() const;
+  
+  // See NormalizedComponentStorage::chunk_cache.
+  std::size_t getNumChunkCacheHits() const;
+  std::size_t getNumChunkCacheMisses() const;
+  
   // We don't use the default destructor because that would require the inclusion of
   // normalized_component_storage.h. We define this in the cpp file instead.
   ~NormalizedComponentStorageHolder();
@@ -243,6 +243,21 @@ public:
   }
 };
 
+template <typename DecoratedSignature, typename Lambda, typename... PreviousBindings>
+class PartialComponentStorage<RegisterFruitFactory<DecoratedSignature, Lambda>, PreviousBindings...> {
+private:
+  PartialComponentStorage<PreviousBindings...> &previous_storage;
+
+public:
+  PartialComponentStorage(PartialComponentStorage<PreviousBindings...>& previous_storage)
+      : previous_storage(previous_storage) {
+  }
+
+  void addBindings(ComponentStorage& storage) const {
+    previous_storage.addBindings(storage);
+  }
+};
+
 template <typename OtherComponent, typename... PreviousBindings>
 class PartialComponentStorage<InstallComponent<OtherComponent>, PreviousBindings...> {
 private:
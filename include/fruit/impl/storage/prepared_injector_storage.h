@@ -0,0 +1,104 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRUIT_PREPARED_INJECTOR_STORAGE_H
+#define FRUIT_PREPARED_INJECTOR_STORAGE_H
+
+#ifndef IN_FRUIT_CPP_FILE
+// We don't want to include it in public headers to save some compile time.
+#error "prepared_injector_storage.h included in non-cpp file."
+#endif
+
+#include <fruit/impl/util/type_info.h>
+#include <fruit/impl/binding_data.h>
+#include <fruit/impl/data_structures/semistatic_graph.h>
+#include <fruit/impl/data_structures/chunk_cache.h>
+#include <fruit/impl/fruit_internal_forward_decls.h>
+#include <fruit/impl/storage/injector_storage.h>
+
+#include <vector>
+
+namespace fruit {
+namespace impl {
+
+/**
+ * The result of all the work that InjectorStorage does when constructing an injector from a NormalizedComponentStorage
+ * and a ComponentStorage, for a specific sample ComponentStorage.
+ * An InjectorStorage can then be created from this and any ComponentStorage with the same bindings as the sample one
+ * (except that instance bindings can bind different objects) by copying the graph and filling in the instance objects.
+ */
+class PreparedInjectorStorage {
+public:
+  using Graph = InjectorStorage::Graph;
+
+private:
+  // The graph of the injectors created from this object, with all instance bindings of the sample component still bound
+  // to the sample objects.
+  // This shares data with the graph in the NormalizedComponentStorage.
+  Graph bindings;
+
+  // The multibindings of the injectors created from this object, with the instance multibindings of the sample component
+  // still bound to the sample objects.
+  NormalizedMultibindingSet multibindings;
+
+  FixedSizeAllocator::FixedSizeAllocatorData fixed_size_allocator_data;
+  
+  // The chunk cache of the NormalizedComponentStorage, see NormalizedComponentStorage::chunk_cache.
+  ChunkCache* chunk_cache;
+  
+  // See NormalizedComponentStorage::max_bucketed_bindings.
+  std::size_t max_bucketed_bindings;
+  
+  // The object offsets of the NormalizedComponentStorage, see NormalizedComponentStorage::object_offsets. `bindings'
+  // has the nodes of the normalized component at the same positions.
+  const std::vector<std::uint32_t>* object_offsets;
+
+  // The bindings of the sample component, in the same order as in the sample ComponentStorage.
+  std::vector<std::pair<TypeId, BindingData>> component_bindings;
+
+  // instance_binding_is_stored[i] is true iff component_bindings[i] is an instance binding and its object must be stored
+  // in the graph node for that type. When this is false for an instance binding (e.g. because the same instance binding
+  // is also in the normalized component), the object is only checked against the one already in the graph.
+  std::vector<bool> instance_binding_is_stored;
+
+  // The multibindings of the sample component, in the same order as in the sample ComponentStorage.
+  std::vector<std::pair<TypeId, MultibindingData>> component_multibindings;
+
+  // multibinding_elem_indexes[i] is the index of component_multibindings[i] in multibindings.elems.
+  std::vector<std::size_t> multibinding_elem_indexes;
+
+  friend class InjectorStorage;
+
+public:
+  PreparedInjectorStorage() = delete;
+
+  PreparedInjectorStorage(const NormalizedComponentStorage& normalized_component,
+                          const ComponentStorage& component,
+                          std::vector<TypeId>&& exposed_types);
+
+  PreparedInjectorStorage(PreparedInjectorStorage&&) = delete;
+  PreparedInjectorStorage(const PreparedInjectorStorage&) = delete;
+
+  PreparedInjectorStorage& operator=(PreparedInjectorStorage&&) = delete;
+  PreparedInjectorStorage& operator=(const PreparedInjectorStorage&) = delete;
+
+  ~PreparedInjectorStorage();
+};
+
+} // namespace impl
+} // namespace fruit
+
+#endif // FRUIT_PREPARED_INJECTOR_STORAGE_H
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRUIT_PREPARED_INJECTOR_STORAGE_HOLDER_H
+#define FRUIT_PREPARED_INJECTOR_STORAGE_HOLDER_H
+
+#include <memory>
+#include <fruit/impl/fruit_internal_forward_decls.h>
+#include <fruit/fruit_forward_decls.h>
+
+namespace fruit {
+namespace impl {
+
+/**
+ * A wrapper around PreparedInjectorStorage, holding the PreparedInjectorStorage
+ * through a unique_ptr so that we don't need to include PreparedInjectorStorage in
+ * fruit.h.
+ */
+class PreparedInjectorStorageHolder {
+private:
+  std::unique_ptr<PreparedInjectorStorage> storage;
+  
+  template <typename... P>
+  friend class fruit::Injector;
+  
+public:
+  PreparedInjectorStorageHolder() = delete;
+  
+  PreparedInjectorStorageHolder(const NormalizedComponentStorage& normalized_component,
+                                const ComponentStorage& component,
+                                std::vector<TypeId>&& exposed_types);
+
+  PreparedInjectorStorageHolder(PreparedInjectorStorageHolder&&) = default;
+  PreparedInjectorStorageHolder(const PreparedInjectorStorageHolder&) = delete;
+  
+  PreparedInjectorStorageHolder& operator=(PreparedInjectorStorageHolder&&) = default;
+  PreparedInjectorStorageHolder& operator=(const PreparedInjectorStorageHolder&) = delete;
+  
+  // We don't use the default destructor because that would require the inclusion of
+  // prepared_injector_storage.h. We define this in the cpp file instead.
+  ~PreparedInjectorStorageHolder();
+};
+
+} // namespace impl
+} // namespace fruit
+
+#endif // FRUIT_PREPARED_INJECTOR_STORAGE_HOLDER_H
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef FRUIT_MEMORY_RESOURCE_ALLOCATOR_H
+#define FRUIT_MEMORY_RESOURCE_ALLOCATOR_H
+
+#include <fruit/memory_resource.h>
+
+#include <cstddef>
+#include <new>
+
+namespace fruit {
+namespace impl {
+
+// Allocates memory from `memory_resource', or with operator new if memory_resource is nullptr.
+inline void* allocateMemory(MemoryResource* memory_resource, std::size_t size, std::size_t alignment) {
+  if (memory_resource == nullptr) {
+    return operator new(size);
+  } else {
+    return memory_resource->allocate(size, alignment);
+  }
+}
+
+// Deallocates memory allocated with allocateMemory() with the same parameters.
+inline void deallocateMemory(MemoryResource* memory_resource, void* p, std::size_t size, std::size_t alignment) {
+  if (memory_resource == nullptr) {
+    operator delete(p);
+  } else {
+    memory_resource->deallocate(p, size, alignment);
+  }
+}
+
+/**
+ * A (standard) allocator that allocates from a MemoryResource, or with operator new if the MemoryResource is nullptr.
+ * E.g. this can be used with std::allocate_shared().
+ */
+template <typename T>
+class MemoryResourceAllocator {
+public:
+  using value_type = T;
+  
+  MemoryResource* memory_resource;
+  
+  explicit MemoryResourceAllocator(MemoryResource* memory_resource)
+    : memory_resource(memory_resource) {
+  }
+  
+  template <typename U>
+  MemoryResourceAllocator(const MemoryResourceAllocator<U>& other)
+    : memory_resource(other.memory_resource) {
+  }
+  
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(allocateMemory(memory_resource, n * sizeof(T), alignof(T)));
+  }
+  
+  void deallocate(T* p, std::size_t n) {
+    deallocateMemory(memory_resource, p, n * sizeof(T), alignof(T));
+  }
+  
+  template <typename U>
+  struct rebind {
+    using other = MemoryResourceAllocator<U>;
+  };
+  
+  template <typename U>
+  bool operator==(const MemoryResourceAllocator<U>& other) const {
+    return memory_resource == other.memory_resource;
+  }
+  
+  template <typename U>
+  bool operator!=(const MemoryResourceAllocator<U>& other) const {
+    return memory_resource != other.memory_resource;
+  }
+};
+
+} // namespace impl
+} // namespace fruit
+
+#endif // FRUIT_MEMORY_RESOURCE_ALLOCATOR_H
@@ -0,0 +1,189 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRUIT_PARALLEL_RANGES_H
+#define FRUIT_PARALLEL_RANGES_H
+
+#ifndef IN_FRUIT_CPP_FILE
+// We don't want to include it in public headers to save some compile time.
+#error "parallel_ranges.h included in non-cpp file."
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fruit {
+namespace impl {
+
+// Returns num_threads, or the number of hardware threads if num_threads is 0.
+inline std::size_t getNumThreads(std::size_t num_threads) {
+  if (num_threads == 0) {
+    num_threads = std::max(std::thread::hardware_concurrency(), 1U);
+  }
+  return num_threads;
+}
+
+// Splits [0, n) into num_ranges contiguous ranges of (roughly) the same size and calls f(range_index, begin, end) for each
+// of them, each in a separate thread (the first range is handled by the current thread).
+// f must not throw.
+template <typename F>
+void forEachRangeInParallel(std::size_t n, std::size_t num_ranges, F f) {
+  auto range_begin = [n, num_ranges](std::size_t range_index) {
+    return n / num_ranges * range_index + std::min(range_index, n % num_ranges);
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(num_ranges - 1);
+  for (std::size_t i = 1; i < num_ranges; ++i) {
+    threads.emplace_back([&f, &range_begin, i]() {
+      f(i, range_begin(i), range_begin(i + 1));
+    });
+  }
+  f(0, range_begin(0), range_begin(1));
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+// Calls task(i) for each i in [0, num_tasks), using num_threads threads (including the current one).
+// The tasks are assigned to threads dynamically, so threads that run slow tasks don't hold up the others.
+// If a task throws, the remaining tasks are not started and the first exception is rethrown once all threads have stopped.
+template <typename F>
+void runTasksInParallel(std::size_t num_tasks, std::size_t num_threads, F task) {
+  std::atomic<std::size_t> next_task{0};
+  std::mutex exception_mutex;
+  std::exception_ptr exception;
+  
+  auto worker = [&]() {
+    for (std::size_t i = next_task++; i < num_tasks; i = next_task++) {
+      try {
+        task(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(exception_mutex);
+        if (!exception) {
+          exception = std::current_exception();
+        }
+        // Make all threads stop as soon as they finish their current task.
+        next_task = num_tasks;
+      }
+    }
+  };
+  
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+  for (std::size_t i = 1; i < num_threads; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+}
+
+// Calls task(i) for each i in [0, num_deps.size()), using num_threads threads (including the current one).
+// Task i is only started once num_deps[i] other tasks have finished, where each task j that finishes counts once for each
+// occurrence of i in dependents[j]. So the tasks must form an acyclic graph, with num_deps[i] equal to the number of
+// occurrences of i in the `dependents' vectors.
+// Ready tasks are assigned to threads dynamically, as soon as they become ready.
+// If a task throws, no more tasks are started and the first exception is rethrown once all threads have stopped.
+template <typename F>
+void runTaskGraphInParallel(std::vector<std::size_t> num_deps, const std::vector<std::vector<std::size_t>>& dependents,
+                            std::size_t num_threads, F task) {
+  std::size_t num_tasks = num_deps.size();
+  std::size_t num_finished_tasks = 0;
+  std::exception_ptr exception;
+  std::mutex mutex;
+  std::condition_variable condition;
+  
+  // The tasks that can be started, protected by `mutex' (as all the local variables above).
+  std::vector<std::size_t> ready_tasks;
+  for (std::size_t i = 0; i < num_tasks; ++i) {
+    if (num_deps[i] == 0) {
+      ready_tasks.push_back(i);
+    }
+  }
+  
+  auto worker = [&]() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      condition.wait(lock, [&]() {
+        return !ready_tasks.empty() || num_finished_tasks == num_tasks || exception;
+      });
+      if (exception || ready_tasks.empty()) {
+        // Either a task failed or all tasks are done.
+        return;
+      }
+      std::size_t i = ready_tasks.back();
+      ready_tasks.pop_back();
+      
+      lock.unlock();
+      std::exception_ptr task_exception;
+      try {
+        task(i);
+      } catch (...) {
+        task_exception = std::current_exception();
+      }
+      lock.lock();
+      
+      if (task_exception) {
+        if (!exception) {
+          exception = task_exception;
+        }
+        condition.notify_all();
+        return;
+      }
+      ++num_finished_tasks;
+      for (std::size_t dependent : dependents[i]) {
+        if (--num_deps[dependent] == 0) {
+          ready_tasks.push_back(dependent);
+        }
+      }
+      if (ready_tasks.size() > 1 || num_finished_tasks == num_tasks) {
+        condition.notify_all();
+      } else if (!ready_tasks.empty()) {
+        condition.notify_one();
+      }
+    }
+  };
+  
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+  for (std::size_t i = 1; i < num_threads; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+}
+
+} // namespace impl
+} // namespace fruit
+
+#endif // FRUIT_PARALLEL_RANGES_H
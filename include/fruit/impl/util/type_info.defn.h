@@ -59,12 +59,13 @@ struct GetConcreteTypeInfo<T, true> {
 
 
 // This should only be used if RTTI is disabled. Use the other constructor if possible.
-inline constexpr TypeInfo::TypeInfo(ConcreteTypeInfo concrete_type_info)
-  : info(nullptr), concrete_type_info(concrete_type_info) {
+inline constexpr TypeInfo::TypeInfo(ConcreteTypeInfo concrete_type_info, std::size_t (*get_dense_index)())
+  : info(nullptr), concrete_type_info(concrete_type_info), get_dense_index(get_dense_index) {
 }
 
-inline constexpr TypeInfo::TypeInfo(const std::type_info& info, ConcreteTypeInfo concrete_type_info)
-  : info(&info), concrete_type_info(concrete_type_info) {
+inline constexpr TypeInfo::TypeInfo(const std::type_info& info, ConcreteTypeInfo concrete_type_info,
+                                    std::size_t (*get_dense_index)())
+  : info(&info), concrete_type_info(concrete_type_info), get_dense_index(get_dense_index) {
 }
 
 inline std::string TypeInfo::name() const {
@@ -94,6 +95,10 @@ inline bool TypeInfo::isTriviallyDestructible() const {
 #endif
   return concrete_type_info.is_trivially_destructible;
 }
+
+inline std::size_t TypeInfo::denseIndex() const {
+  return get_dense_index();
+}
   
 inline TypeId::operator std::string() const {
   return type_info->name();
@@ -115,9 +120,9 @@ template <typename T>
 struct GetTypeInfoForType {
   constexpr TypeInfo operator()() const {
 #ifdef FRUIT_HAS_TYPEID
-    return TypeInfo(typeid(T), GetConcreteTypeInfo<T>()());
+    return TypeInfo(typeid(T), GetConcreteTypeInfo<T>()(), &getDenseTypeIndex<T>);
 #else
-    return TypeInfo(GetConcreteTypeInfo<T>()());
+    return TypeInfo(GetConcreteTypeInfo<T>()(), &getDenseTypeIndex<T>);
 #endif
   };
 };
@@ -126,9 +131,10 @@ template <typename Annotation, typename T>
 struct GetTypeInfoForType<fruit::Annotated<Annotation, T>> {
   constexpr TypeInfo operator()() const {
 #ifdef FRUIT_HAS_TYPEID
-    return TypeInfo(typeid(fruit::Annotated<Annotation, T>), GetConcreteTypeInfo<T>()());
+    return TypeInfo(typeid(fruit::Annotated<Annotation, T>), GetConcreteTypeInfo<T>()(),
+                    &getDenseTypeIndex<fruit::Annotated<Annotation, T>>);
 #else
-    return TypeInfo(GetConcreteTypeInfo<T>()());
+    return TypeInfo(GetConcreteTypeInfo<T>()(), &getDenseTypeIndex<fruit::Annotated<Annotation, T>>);
 #endif
   };
 };
@@ -145,11 +151,19 @@ inline TypeId getTypeId() {
   return TypeId{&info};
 }
 
+template <typename T>
+inline std::size_t getDenseTypeIndex() {
+  // This is initialized (in a thread-safe way) on the first call.
+  static const std::size_t index = allocateDenseTypeIndex();
+  return index;
+}
+
 template <typename L>
 struct GetTypeIdsForListHelper;
 
+// L is a meta::Vector of meta::Type<T>s; the TypeIds returned are the ones of the Ts, not of the Type<T> wrappers.
 template <typename... Ts>
-struct GetTypeIdsForListHelper<fruit::impl::meta::Vector<Ts...>> {
+struct GetTypeIdsForListHelper<fruit::impl::meta::Vector<fruit::impl::meta::Type<Ts>...>> {
   std::vector<TypeId> operator()() {
     return std::vector<TypeId>{getTypeId<Ts>()...};
   }
@@ -42,9 +42,10 @@ struct alignas(1) alignas(void*) TypeInfo {
   };
 
   // This should only be used if RTTI is disabled. Use the other constructor if possible.
-  constexpr TypeInfo(ConcreteTypeInfo concrete_type_info);
+  constexpr TypeInfo(ConcreteTypeInfo concrete_type_info, std::size_t (*get_dense_index)());
 
-  constexpr TypeInfo(const std::type_info& info, ConcreteTypeInfo concrete_type_info);
+  constexpr TypeInfo(const std::type_info& info, ConcreteTypeInfo concrete_type_info,
+                     std::size_t (*get_dense_index)());
 
   std::string name() const;
 
@@ -54,11 +55,16 @@ struct alignas(1) alignas(void*) TypeInfo {
   
   bool isTriviallyDestructible() const;
   
+  // See getDenseTypeIndex().
+  std::size_t denseIndex() const;
+  
 private:
   // The std::type_info struct associated with the type, or nullptr if RTTI is disabled.
   // This is only used for the type name.
   const std::type_info* info;
   ConcreteTypeInfo concrete_type_info;
+  // This is getDenseTypeIndex<T> for the type T.
+  std::size_t (*get_dense_index)();
 };
 
 struct TypeId {
@@ -78,7 +84,17 @@ struct TypeId {
 template <typename T>
 TypeId getTypeId();
 
-// A convenience function that returns an std::vector of TypeId values for the given meta-vector of types.
+// Returns a small integer that identifies the type T, assigning it on the first call.
+// Indexes are assigned consecutively starting from 0 (in the order of the first calls), so they can be used to index
+// arrays instead of hashing TypeId values. For any type T, getTypeId<T>().type_info->denseIndex() is the same value.
+template <typename T>
+std::size_t getDenseTypeIndex();
+
+// Returns a new dense type index. Only used by getDenseTypeIndex().
+std::size_t allocateDenseTypeIndex();
+
+// A convenience function that returns an std::vector of TypeId values for the given meta-vector of types (each wrapped
+// in fruit::impl::meta::Type).
 template <typename V>
 std::vector<TypeId> getTypeIdsForList();
 
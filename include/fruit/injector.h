@@ -22,6 +22,7 @@
 
 #include <fruit/component.h>
 #include <fruit/provider.h>
+#include <fruit/multibindings_view.h>
 #include <fruit/normalized_component.h>
 
 namespace fruit {
@@ -102,6 +103,32 @@ public:
   template <typename... NormalizedComponentParams, typename... ComponentParams>
   Injector(const NormalizedComponent<NormalizedComponentParams...>& normalized_component, Component<ComponentParams...> component);
   
+  /**
+   * Creation of an injector from a prepared injector and a component.
+   * 
+   * The component must have the same bindings as the sample component used to create the PreparedInjector, except that instance
+   * bindings can bind different objects; otherwise the program is aborted with a fatal error.
+   * This is faster than the constructor that takes a NormalizedComponent, since no bindings have to be processed; see
+   * PreparedInjector for more details.
+   * 
+   * The PreparedInjector must remain valid during the lifetime of any Injector object constructed with it.
+   * 
+   * Example usage:
+   * 
+   * PreparedInjector<Foo, Bar> preparedInjector(normalizedComponent, getRequestComponent(sampleRequest));
+   * ...
+   * Injector<Foo, Bar> injector(preparedInjector, getRequestComponent(request));
+   */
+  template <typename... ComponentParams>
+  Injector(const PreparedInjector<P...>& prepared_injector, Component<ComponentParams...> component);
+  
+  /**
+   * Deleted constructor, to ensure that constructing an Injector from a temporary PreparedInjector doesn't compile.
+   * The PreparedInjector must remain valid during the lifetime of any Injector object constructed with it.
+   */
+  template <typename... ComponentParams>
+  Injector(PreparedInjector<P...>&& prepared_injector, Component<ComponentParams...> component) = delete;
+  
   /**
    * Deleted constructor, to ensure that constructing an Injector from a temporary NormalizedComponent doesn't compile.
    * The NormalizedComponent must remain valid during the lifetime of any Injector object constructed with it.
@@ -110,6 +137,85 @@ public:
   Injector(NormalizedComponent<NormalizedComponentParams...>&& normalized_component, 
            Component<ComponentParams...> component) = delete;
   
+  /**
+   * Same as the constructors above, but the memory of the injector (the injected objects, the injector's copy of the
+   * bindings and the multibinding vectors) is allocated from `memory_resource', that must remain valid during the lifetime
+   * of the Injector. See MemoryResource for more details.
+   * 
+   * Example usage:
+   * 
+   * MyArenaResource arena;
+   * Injector<Foo, Bar> injector(normalizedComponent, getRequestComponent(request), arena);
+   */
+  Injector(const Component<P...>& component, MemoryResource& memory_resource);
+  
+  template <typename... NormalizedComponentParams, typename... ComponentParams>
+  Injector(const NormalizedComponent<NormalizedComponentParams...>& normalized_component,
+           Component<ComponentParams...> component,
+           MemoryResource& memory_resource);
+  
+  template <typename... ComponentParams>
+  Injector(const PreparedInjector<P...>& prepared_injector, Component<ComponentParams...> component,
+           MemoryResource& memory_resource);
+  
+  template <typename... ComponentParams>
+  Injector(PreparedInjector<P...>&& prepared_injector, Component<ComponentParams...> component,
+           MemoryResource& memory_resource) = delete;
+  
+  template <typename... NormalizedComponentParams, typename... ComponentParams>
+  Injector(NormalizedComponent<NormalizedComponentParams...>&& normalized_component,
+           Component<ComponentParams...> component,
+           MemoryResource& memory_resource) = delete;
+  
+  /**
+   * Creation of a child injector of `parent', with the additional bindings in `component'.
+   * 
+   * The requirements of the component must be provided by the parent injector. The types P... of this injector can be
+   * provided by either the component or the parent injector. The objects of the parent injector are shared with the child
+   * (they're constructed in the parent if needed), instead of being constructed again. A type bound in `component' that
+   * is also bound in the parent is constructed by the child injector using the binding in `component', but the objects of
+   * the parent injector that depend on that type still use the parent's object. Similarly, getMultibindings<T>() returns
+   * the multibindings of T in `component', or the ones in the parent injector if `component' has none.
+   * 
+   * Creating a child injector only processes the bindings in `component' and doesn't copy the bindings of the parent, so
+   * it's faster than the constructors above when the parent has many bindings and the child only adds a few.
+   * 
+   * The parent injector must remain valid during the lifetime of the child injector. If child injectors of the same parent
+   * are used concurrently from multiple threads, thread safety must be enabled in the parent injector first (see
+   * enableThreadSafety()).
+   * 
+   * Example usage:
+   * 
+   * // At startup (e.g. inside main()).
+   * Injector<Bar, Bar2> parentInjector(getBarComponent());
+   * 
+   * ...
+   * for (...) {
+   *   // For each request.
+   *   Request request = ...;
+   * 
+   *   Injector<Foo, Bar> injector(parentInjector, getFooComponent(request));
+   *   Foo* foo = injector.get<Foo*>();
+   *   ...
+   * }
+   */
+  template <typename... ParentP, typename... ComponentParams>
+  Injector(Injector<ParentP...>& parent, Component<ComponentParams...> component);
+  
+  template <typename... ParentP, typename... ComponentParams>
+  Injector(Injector<ParentP...>& parent, Component<ComponentParams...> component, MemoryResource& memory_resource);
+  
+  /**
+   * Deleted constructor, to ensure that constructing a child injector of a temporary Injector doesn't compile.
+   * The parent Injector must remain valid during the lifetime of any child Injector.
+   */
+  template <typename... ParentP, typename... ComponentParams>
+  Injector(Injector<ParentP...>&& parent, Component<ComponentParams...> component) = delete;
+  
+  template <typename... ParentP, typename... ComponentParams>
+  Injector(Injector<ParentP...>&& parent, Component<ComponentParams...> component,
+           MemoryResource& memory_resource) = delete;
+  
   /**
    * Returns an instance of the specified type. For any class C in the Injector's template parameters, the following variations
    * are allowed:
@@ -173,13 +279,13 @@ public:
    * is equivalent to:
    * 
    * MyInterface* x = injector.get<MyInterface*>();
-   *
+   * 
    * Note that this can't be used to inject an annotated type, i.e. this does NOT work:
-   *
+   * 
    * fruit::Annotated<SomeAnnotation, SomeClass> foo(injector);
-   *
+   * 
    * Because foo would be of type fruit::Annotated, not of type SomeClass. In that case you must use get instead, e.g.:
-   *
+   * 
    * SomeClass* foo = injector.get<fruit::Annotated<SomeAnnotation, SomeClass*>>();;
    */
   template <typename T>
@@ -197,6 +303,44 @@ public:
   template <typename T>
   const std::vector<RemoveAnnotations<T>*>& getMultibindings();
   
+  /**
+   * Similar to getMultibindings<T>(), but returns a MultibindingsView<RemoveAnnotations<T>> instead of a std::vector.
+   * This never allocates memory: the view refers to the multibinding objects stored in this injector, whose space is
+   * reserved when the injector is created. The view is only valid until this injector is destroyed or reset().
+   * 
+   * This returns an empty view if there are no multibindings.
+   */
+  template <typename T>
+  MultibindingsView<RemoveAnnotations<T>> getMultibindingsView();
+  
+  /**
+   * Similar to getMultibindings<T>(), but the multibinding objects that are not constructed yet are constructed using
+   * num_threads threads (including the calling one), so that slow constructors of independent elements can run in
+   * parallel. If num_threads is 0, std::thread::hardware_concurrency() threads are used.
+   * 
+   * The dependencies shared by different elements are still constructed once, before the elements that need them (a thread
+   * that needs an object being constructed by another thread waits for it). The elements of the returned vector are in the
+   * same order as with getMultibindings<T>().
+   * If a constructor throws, the exception is rethrown by this method once all threads have stopped.
+   * 
+   * This also enables thread safety for this injector (see enableThreadSafety()). As for eagerlyInjectAll(num_threads), this
+   * method must not be called concurrently with any other method of this injector.
+   */
+  template <typename T>
+  const std::vector<RemoveAnnotations<T>*>& getMultibindingsParallel(std::size_t num_threads);
+  
+  /**
+   * Similar to getMultibindingsView<T>(), but the multibinding objects are not constructed upfront: each one is constructed
+   * when it's first accessed through the returned view (if it wasn't already). This is useful when only some of the
+   * multibindings are needed, e.g. to find the first element that satisfies some condition:
+   * 
+   * Handler* handler = injector.getLazyMultibindings<Handler>().findFirst([&](Handler* h) { return h->canHandle(request); });
+   * 
+   * The returned view is only valid until this injector is destroyed.
+   */
+  template <typename T>
+  LazyMultibindingsView<RemoveAnnotations<T>> getLazyMultibindings();
+  
   /**
    * Eagerly injects all reachable bindings and multibindings of this injector.
    * This only creates instances of the types that are either:
@@ -214,9 +358,102 @@ public:
    */
   void eagerlyInjectAll();
   
+  /**
+   * Similar to eagerlyInjectAll(), but constructs the objects using num_threads threads (including the calling one), so
+   * objects that don't depend on each other can be constructed in parallel. This is useful when some constructors are slow.
+   * If num_threads is 0, std::thread::hardware_concurrency() threads are used.
+   * 
+   * Each object (including the dependencies of the types in P...) is scheduled separately, as soon as all its dependencies
+   * have been constructed, so independent subtrees of the same type's dependencies are also constructed in parallel.
+   * Each object is still constructed after all its dependencies, and at most once. However, unrelated objects might be
+   * constructed in a different order than with eagerlyInjectAll() (and so they might also be destroyed in a different order).
+   * If a constructor throws, the exception is rethrown by this method once all threads have stopped.
+   * 
+   * This also enables thread safety for this injector (see enableThreadSafety()). As for eagerlyInjectAll(), this method
+   * must not be called concurrently with any other method of this injector.
+   */
+  void eagerlyInjectAll(std::size_t num_threads);
+  
+  /**
+   * Allows calling reset() on this injector. After this call, the injector records each object that it constructs (this
+   * allocates a small array, with one element for each type bound in the injector, when this method is called), so that
+   * reset() can later destroy them and restore the previous state. Injectors that are never reset don't pay this cost.
+   * 
+   * This method must be called before any object is injected from this injector, otherwise it reports an error and aborts
+   * the program. It must not be called concurrently with any other method of this injector.
+   */
+  void enableReset();
+  
+  /**
+   * Destroys all the objects constructed by this injector (in reverse order of construction, as the Injector's destructor would
+   * do) and brings the injector back to the state that it had right after construction.
+   * Instance bindings are not affected.
+   * 
+   * Unlike destroying the injector and constructing a new one, this doesn't allocate or free any memory, so it can be used to
+   * reuse the same injector (e.g. in a long-lived server, one for each request-handling thread) instead of creating a new
+   * injector every time.
+   * 
+   * All pointers and references obtained from this injector before this call are no longer valid afterwards (including the
+   * vectors returned by getMultibindings() and the views returned by getMultibindingsView()). Provider objects and lazy views
+   * (see getLazyMultibindings()) obtained from this injector can still be used, and will construct new instances when needed.
+   * enableReset() must have been called on this injector before injecting any object, otherwise this method reports an
+   * error and aborts the program.
+   * This method must not be called concurrently with any other method of this injector.
+   */
+  void reset();
+  
+  /**
+   * Makes this injector thread-safe: after this call, get(), unsafeGet(), getMultibindings() and the get() method of
+   * Providers obtained from this injector can be called concurrently from multiple threads. Each object is still constructed
+   * at most once, and (unlike with eagerlyInjectAll()) only when it's first needed.
+   * 
+   * Getting an object that was already constructed doesn't need any locking (just an atomic load). Constructing an object
+   * doesn't lock the whole injector either: threads only wait for each other when they need the same object and it's still
+   * being constructed. getMultibindings() instead uses a mutex.
+   * 
+   * This method must be called before the injector is shared with other threads, and must not be called concurrently with
+   * any other method of this injector. Thread safety can't be disabled afterwards (but reset() can still be used, as long
+   * as it's not called concurrently with other methods).
+   * 
+   * In a child injector, this also enables thread safety in the parent injector and in its ancestors (if it wasn't enabled
+   * already), since the objects bound there are constructed by the parent when the child needs them. So this must also not
+   * be called concurrently with any method of an ancestor injector that's not thread-safe yet.
+   */
+  void enableThreadSafety();
+  
+  /**
+   * Switches this injector to an alternative construction strategy. By default, constructing an object recursively
+   * constructs its dependencies (so the native stack usage is proportional to the length of the longest dependency chain).
+   * After this call, the injector first walks the dependencies of the requested object using an explicit stack and then
+   * constructs the objects in dependency order, so the native stack usage doesn't depend on the shape of the dependency
+   * graph. This is useful for very deep dependency graphs.
+   * 
+   * The same objects are constructed with both strategies, and each object is still constructed after its dependencies.
+   * 
+   * This can be combined with enableThreadSafety(). This method must not be called concurrently with any other method of
+   * this injector.
+   */
+  void enableIterativeConstruction();
+  
+  /**
+   * Makes the destruction of this injector faster, by not destroying the objects of the types marked as leak-safe (see
+   * fruit::IsLeakSafe). The other objects are still destroyed in reverse order of construction.
+   * This is meant for an injector that lives until the process exits, where destroying e.g. objects that only own memory
+   * is wasted work. reset() still destroys all objects.
+   * 
+   * This method must not be called concurrently with any other method of this injector.
+   */
+  void enableFastExit();
+  
+  /**
+   * Returns statistics about the hash tables used to look up the bindings of this injector. This is O(n) in the number of
+   * bindings, it's meant to tune NormalizedComponentOptions::max_bucketed_bindings.
+   */
+  BindingLookupStatistics getBindingLookupStatistics() const;
+  
 private:
   using Comp = fruit::impl::meta::Eval<fruit::impl::meta::ConstructComponentImpl(fruit::impl::meta::Type<P>...)>;
-
+  
   using Check1 = typename fruit::impl::meta::CheckIfError<Comp>::type;
   using VoidType = fruit::impl::meta::Type<void>;
   // Force instantiation of Check1.
@@ -230,6 +467,10 @@ private:
   static_assert(true || sizeof(Check2), "");
   
   std::unique_ptr<fruit::impl::InjectorStorage> storage;
+  
+  // Child injectors need to access the storage of the parent injector.
+  template <typename... OtherP>
+  friend class Injector;
 };
 
 } // namespace fruit
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef FRUIT_LEAK_SAFE_H
+#define FRUIT_LEAK_SAFE_H
+
+#include <type_traits>
+
+namespace fruit {
+
+/**
+ * A type trait that marks the classes whose destructor doesn't need to run when the process is about to exit, e.g.
+ * because they only own memory. When an injector with fast exit enabled (see Injector::enableFastExit()) is destroyed,
+ * the objects of these types are not destroyed (and if they were allocated by a provider, they're not deleted).
+ * 
+ * To mark a class C as leak-safe, specialize this in the fruit namespace:
+ * 
+ * namespace fruit {
+ * template <>
+ * struct IsLeakSafe<C> : public std::true_type {};
+ * }
+ * 
+ * The specialization must be visible wherever the bindings for C are defined.
+ */
+template <typename C>
+struct IsLeakSafe : public std::false_type {};
+
+} // namespace fruit
+
+#endif // FRUIT_LEAK_SAFE_H
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef FRUIT_MEMORY_RESOURCE_H
+#define FRUIT_MEMORY_RESOURCE_H
+
+#include <cstddef>
+
+namespace fruit {
+
+/**
+ * An interface for the source of the memory used by injectors (and normalized components).
+ * This is similar to std::pmr::memory_resource (from C++17), but it's also available in C++11.
+ * 
+ * When an Injector is constructed with a MemoryResource, the memory for the injected objects, for the injector's copy of
+ * the binding graph and for the multibinding vectors is allocated from it. For example, a server can pass a
+ * per-request arena so that all the memory of the injector for a request is released in bulk.
+ * Objects returned (as pointers) by user-supplied providers are still allocated by those providers and destroyed with
+ * `delete'.
+ * 
+ * The MemoryResource must outlive all the objects that use it.
+ */
+class MemoryResource {
+public:
+  virtual ~MemoryResource() = default;
+  
+  // Allocates (at least) `size' bytes aligned to `alignment' bytes. This must not return nullptr, it should throw an
+  // exception (e.g. std::bad_alloc) instead if the memory can't be allocated.
+  virtual void* allocate(std::size_t size, std::size_t alignment) = 0;
+  
+  // Deallocates the memory at `p', returned by a call to allocate() with the same size and alignment.
+  // An arena can implement this as a no-op, and then release all the memory at once.
+  virtual void deallocate(void* p, std::size_t size, std::size_t alignment) = 0;
+};
+
+} // namespace fruit
+
+#endif // FRUIT_MEMORY_RESOURCE_H
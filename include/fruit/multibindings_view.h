@@ -0,0 +1,195 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRUIT_MULTIBINDINGS_VIEW_H
+#define FRUIT_MULTIBINDINGS_VIEW_H
+
+#include <fruit/impl/fruit_internal_forward_decls.h>
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+namespace fruit {
+
+/**
+ * A read-only range of the C* pointers to the multibindings of C in an injector, as returned by
+ * Injector::getMultibindingsView<C>().
+ * 
+ * Unlike the std::vector returned by Injector::getMultibindings(), this doesn't allocate any memory: it refers directly to
+ * the multibinding objects stored in the injector. So a MultibindingsView is cheap to copy, but it's only valid until the
+ * injector is destroyed (or until Injector::reset() is called).
+ * 
+ * The elements are in the same order as in the vector returned by Injector::getMultibindings().
+ */
+template <typename C>
+class MultibindingsView {
+public:
+  class iterator {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = C*;
+    using difference_type = std::ptrdiff_t;
+    using pointer = C* const*;
+    using reference = C*;
+    
+    iterator() = default;
+    
+    C* operator*() const;
+    C* operator[](difference_type n) const;
+    
+    iterator& operator++();
+    iterator operator++(int);
+    iterator& operator--();
+    iterator operator--(int);
+    iterator& operator+=(difference_type n);
+    iterator& operator-=(difference_type n);
+    iterator operator+(difference_type n) const;
+    iterator operator-(difference_type n) const;
+    difference_type operator-(const iterator& other) const;
+    
+    bool operator==(const iterator& other) const;
+    bool operator!=(const iterator& other) const;
+    bool operator<(const iterator& other) const;
+    bool operator<=(const iterator& other) const;
+    bool operator>(const iterator& other) const;
+    bool operator>=(const iterator& other) const;
+    
+  private:
+    // The objects are stored as (casted) C* pointers in the injector.
+    void* const* p = nullptr;
+    
+    explicit iterator(void* const* p);
+    
+    friend class MultibindingsView;
+  };
+  
+  using const_iterator = iterator;
+  using value_type = C*;
+  using size_type = std::size_t;
+  
+  // Constructs an empty view.
+  MultibindingsView() = default;
+  
+  iterator begin() const;
+  iterator end() const;
+  
+  std::size_t size() const;
+  bool empty() const;
+  
+  C* operator[](std::size_t i) const;
+  
+  // Copies the pointers to a new std::vector.
+  std::vector<C*> toVector() const;
+  
+private:
+  void* const* elems_begin = nullptr;
+  void* const* elems_end = nullptr;
+  
+  MultibindingsView(void* const* elems_begin, void* const* elems_end);
+  
+  friend class fruit::impl::InjectorStorage;
+};
+
+/**
+ * A read-only range of the C* pointers to the multibindings of C in an injector, as returned by
+ * Injector::getLazyMultibindings<C>().
+ * 
+ * Unlike MultibindingsView, this doesn't construct the multibinding objects upfront: each object is constructed (if it
+ * wasn't already) when an iterator pointing to it is dereferenced. So if only some of the elements are visited, e.g. with
+ * findFirst(), the other ones are never constructed.
+ * 
+ * The elements are in the same order as in the vector returned by Injector::getMultibindings().
+ * A LazyMultibindingsView is only valid until the injector is destroyed.
+ */
+template <typename C>
+class LazyMultibindingsView {
+public:
+  class iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = C*;
+    using difference_type = std::ptrdiff_t;
+    using pointer = C* const*;
+    using reference = C*;
+    
+    iterator() = default;
+    
+    // Constructs the object (if needed) and returns it.
+    C* operator*() const;
+    
+    iterator& operator++();
+    iterator operator++(int);
+    
+    bool operator==(const iterator& other) const;
+    bool operator!=(const iterator& other) const;
+    
+  private:
+    fruit::impl::InjectorStorage* storage = nullptr;
+    
+    // The index of the element in the injector's multibindings.
+    std::size_t elem_index = 0;
+    
+    iterator(fruit::impl::InjectorStorage* storage, std::size_t elem_index);
+    
+    friend class LazyMultibindingsView;
+  };
+  
+  using const_iterator = iterator;
+  using value_type = C*;
+  using size_type = std::size_t;
+  
+  // Constructs an empty view.
+  LazyMultibindingsView() = default;
+  
+  iterator begin() const;
+  iterator end() const;
+  
+  // These don't construct any object.
+  std::size_t size() const;
+  bool empty() const;
+  
+  // Constructs the i-th object (if needed) and returns it.
+  C* operator[](std::size_t i) const;
+  
+  /**
+   * Returns the first element `c' such that predicate(c) is true, or nullptr if there's no such element.
+   * The predicate is called with a C*. Only the elements up to the returned one are constructed.
+   */
+  template <typename Predicate>
+  C* findFirst(Predicate predicate) const;
+  
+private:
+  // The injector that stores the multibindings. For child injectors this might be an ancestor of the injector that
+  // returned this view.
+  fruit::impl::InjectorStorage* storage = nullptr;
+  
+  // The indexes of the elements in the injector's multibindings.
+  std::size_t elems_begin = 0;
+  std::size_t elems_end = 0;
+  
+  LazyMultibindingsView(fruit::impl::InjectorStorage* storage, std::size_t elems_begin, std::size_t elems_end);
+  
+  static C* getElem(fruit::impl::InjectorStorage* storage, std::size_t elem_index);
+  
+  friend class fruit::impl::InjectorStorage;
+};
+
+} // namespace fruit
+
+#include <fruit/impl/multibindings_view.defn.h>
+
+#endif // FRUIT_MULTIBINDINGS_VIEW_H
@@ -28,6 +28,62 @@
 
 namespace fruit {
 
+/**
+ * Options for the NormalizedComponent constructor that takes a NormalizedComponentOptions. Set the ones you need by
+ * name, the others keep their default values:
+ * 
+ * NormalizedComponentOptions options;
+ * options.prune_unreachable_bindings = true;
+ * NormalizedComponent<Required<Request>, Bar, Bar2> normalizedComponent(getComponent(), options);
+ */
+struct NormalizedComponentOptions {
+  // The number of threads used to normalize the component (0 means the number of hardware threads). The result is the
+  // same as with 1 thread; this is only worth it for very large components (with tens of thousands of bindings), for
+  // smaller ones the cost of starting the threads dominates.
+  std::size_t num_threads = 1;
+  
+  // If true, the bindings that can't be reached from the types provided by the component (or from the multibindings)
+  // are removed, so they don't take space in the injectors created from the NormalizedComponent. Note that such types
+  // can then no longer be retrieved with unsafeGet(), and eagerlyInjectAll() won't construct them.
+  bool prune_unreachable_bindings = false;
+  
+  // If true, the objects that don't depend (directly or indirectly) on the required types or on a Provider are
+  // constructed in the NormalizedComponent (instead of in each injector), and then shared by all the injectors created
+  // from it. Only the objects that depend on the types bound by each injector are then constructed in the injectors.
+  // This changes the semantics of the component: the shared objects are constructed even if no injector uses them,
+  // they're destroyed with the NormalizedComponent and they might be used concurrently by injectors in different
+  // threads, so they should not be modified after their construction.
+  bool hoist_request_independent_bindings = false;
+  
+  // The types bound only in the component passed to an Injector created from the NormalizedComponent are looked up in a
+  // small bucketed hash table, while the perfect hash table of the NormalizedComponent is shared. If there are more than
+  // this many such types, the injector builds a new perfect hash table with all the types instead: this makes the
+  // injector's construction slower but its lookups faster. See BindingLookupStatistics.
+  std::size_t max_bucketed_bindings = 64;
+};
+
+/**
+ * Statistics about the hash tables used to look up the bindings of a NormalizedComponent or of an Injector. These are
+ * O(n) to compute, they're meant to tune NormalizedComponentOptions::max_bucketed_bindings.
+ */
+struct BindingLookupStatistics {
+  // The number of types found with a single probe in a perfect hash table.
+  std::size_t num_perfect_hash_types;
+  
+  // The size of the perfect hash table (0 if there's none).
+  std::size_t num_perfect_hash_slots;
+  
+  // True if an injector shares the perfect hash table of the NormalizedComponent it was created from.
+  bool perfect_hash_table_shared;
+  
+  // The number of types in the bucketed hash table, that's checked when the perfect hash lookup fails.
+  std::size_t num_bucketed_types;
+  
+  // The number of buckets (0 if there's no bucketed hash table) and the number of types in the fullest one.
+  std::size_t num_buckets;
+  std::size_t max_bucket_size;
+};
+
 /**
  * This class allows for fast creation of multiple injectors that share most (or all) the bindings.
  * 
@@ -61,6 +117,39 @@ public:
   // Component<Required<...>, ...>.
   NormalizedComponent(const Component<Params...>& component);
   
+  // Same as above, but with the specified options. See NormalizedComponentOptions for details.
+  NormalizedComponent(const Component<Params...>& component, const NormalizedComponentOptions& options);
+  
+  // Same as above, but normalizes the component using num_threads threads (or the number of hardware threads, if
+  // num_threads is 0). See NormalizedComponentOptions::num_threads.
+  NormalizedComponent(const Component<Params...>& component, std::size_t num_threads);
+  
+  // Same as the 1-argument constructor, but the binding graph is allocated from `memory_resource', that must outlive
+  // this object. See MemoryResource for more details.
+  NormalizedComponent(const Component<Params...>& component, MemoryResource& memory_resource);
+  
+  // The number of bindings removed because they were unreachable. This is always 0 unless
+  // NormalizedComponentOptions::prune_unreachable_bindings was set.
+  std::size_t getNumPrunedBindings() const;
+  
+  // The number of bytes that won't be allocated in each injector thanks to the removed bindings.
+  std::size_t getNumPrunedBytes() const;
+  
+  // The number of bindings whose objects were constructed in this NormalizedComponent and are shared by all injectors.
+  // This is always 0 unless NormalizedComponentOptions::hoist_request_independent_bindings was set.
+  std::size_t getNumHoistedBindings() const;
+  
+  // See BindingLookupStatistics.
+  BindingLookupStatistics getBindingLookupStatistics() const;
+  
+  // The memory chunks where the injectors created from this NormalizedComponent construct their objects are not freed
+  // when an injector is destroyed, they're kept in a cache (that has a chunk list for each thread) and reused by later
+  // injectors instead.
+  // These return the number of injector allocations that reused a cached chunk and the number of allocations that
+  // allocated a new chunk. This doesn't include the injectors constructed with a MemoryResource.
+  std::size_t getNumAllocatorCacheHits() const;
+  std::size_t getNumAllocatorCacheMisses() const;
+  
   NormalizedComponent(NormalizedComponent&&) = default;
   NormalizedComponent(const NormalizedComponent&) = delete;
   
@@ -75,6 +164,9 @@ private:
   template <typename... OtherParams>
   friend class Injector;
   
+  template <typename... OtherParams>
+  friend class PreparedInjector;
+  
   using Comp = fruit::impl::meta::Eval<fruit::impl::meta::ConstructComponentImpl(fruit::impl::meta::Type<Params>...)>;
 
   using Check1 = typename fruit::impl::meta::CheckIfError<Comp>::type;
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRUIT_PREPARED_INJECTOR_H
+#define FRUIT_PREPARED_INJECTOR_H
+
+// This include is not required here, but having it here shortens the include trace in error messages.
+#include <fruit/impl/injection_errors.h>
+
+#include <fruit/component.h>
+#include <fruit/normalized_component.h>
+#include <fruit/injector.h>
+#include <fruit/impl/storage/prepared_injector_storage_holder.h>
+
+namespace fruit {
+
+/**
+ * A PreparedInjector allows for even faster creation of injectors from a NormalizedComponent, in the common case where the
+ * Component passed to the Injector constructor has always the same bindings, and only the objects bound with instance
+ * bindings differ (e.g. a component that binds the current request in a server).
+ * 
+ * It's constructed once, from the NormalizedComponent and a sample Component. Injectors constructed from the PreparedInjector
+ * and a Component with the same bindings as the sample one don't need to process any binding, they only copy the prepared
+ * injection graph and fill in the bound instances.
+ * 
+ * Example usage in a server:
+ * 
+ * // In the global scope.
+ * Component<Request> getRequestComponent(Request& request) {
+ *   return fruit::createComponent()
+ *       .bindInstance(request);
+ * }
+ * 
+ * // At startup (e.g. inside main()).
+ * NormalizedComponent<Required<Request>, Bar, Bar2> normalizedComponent = ...;
+ * Request sampleRequest = ...;
+ * PreparedInjector<Foo, Bar> preparedInjector(normalizedComponent, getRequestComponent(sampleRequest));
+ * 
+ * ...
+ * for (...) {
+ *   // For each request.
+ *   Request request = ...;
+ *   
+ *   Injector<Foo, Bar> injector(preparedInjector, getRequestComponent(request));
+ *   Foo* foo = injector.get<Foo*>();
+ *   ...
+ * }
+ * 
+ * If the Component passed to the Injector constructor doesn't have the same bindings as the sample one, the program will be
+ * aborted with a fatal error at runtime.
+ * 
+ * The NormalizedComponent must remain valid during the lifetime of the PreparedInjector, and the PreparedInjector must remain
+ * valid during the lifetime of any Injector object constructed with it.
+ * The sample Component's instances don't need to outlive the PreparedInjector, they're never injected.
+ */
+template <typename... P>
+class PreparedInjector {
+public:
+  /**
+   * Creation of a prepared injector from a normalized component and a sample component.
+   * The checks performed here are the same as the ones performed by the Injector constructor that takes a NormalizedComponent
+   * and a Component.
+   */
+  template <typename... NormalizedComponentParams, typename... ComponentParams>
+  PreparedInjector(const NormalizedComponent<NormalizedComponentParams...>& normalized_component,
+                   Component<ComponentParams...> component);
+  
+  /**
+   * Deleted constructor, to ensure that constructing a PreparedInjector from a temporary NormalizedComponent doesn't compile.
+   * The NormalizedComponent must remain valid during the lifetime of the PreparedInjector.
+   */
+  template <typename... NormalizedComponentParams, typename... ComponentParams>
+  PreparedInjector(NormalizedComponent<NormalizedComponentParams...>&& normalized_component,
+                   Component<ComponentParams...> component) = delete;
+  
+  PreparedInjector(PreparedInjector&&) = default;
+  PreparedInjector(const PreparedInjector&) = delete;
+  
+  PreparedInjector& operator=(PreparedInjector&&) = delete;
+  PreparedInjector& operator=(const PreparedInjector&) = delete;
+  
+private:
+  // This is held via a unique_ptr to avoid including prepared_injector_storage.h
+  // in fruit.h.
+  fruit::impl::PreparedInjectorStorageHolder storage;
+  
+  template <typename... OtherPs>
+  friend class Injector;
+};
+
+} // namespace fruit
+
+#include <fruit/impl/prepared_injector.defn.h>
+
+#endif // FRUIT_PREPARED_INJECTOR_H
@@ -21,13 +21,17 @@
 #include <vector>
 #include <iostream>
 #include <algorithm>
+#include <cstdint>
+#include <numeric>
 #include <fruit/impl/util/type_info.h>
 
 #include <fruit/impl/storage/injector_storage.h>
 #include <fruit/impl/storage/component_storage.h>
 #include <fruit/impl/data_structures/semistatic_graph.templates.h>
+#include <fruit/impl/data_structures/semistatic_map.templates.h>
 #include <fruit/impl/meta/basics.h>
 #include <fruit/impl/storage/normalized_component_storage.h>
+#include <fruit/impl/util/parallel_ranges.h>
 
 using std::cout;
 using std::endl;
@@ -43,11 +47,37 @@ std::string multipleBindingsError(TypeId type) {
         + "If the source of the problem is unclear, try exposing this type in all the component signatures where it's bound; if no component hides it this can't happen.\n";
 }
 
+auto typeInfoLessThanForBindings = [](const std::pair<TypeId, BindingData>& x,
+                                      const std::pair<TypeId, BindingData>& y) {
+  return x.first < y.first;
+};
+
 auto typeInfoLessThanForMultibindings = [](const std::pair<TypeId, MultibindingData>& x,
                                            const std::pair<TypeId, MultibindingData>& y) {
   return x.first < y.first;
 };
 
+// Reports an error for the first type (in the order of bindings_vector) that has inconsistent bindings, and calls exit(1).
+// This doesn't depend on how the bindings were split into shards, so the same error is reported for any num_threads.
+// This is only called if there is at least one such type, so its cost doesn't matter.
+void reportFirstConflictingBinding(const std::vector<std::pair<TypeId, BindingData>>& bindings_vector) {
+  HashMap<TypeId, BindingData> first_binding_by_type = createHashMap<TypeId, BindingData>(bindings_vector.size());
+  HashSet<TypeId> conflicting_types = createHashSet<TypeId>();
+  for (const std::pair<TypeId, BindingData>& p : bindings_vector) {
+    auto itr = first_binding_by_type.emplace(p.first, p.second).first;
+    if (!(itr->second == p.second)) {
+      conflicting_types.insert(p.first);
+    }
+  }
+  for (const std::pair<TypeId, BindingData>& p : bindings_vector) {
+    if (conflicting_types.count(p.first) != 0) {
+      std::cerr << multipleBindingsError(p.first) << std::endl;
+      exit(1);
+    }
+  }
+  FruitAssert(false);
+}
+
 } // namespace
 
 namespace fruit {
@@ -59,145 +89,547 @@ BindingNormalization::normalizeBindings(const std::vector<std::pair<TypeId, Bind
                                         std::vector<CompressedBinding>&& compressed_bindings_vector,
                                         const std::vector<std::pair<TypeId, MultibindingData>>& multibindings_vector,
                                         const std::vector<TypeId>& exposed_types,
-                                        BindingNormalization::BindingCompressionInfoMap& bindingCompressionInfoMap) {
-  HashMap<TypeId, BindingData> binding_data_map = createHashMap<TypeId, BindingData>(bindings_vector.size());
-  
-  for (auto& p : bindings_vector) {
-    auto itr = binding_data_map.find(p.first);
-    if (itr != binding_data_map.end()) {
-      if (!(p.second == itr->second)) {
-        std::cerr << multipleBindingsError(p.first) << std::endl;
-        exit(1);
+                                        BindingNormalization::BindingCompressionInfoMap& bindingCompressionInfoMap,
+                                        std::size_t num_threads,
+                                        PruningStatistics* pruning_statistics) {
+  num_threads = getNumThreads(num_threads);
+  
+  // The bindings are partitioned into shards by the hash of their type, and each shard is sorted by type in a separate
+  // thread. The bindings for the i-th shard are in the range [shard_begin[i], shard_begin[i+1]) of `result'.
+  // With a single thread there's a single shard, so `result' is just sorted by type.
+  std::size_t num_shards = std::max(std::min(num_threads, bindings_vector.size()), std::size_t(1));
+  std::vector<std::size_t> shard_begin(num_shards + 1, 0);
+  auto shard_of = [num_shards](TypeId type) -> std::size_t {
+    // The multiplication mixes the bits of the hash (a pointer, whose low-order bits are always 0).
+    return std::size_t((std::uint64_t(std::hash<TypeId>()(type)) * 0x9E3779B97F4A7C15ULL) >> 32) % num_shards;
+  };
+  
+  // This is the only vector of bindings that we allocate. All the steps below work in-place on this vector or on
+  // compressed_bindings_vector (that we own).
+  std::vector<std::pair<TypeId, BindingData>> result;
+  if (num_shards == 1) {
+    result = bindings_vector;
+  } else {
+    // A counting sort by shard. This is stable, so duplicate bindings remain in the same order.
+    for (const auto& p : bindings_vector) {
+      ++shard_begin[shard_of(p.first) + 1];
+    }
+    std::partial_sum(shard_begin.begin(), shard_begin.end(), shard_begin.begin());
+    std::vector<std::size_t> shard_next(shard_begin.begin(), shard_begin.end() - 1);
+    result.resize(bindings_vector.size());
+    for (const auto& p : bindings_vector) {
+      result[shard_next[shard_of(p.first)]++] = p;
+    }
+  }
+  shard_begin[num_shards] = result.size();
+  
+  // Step 1: sort the bindings in each shard by type and remove duplicates (checking that they're consistent).
+  // shard_end[i] is the end of the deduplicated bindings of the i-th shard, and conflicting_types[i] is a type with
+  // inconsistent bindings in that shard (if any).
+  std::vector<std::size_t> shard_end(num_shards);
+  std::vector<TypeId> conflicting_types(num_shards, TypeId{nullptr});
+  auto normalize_shard = [&result, &shard_begin, &shard_end, &conflicting_types](std::size_t shard) {
+    auto shard_first = result.begin() + shard_begin[shard];
+    auto shard_last = result.begin() + shard_begin[shard + 1];
+    std::stable_sort(shard_first, shard_last, typeInfoLessThanForBindings);
+    auto shard_result_end = shard_first;
+    for (auto i = shard_first; i != shard_last; /* no increment */) {
+      *shard_result_end = *i;
+      for (++i; i != shard_last && i->first == shard_result_end->first; ++i) {
+        if (!(i->second == shard_result_end->second) && conflicting_types[shard] == TypeId{nullptr}) {
+          conflicting_types[shard] = i->first;
+        }
+        // Otherwise ok, duplicate but consistent binding.
       }
-      // Otherwise ok, duplicate but consistent binding.
-      
-    } else {
-      // New binding, add it to the map.
-      binding_data_map[p.first] = p.second;
+      ++shard_result_end;
+    }
+    shard_end[shard] = shard_result_end - result.begin();
+  };
+  if (num_shards == 1) {
+    normalize_shard(0);
+  } else {
+    forEachRangeInParallel(num_shards, num_shards, [&normalize_shard](std::size_t, std::size_t begin, std::size_t end) {
+      for (std::size_t shard = begin; shard < end; ++shard) {
+        normalize_shard(shard);
+      }
+    });
+  }
+  for (TypeId type : conflicting_types) {
+    if (type != TypeId{nullptr}) {
+      reportFirstConflictingBinding(bindings_vector);
+    }
+  }
+  
+  // Move the shards next to each other.
+  std::size_t result_size = 0;
+  for (std::size_t shard = 0; shard < num_shards; ++shard) {
+    std::size_t shard_size = shard_end[shard] - shard_begin[shard];
+    std::move(result.begin() + shard_begin[shard], result.begin() + shard_end[shard], result.begin() + result_size);
+    shard_begin[shard] = result_size;
+    result_size += shard_size;
+  }
+  shard_begin[num_shards] = result_size;
+  result.erase(result.begin() + result_size, result.end());
+  
+  // Returns the index of the binding for the specified type in `result', or result.size() if the type is not bound.
+  auto find_binding_index = [&result, &shard_begin, &shard_of](TypeId type_id) -> std::size_t {
+    std::size_t shard = shard_of(type_id);
+    auto shard_last = result.begin() + shard_begin[shard + 1];
+    auto itr = std::lower_bound(result.begin() + shard_begin[shard], shard_last, type_id,
+                                [](const std::pair<TypeId, BindingData>& x, TypeId y) {
+                                  return x.first < y;
+                                });
+    if (itr == shard_last || itr->first != type_id) {
+      return result.size();
     }
+    return itr - result.begin();
+  };
+  
+  // Returns the binding for the specified type. The type must be bound.
+  auto find_binding = [&result, &find_binding_index](TypeId type_id) -> std::pair<TypeId, BindingData>& {
+    std::size_t index = find_binding_index(type_id);
+    FruitAssert(index != result.size());
+    return result[index];
+  };
+  
+  // Step 2 (only if pruning_statistics!=nullptr): find the bindings reachable from the exposed types and from the deps
+  // of the multibindings. The required types of the component are not bound here, and the bindings that will provide
+  // them (in each injector) can only depend on exposed types, so they don't need to be considered.
+  // This is done before the binding compressions, but the result is the same: the C type of a compression that will
+  // be performed is only reachable through its I type.
+  // reachable[i] is true iff result[i] is reachable.
+  std::vector<bool> reachable;
+  if (pruning_statistics != nullptr) {
+    reachable.assign(result.size(), false);
+    std::vector<std::size_t> indexes_to_visit;
+    auto visit = [&reachable, &indexes_to_visit, &find_binding_index](TypeId type_id) {
+      std::size_t index = find_binding_index(type_id);
+      if (index != reachable.size() && !reachable[index]) {
+        reachable[index] = true;
+        indexes_to_visit.push_back(index);
+      }
+    };
+    for (TypeId type : exposed_types) {
+      visit(type);
+    }
+    for (const auto& p : multibindings_vector) {
+      const BindingDeps* deps = p.second.deps;
+      if (deps != nullptr) {
+        for (std::size_t i = 0; i < deps->num_deps; ++i) {
+          visit(deps->deps[i]);
+        }
+      }
+    }
+    while (!indexes_to_visit.empty()) {
+      const BindingData& binding_data = result[indexes_to_visit.back()].second;
+      indexes_to_visit.pop_back();
+      if (!binding_data.isCreated()) {
+        for (std::size_t i = 0; i < binding_data.getDeps()->num_deps; ++i) {
+          visit(binding_data.getDeps()->deps[i]);
+        }
+      }
+    }
+    pruning_statistics->num_pruned_bindings = std::count(reachable.begin(), reachable.end(), false);
   }
   
-  for (const auto& p : bindings_vector) {
-    if (p.second.needsAllocation()) {
-      fixed_size_allocator_data.addType(p.first);
+  // Each (reachable) type is added once, even if it was bound multiple times.
+  FixedSizeAllocator::FixedSizeAllocatorData pruned_allocator_data;
+  for (std::size_t j = 0; j < result.size(); ++j) {
+    FixedSizeAllocator::FixedSizeAllocatorData& allocator_data =
+        (reachable.empty() || reachable[j]) ? fixed_size_allocator_data : pruned_allocator_data;
+    if (result[j].second.needsAllocation()) {
+      allocator_data.addType(result[j].first);
     } else {
-      fixed_size_allocator_data.addExternallyAllocatedType(p.first);
+      allocator_data.addExternallyAllocatedType(result[j].first);
     }
   }
+  if (pruning_statistics != nullptr) {
+    pruning_statistics->num_pruned_bytes = pruned_allocator_data.getAllocatedSize();
+#ifdef FRUIT_EXTRA_DEBUG
+    std::cout << "InjectorStorage: pruned " << pruning_statistics->num_pruned_bindings << " unreachable bindings ("
+              << pruning_statistics->num_pruned_bytes << " bytes)" << std::endl;
+#endif
+  }
   
-  // Remove duplicates from `compressedBindingsVector'.
+  // Step 3: sort `compressed_bindings_vector' by C and remove duplicates, keeping the last binding for each C.
+  // No need to check for multiple I->C, I2->C mappings, will filter these out later when considering deps.
+  std::stable_sort(compressed_bindings_vector.begin(), compressed_bindings_vector.end(),
+                   [](const CompressedBinding& x, const CompressedBinding& y) {
+                     return x.class_id < y.class_id;
+                   });
+  auto compressed_bindings_end = compressed_bindings_vector.begin();
+  for (auto i = compressed_bindings_vector.begin(); i != compressed_bindings_vector.end(); ++i) {
+    if (i + 1 == compressed_bindings_vector.end() || !(i->class_id == (i + 1)->class_id)) {
+      *compressed_bindings_end = *i;
+      ++compressed_bindings_end;
+    }
+  }
+  compressed_bindings_vector.erase(compressed_bindings_end, compressed_bindings_vector.end());
   
-  // CtypeId -> (ItypeId, bindingData)
-  HashMap<TypeId, std::pair<TypeId, BindingData>> compressed_bindings_map =
-      createHashMap<TypeId, std::pair<TypeId, BindingData>>(compressed_bindings_vector.size());
+  // Returns the compressed binding with the specified C, or nullptr if there's none.
+  auto find_compressed_binding = [&compressed_bindings_vector](TypeId c_id) -> CompressedBinding* {
+    auto itr = std::lower_bound(compressed_bindings_vector.begin(), compressed_bindings_vector.end(), c_id,
+                                [](const CompressedBinding& x, TypeId y) {
+                                  return x.class_id < y;
+                                });
+    if (itr == compressed_bindings_vector.end() || !(itr->class_id == c_id)) {
+      return nullptr;
+    }
+    return &*itr;
+  };
   
-  // This also removes any duplicates. No need to check for multiple I->C, I2->C mappings, will filter these out later when 
-  // considering deps.
-  for (CompressedBinding& compressed_binding : compressed_bindings_vector) {
-    compressed_bindings_map[compressed_binding.class_id] = {compressed_binding.interface_id, compressed_binding.binding_data};
-  }
+  // Step 4: determine which compressed bindings can't be performed. These are marked by setting their interface_id to
+  // TypeId{nullptr}, so that we don't have to change the order of compressed_bindings_vector while we search it.
+  auto disable_compressed_binding = [&find_compressed_binding](TypeId c_id) {
+    CompressedBinding* compressed_binding = find_compressed_binding(c_id);
+    if (compressed_binding != nullptr) {
+      compressed_binding->interface_id = TypeId{nullptr};
+    }
+  };
   
   // We can't compress the binding if C is a dep of a multibinding.
-  for (auto p : multibindings_vector) {
+  for (const auto& p : multibindings_vector) {
     const BindingDeps* deps = p.second.deps;
     if (deps != nullptr) {
       for (std::size_t i = 0; i < deps->num_deps; ++i) {
-        compressed_bindings_map.erase(deps->deps[i]);
+        disable_compressed_binding(deps->deps[i]);
       }
     }
   }
   
   // We can't compress the binding if C is an exposed type (but I is likely to be exposed instead).
   for (TypeId type : exposed_types) {
-    compressed_bindings_map.erase(type);
+    disable_compressed_binding(type);
   }
   
   // We can't compress the binding if some type X depends on C and X!=I.
-  for (auto& p : binding_data_map) {
-    TypeId x_id = p.first;
-    BindingData binding_data = p.second;
-    if (!binding_data.isCreated()) {
-      for (std::size_t i = 0; i < binding_data.getDeps()->num_deps; ++i) {
-        TypeId c_id = binding_data.getDeps()->deps[i];
-        auto itr = compressed_bindings_map.find(c_id);
-        if (itr != compressed_bindings_map.end() && itr->second.first != x_id) {
-          compressed_bindings_map.erase(itr);
+  // The bindings are split among the threads, and each thread collects the C types in c_types_to_disable[thread_index]
+  // (so that compressed_bindings_vector is only read while the threads are running).
+  std::vector<std::vector<TypeId>> c_types_to_disable(num_threads);
+  auto find_c_types_to_disable = [&result, &find_compressed_binding, &c_types_to_disable](
+      std::size_t thread_index, std::size_t begin, std::size_t end) {
+    for (std::size_t j = begin; j < end; ++j) {
+      TypeId x_id = result[j].first;
+      const BindingData& binding_data = result[j].second;
+      if (!binding_data.isCreated()) {
+        for (std::size_t i = 0; i < binding_data.getDeps()->num_deps; ++i) {
+          TypeId c_id = binding_data.getDeps()->deps[i];
+          CompressedBinding* compressed_binding = find_compressed_binding(c_id);
+          if (compressed_binding != nullptr && compressed_binding->interface_id != x_id) {
+            c_types_to_disable[thread_index].push_back(c_id);
+          }
         }
       }
     }
+  };
+  if (num_threads == 1 || compressed_bindings_vector.empty()) {
+    find_c_types_to_disable(0, 0, result.size());
+  } else {
+    forEachRangeInParallel(result.size(), num_threads, find_c_types_to_disable);
+  }
+  for (const std::vector<TypeId>& c_types : c_types_to_disable) {
+    for (TypeId c_id : c_types) {
+      disable_compressed_binding(c_id);
+    }
   }
   
   // Two pairs of compressible bindings (I->C) and (C->X) can not exist (the C of a compressible binding is always bound either
   // using constructor binding or provider binding, it can't be a binding itself). So no need to check for that.
   
-  bindingCompressionInfoMap = 
-      createHashMap<TypeId, BindingNormalization::BindingCompressionInfo>(compressed_bindings_map.size());
-  
-  // Now perform the binding compression.
-  for (auto& p : compressed_bindings_map) {
-    TypeId c_id = p.first;
-    TypeId i_id = p.second.first;
-    BindingData binding_data = p.second.second;
-    auto i_binding_data = binding_data_map.find(i_id);
-    auto c_binding_data = binding_data_map.find(c_id);
-    FruitAssert(i_binding_data != binding_data_map.end());
-    FruitAssert(c_binding_data != binding_data_map.end());
-    bindingCompressionInfoMap[c_id] = BindingCompressionInfo{i_id, i_binding_data->second, c_binding_data->second};
+  // Step 5: perform the binding compressions. Since compressed_bindings_vector is sorted by C, bindingCompressionInfoMap
+  // will be sorted too.
+  bindingCompressionInfoMap.clear();
+  std::size_t num_compressions = 0;
+  // The compressions whose I type is unreachable are not performed (I and C will both be removed), since they couldn't
+  // be undone later.
+  auto is_compression_performed = [&reachable, &find_binding_index](const CompressedBinding& compressed_binding) {
+    return compressed_binding.interface_id != TypeId{nullptr}
+        && (reachable.empty() || reachable[find_binding_index(compressed_binding.interface_id)]);
+  };
+  for (const CompressedBinding& compressed_binding : compressed_bindings_vector) {
+    if (is_compression_performed(compressed_binding)) {
+      ++num_compressions;
+    }
+  }
+  bindingCompressionInfoMap.reserve(num_compressions);
+  for (const CompressedBinding& compressed_binding : compressed_bindings_vector) {
+    if (!is_compression_performed(compressed_binding)) {
+      continue;
+    }
+    TypeId c_id = compressed_binding.class_id;
+    TypeId i_id = compressed_binding.interface_id;
+    std::pair<TypeId, BindingData>& i_binding = find_binding(i_id);
+    std::pair<TypeId, BindingData>& c_binding = find_binding(c_id);
+    bindingCompressionInfoMap.push_back(
+        std::make_pair(c_id, BindingCompressionInfo{i_id, i_binding.second, c_binding.second}));
     // Note that even if I is the one that remains, C is the one that will be allocated, not I.
-    FruitAssert(!i_binding_data->second.needsAllocation());
-    i_binding_data->second = binding_data;
-    binding_data_map.erase(c_binding_data);
+    FruitAssert(!i_binding.second.needsAllocation());
+    i_binding.second = compressed_binding.binding_data;
 #ifdef FRUIT_EXTRA_DEBUG
     std::cout << "InjectorStorage: performing binding compression for the edge " << i_id << "->" << c_id << std::endl;
 #endif
   }
+  
+  // Step 6: remove the bindings for the C types of the performed compressions, and the unreachable bindings.
+  // Both vectors are sorted by type (within each shard), so this is a linear merge for each shard.
+  auto result_end = result.begin();
+  for (std::size_t shard = 0; shard < num_shards; ++shard) {
+    auto compression_itr = bindingCompressionInfoMap.begin();
+    for (auto i = result.begin() + shard_begin[shard], shard_last = result.begin() + shard_begin[shard + 1];
+         i != shard_last;
+         ++i) {
+      while (compression_itr != bindingCompressionInfoMap.end() && compression_itr->first < i->first) {
+        ++compression_itr;
+      }
+      bool compressed = compression_itr != bindingCompressionInfoMap.end() && compression_itr->first == i->first;
+      bool pruned = !reachable.empty() && !reachable[i - result.begin()];
+      if (!compressed && !pruned) {
+        *result_end = *i;
+        ++result_end;
+      }
+    }
+  }
+  result.erase(result_end, result.end());
+  
+  return result;
+}
 
-  // Copy the normalized bindings into the result vector.
-  std::vector<std::pair<TypeId, BindingData>> result;
-  result.reserve(binding_data_map.size());
-  for (auto& p : binding_data_map) {
-    result.push_back(p);
+const BindingNormalization::BindingCompressionInfo* BindingNormalization::findBindingCompressionInfo(
+    const BindingCompressionInfoMap& bindingCompressionInfoMap, TypeId cTypeId) {
+  auto itr = std::lower_bound(bindingCompressionInfoMap.begin(), bindingCompressionInfoMap.end(), cTypeId,
+                              [](const std::pair<TypeId, BindingCompressionInfo>& x, TypeId y) {
+                                return x.first < y;
+                              });
+  if (itr == bindingCompressionInfoMap.end() || itr->first != cTypeId) {
+    return nullptr;
+  }
+  return &(itr->second);
+}
+
+std::vector<TypeId> BindingNormalization::findRequestIndependentBindings(
+    const std::vector<std::pair<TypeId, BindingData>>& normalized_bindings,
+    const BindingCompressionInfoMap& bindingCompressionInfoMap) {
+  enum class State : char {
+    UNVISITED,
+    IN_PROGRESS,
+    INDEPENDENT,
+    DEPENDENT
+  };
+  
+  std::size_t num_bindings = normalized_bindings.size();
+  HashMap<TypeId, std::size_t> index_by_type = createHashMap<TypeId, std::size_t>(num_bindings);
+  for (std::size_t i = 0; i < num_bindings; ++i) {
+    index_by_type.insert(std::make_pair(normalized_bindings[i].first, i));
+  }
+  
+  std::vector<State> states(num_bindings, State::UNVISITED);
+  for (const auto& p : bindingCompressionInfoMap) {
+    auto itr = index_by_type.find(p.second.iTypeId);
+    if (itr != index_by_type.end()) {
+      states[itr->second] = State::DEPENDENT;
+    }
+  }
+  
+  // We use an explicit stack instead of recursion, since the graph might be very deep.
+  // Each element is a binding index and the index of the first dep of that binding that wasn't checked yet.
+  std::vector<std::pair<std::size_t, std::size_t>> stack;
+  for (std::size_t root = 0; root < num_bindings; ++root) {
+    if (states[root] != State::UNVISITED) {
+      continue;
+    }
+    states[root] = State::IN_PROGRESS;
+    stack.emplace_back(root, 0);
+    while (!stack.empty()) {
+      std::size_t i = stack.back().first;
+      const BindingData& binding_data = normalized_bindings[i].second;
+      State state = State::INDEPENDENT;
+      std::size_t unvisited_dep = num_bindings;
+      if (!binding_data.isCreated()) {
+        const BindingDeps* deps = binding_data.getDeps();
+        for (std::size_t& k = stack.back().second; k < deps->num_deps; ++k) {
+          if (deps->is_lazy[k]) {
+            state = State::DEPENDENT;
+            break;
+          }
+          auto itr = index_by_type.find(deps->deps[k]);
+          if (itr == index_by_type.end()) {
+            // A requirement of the normalized component.
+            state = State::DEPENDENT;
+            break;
+          }
+          if (states[itr->second] == State::UNVISITED) {
+            unvisited_dep = itr->second;
+            break;
+          }
+          if (states[itr->second] != State::INDEPENDENT) {
+            // Note that this also handles loops (IN_PROGRESS), those will be reported when injecting the type.
+            state = State::DEPENDENT;
+            break;
+          }
+        }
+      }
+      if (unvisited_dep != num_bindings) {
+        // The dep is visited first, then this binding's deps are checked again starting from that dep.
+        states[unvisited_dep] = State::IN_PROGRESS;
+        stack.emplace_back(unvisited_dep, 0);
+      } else {
+        states[i] = state;
+        stack.pop_back();
+      }
+    }
+  }
+  
+  std::vector<TypeId> result;
+  for (std::size_t i = 0; i < num_bindings; ++i) {
+    if (states[i] == State::INDEPENDENT && !normalized_bindings[i].second.isCreated()) {
+      result.push_back(normalized_bindings[i].first);
+    }
   }
   return result;
 }
 
-void BindingNormalization::addMultibindings(std::unordered_map<TypeId, NormalizedMultibindingData>& multibindings,
-                                            FixedSizeAllocator::FixedSizeAllocatorData& fixed_size_allocator_data,
-                                            const std::vector<std::pair<TypeId, MultibindingData>>& multibindingsVector) {
+void BindingNormalization::computeObjectLayout(const std::vector<std::pair<TypeId, BindingData>>& normalized_bindings,
+                                               const BindingCompressionInfoMap& bindingCompressionInfoMap,
+                                               SemistaticGraph<TypeId, NormalizedBindingData>& bindings,
+                                               FixedSizeAllocator::FixedSizeAllocatorData& fixed_size_allocator_data,
+                                               std::vector<std::uint32_t>& object_offsets) {
+  // The binding for the I type of a binding compression allocates a C. This contains the (I, C) pairs, sorted by I.
+  std::vector<std::pair<TypeId, TypeId>> compressed_types;
+  compressed_types.reserve(bindingCompressionInfoMap.size());
+  for (const auto& p : bindingCompressionInfoMap) {
+    compressed_types.emplace_back(p.second.iTypeId, p.first);
+  }
+  std::sort(compressed_types.begin(), compressed_types.end());
+  
+  // Contains the node index and the type of each allocated object.
+  std::vector<std::pair<std::size_t, TypeId>> objects;
+  for (const auto& p : normalized_bindings) {
+    if (p.second.isCreated() || !p.second.needsAllocation()) {
+      continue;
+    }
+    TypeId allocated_type = p.first;
+    auto itr = std::lower_bound(compressed_types.begin(), compressed_types.end(), p.first,
+                                [](const std::pair<TypeId, TypeId>& x, TypeId y) {
+                                  return x.first < y;
+                                });
+    if (itr != compressed_types.end() && itr->first == p.first) {
+      allocated_type = itr->second;
+    }
+    SemistaticGraph<TypeId, NormalizedBindingData>::node_iterator node_itr = bindings.at(p.first);
+    if (node_itr.isTerminal()) {
+      // A hoisted binding, the object will never be constructed in an injector.
+      fixed_size_allocator_data.removeType(allocated_type);
+      continue;
+    }
+    objects.emplace_back(bindings.indexOf(node_itr), allocated_type);
+  }
+  
+  std::sort(objects.begin(), objects.end(),
+            [](const std::pair<std::size_t, TypeId>& x, const std::pair<std::size_t, TypeId>& y) {
+              std::size_t x_alignment = x.second.type_info->alignment();
+              std::size_t y_alignment = y.second.type_info->alignment();
+              return x_alignment > y_alignment || (x_alignment == y_alignment && x.first < y.first);
+            });
+  
+  object_offsets.assign(bindings.size(), InjectorStorage::no_object_offset);
+  // Since the objects are sorted by decreasing alignment there's no padding, so the offset of each object is the size of
+  // the fixed layout so far.
+  std::size_t fixed_layout_size = 0;
+  for (const auto& p : objects) {
+    if (fixed_layout_size + p.second.type_info->size() >= InjectorStorage::no_object_offset) {
+      // The offset wouldn't fit in object_offsets. This object and the following ones stay in the bump-allocated area.
+      break;
+    }
+    fixed_size_allocator_data.removeType(p.second);
+    std::size_t object_offset = fixed_size_allocator_data.addTypeAtFixedOffset(p.second);
+    FruitAssert(object_offset == fixed_layout_size);
+    object_offsets[p.first] = std::uint32_t(object_offset);
+    fixed_layout_size += p.second.type_info->size();
+  }
+}
+
+NormalizedMultibindingSet::NormalizedMultibindingSet()
+  : index(types.begin(), 0) {
+}
+
+NormalizedMultibindingSet BindingNormalization::addMultibindings(
+    const NormalizedMultibindingSet& multibindings,
+    FixedSizeAllocator::FixedSizeAllocatorData& fixed_size_allocator_data,
+    const std::vector<std::pair<TypeId, MultibindingData>>& multibindingsVector) {
 
   std::vector<std::pair<TypeId, MultibindingData>> sortedMultibindingsVector = multibindingsVector;
-  std::sort(sortedMultibindingsVector.begin(), sortedMultibindingsVector.end(),
-            typeInfoLessThanForMultibindings);
+  // We use a stable sort so that the multibindings for each type are stored in the same order in which they were added.
+  std::stable_sort(sortedMultibindingsVector.begin(), sortedMultibindingsVector.end(),
+                   typeInfoLessThanForMultibindings);
+  
+  // The range of sortedMultibindingsVector with the new multibindings for each type (in the order of the types in the
+  // result).
+  using Range = std::pair<std::vector<std::pair<TypeId, MultibindingData>>::const_iterator,
+                          std::vector<std::pair<TypeId, MultibindingData>>::const_iterator>;
+  std::vector<std::pair<const NormalizedMultibindingData*, Range>> type_ranges;
+  type_ranges.reserve(multibindings.types.size() + sortedMultibindingsVector.size());
+  
+  // The types that already had multibindings come first (in the same order), so that the elements of each type in
+  // `multibindings' keep their relative position.
+  for (const std::pair<TypeId, NormalizedMultibindingData>& p : multibindings.types) {
+    Range range = std::equal_range(sortedMultibindingsVector.cbegin(), sortedMultibindingsVector.cend(),
+                                   std::make_pair(p.first, MultibindingData(nullptr, nullptr)),
+                                   typeInfoLessThanForMultibindings);
+    type_ranges.emplace_back(&p.second, range);
+  }
+  for (auto i = sortedMultibindingsVector.cbegin(); i != sortedMultibindingsVector.cend(); /* no increment */) {
+    auto j = i;
+    while (j != sortedMultibindingsVector.cend() && j->first == i->first) {
+      ++j;
+    }
+    if (multibindings.find(i->first) == nullptr) {
+      type_ranges.emplace_back(nullptr, Range(i, j));
+    }
+    i = j;
+  }
   
 #ifdef FRUIT_EXTRA_DEBUG
   std::cout << "InjectorStorage: adding multibindings:" << std::endl;
 #endif
-  // Now we must merge multiple bindings for the same type.
-  for (auto i = sortedMultibindingsVector.begin(); i != sortedMultibindingsVector.end(); /* no increment */) {
-    const std::pair<TypeId, MultibindingData>& x = *i;
-    NormalizedMultibindingData& b = multibindings[x.first];
+  NormalizedMultibindingSet result;
+  result.elems.reserve(multibindings.elems.size() + sortedMultibindingsVector.size());
+  result.types.reserve(type_ranges.size());
+  for (const auto& type_range : type_ranges) {
+    const NormalizedMultibindingData* old_data = type_range.first;
+    Range range = type_range.second;
+    TypeId type = (old_data != nullptr) ? multibindings.types[old_data->type_index].first : range.first->first;
     
-    // Might be set already, but we need to set it if there was no multibinding for this type.
-    b.get_multibindings_vector = x.second.get_multibindings_vector;
+    NormalizedMultibindingData data;
+    data.elems_begin = result.elems.size();
+    data.type_index = result.types.size();
+    if (old_data != nullptr) {
+      data.get_multibindings_vector = old_data->get_multibindings_vector;
+      result.elems.insert(result.elems.end(),
+                          multibindings.elems.begin() + old_data->elems_begin,
+                          multibindings.elems.begin() + old_data->elems_end);
+    } else {
+      data.get_multibindings_vector = range.first->second.get_multibindings_vector;
+    }
     
 #ifdef FRUIT_EXTRA_DEBUG
-    std::cout << x.first << " has " << std::distance(i, sortedMultibindingsVector.end()) << " multibindings." << std::endl;
+    std::cout << type << " has " << (range.second - range.first) << " new multibindings." << std::endl;
 #endif
-    // Insert all multibindings for this type (note that x is also inserted here).
-    for (; i != sortedMultibindingsVector.end() && i->first == x.first; ++i) {
-      b.elems.push_back(NormalizedMultibindingData::Elem(i->second));
+    for (auto i = range.first; i != range.second; ++i) {
+      result.elems.push_back(NormalizedMultibindingSet::Elem(i->second));
       if (i->second.needs_allocation) {
-        fixed_size_allocator_data.addType(x.first);
+        fixed_size_allocator_data.addType(type);
       } else {
-        fixed_size_allocator_data.addExternallyAllocatedType(x.first);
+        fixed_size_allocator_data.addExternallyAllocatedType(type);
       }
     }
-#ifdef FRUIT_EXTRA_DEBUG
-    std::cout << std::endl;
-#endif
+    data.elems_end = result.elems.size();
+    result.types.emplace_back(type, data);
   }
+  
+  result.index = SemistaticMap<TypeId, NormalizedMultibindingData>(result.types.begin(), result.types.size());
+  
+  return result;
 }
 
-
 } // namespace impl
 } // namespace fruit
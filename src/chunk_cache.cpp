@@ -0,0 +1,88 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define IN_FRUIT_CPP_FILE
+
+#include <fruit/impl/data_structures/chunk_cache.h>
+
+using namespace fruit::impl;
+
+namespace fruit {
+namespace impl {
+
+constexpr std::size_t ChunkCache::num_shards;
+constexpr std::size_t ChunkCache::max_chunks_per_shard;
+
+ChunkCache::Shard& ChunkCache::getShard() {
+  // Threads are assigned to shards in a round-robin fashion, the first time that they use any ChunkCache.
+  static std::atomic<std::size_t> next_shard_index{0};
+  static thread_local std::size_t shard_index = next_shard_index.fetch_add(1, std::memory_order_relaxed) % num_shards;
+  return shards[shard_index];
+}
+
+ChunkCache::~ChunkCache() {
+  for (Shard& shard : shards) {
+    for (const std::pair<std::size_t, void*>& chunk : shard.chunks) {
+      operator delete(chunk.second);
+    }
+  }
+}
+
+void* ChunkCache::allocate(std::size_t size, std::size_t alignment) {
+  // Chunks are allocated with operator new, so they're suitably aligned for any alignment that operator new supports.
+  (void)alignment;
+  Shard& shard = getShard();
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    // Search from the end, so that the most recently deallocated chunk (that's more likely to be in cache) is reused.
+    for (std::size_t i = shard.chunks.size(); i > 0; --i) {
+      if (shard.chunks[i - 1].first == size) {
+        void* p = shard.chunks[i - 1].second;
+        shard.chunks.erase(shard.chunks.begin() + (i - 1));
+        num_hits.fetch_add(1, std::memory_order_relaxed);
+        return p;
+      }
+    }
+  }
+  num_misses.fetch_add(1, std::memory_order_relaxed);
+  return operator new(size);
+}
+
+void ChunkCache::deallocate(void* p, std::size_t size, std::size_t alignment) {
+  (void)alignment;
+  Shard& shard = getShard();
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.chunks.size() < max_chunks_per_shard) {
+      if (shard.chunks.capacity() == 0) {
+        shard.chunks.reserve(max_chunks_per_shard);
+      }
+      shard.chunks.emplace_back(size, p);
+      return;
+    }
+  }
+  operator delete(p);
+}
+
+std::size_t ChunkCache::getNumHits() const {
+  return num_hits.load(std::memory_order_relaxed);
+}
+
+std::size_t ChunkCache::getNumMisses() const {
+  return num_misses.load(std::memory_order_relaxed);
+}
+
+} // namespace impl
+} // namespace fruit
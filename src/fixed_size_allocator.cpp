@@ -24,14 +24,49 @@ using namespace fruit::impl;
 namespace fruit {
 namespace impl {
 
+constexpr std::size_t FixedSizeAllocator::no_object_offset;
+
+void FixedSizeAllocator::destroyAll(bool fast_exit) {
+  // Destroy all objects in reverse order. Each run of consecutive entries with the same destroy operation (e.g. for
+  // multibindings of the same type) is destroyed with a single indirect call.
+  DestructionEntry* begin = on_destruction.begin();
+  DestructionEntry* run_end = on_destruction.end();
+  while (run_end != begin) {
+    destroy_t destroy = (run_end - 1)->destroy;
+    DestructionEntry* run_begin = run_end - 1;
+    while (run_begin != begin && (run_begin - 1)->destroy == destroy) {
+      --run_begin;
+    }
+    destroy(run_begin, run_end, fast_exit);
+    run_end = run_begin;
+  }
+  on_destruction.clear();
+}
+
 FixedSizeAllocator::~FixedSizeAllocator() {
-  // Destroy all objects in reverse order.
-  std::pair<destroy_t, void*>* p = on_destruction.end();
-  while (p != on_destruction.begin()) {
-    --p;
-    p->first(p->second);
+  destroyAll(fast_exit);
+  if (storage_begin != nullptr) {
+    deallocateMemory(memory_resource, storage_begin, storage_size, 1);
   }
-  delete [] storage_begin;
+}
+
+void FixedSizeAllocator::reset() {
+  // The memory is reused after this, so all objects must be destroyed even in fast exit mode.
+  destroyAll(false /* fast_exit */);
+  if (storage_begin != nullptr) {
+    storage_last_used = fixed_layout_end - 1;
+  }
+#ifdef FRUIT_EXTRA_DEBUG
+  remaining_types = types;
+#endif
+}
+
+void FixedSizeAllocator::enableThreadSafety() {
+  thread_safe = true;
+}
+
+void FixedSizeAllocator::enableFastExit() {
+  fast_exit = true;
 }
 
 
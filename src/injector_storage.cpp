@@ -21,6 +21,8 @@
 #include <vector>
 #include <iostream>
 #include <algorithm>
+#include <mutex>
+#include <thread>
 #include <fruit/impl/util/type_info.h>
 
 #include <fruit/impl/storage/injector_storage.h>
@@ -28,6 +30,9 @@
 #include <fruit/impl/data_structures/semistatic_graph.templates.h>
 #include <fruit/impl/meta/basics.h>
 #include <fruit/impl/storage/normalized_component_storage.h>
+#include <fruit/impl/storage/prepared_injector_storage.h>
+#include <fruit/impl/util/parallel_ranges.h>
+#include <fruit/normalized_component.h>
 
 using std::cout;
 using std::endl;
@@ -43,6 +48,12 @@ std::string multipleBindingsError(TypeId type) {
         + "If the source of the problem is unclear, try exposing this type in all the component signatures where it's bound; if no component hides it this can't happen.\n";
 }
 
+std::string preparedInjectorMismatchError() {
+  return "the Component used to create this injector doesn't have the same bindings as the one used to create the PreparedInjector.\n"
+        + std::string("A PreparedInjector can only be used with components that have the same bindings as the sample component, ")
+        + "except that instance bindings (bindInstance/addInstanceMultibinding) can bind different objects.";
+}
+
 } // namespace
 
 namespace fruit {
@@ -74,25 +85,35 @@ namespace {
   };
 }
 
-InjectorStorage::InjectorStorage(const ComponentStorage& component, const std::vector<TypeId>& exposed_types)
-  : normalized_component_storage_ptr(new NormalizedComponentStorage(component, exposed_types)),
-    allocator(normalized_component_storage_ptr->fixed_size_allocator_data),
-    bindings(normalized_component_storage_ptr->bindings, (DummyNode<TypeId, NormalizedBindingData>*)nullptr, (DummyNode<TypeId, NormalizedBindingData>*)nullptr),
-    multibindings(std::move(normalized_component_storage_ptr->multibindings)) {
+constexpr std::uint32_t InjectorStorage::no_object_offset;
+
+InjectorStorage::InjectorStorage(const ComponentStorage& component, const std::vector<TypeId>& exposed_types,
+                                 MemoryResource* memory_resource)
+  : memory_resource(memory_resource),
+    normalized_component_storage_ptr(new NormalizedComponentStorage(component, exposed_types, 1 /* num_threads */,
+                                                                    false /* prune_unreachable_bindings */,
+                                                                    false /* hoist_request_independent_bindings */,
+                                                                    SemistaticMap<TypeId, SemistaticGraphInternalNodeId>::default_max_bucketed_elems,
+                                                                    memory_resource)),
+    allocator(normalized_component_storage_ptr->fixed_size_allocator_data, memory_resource),
+    bindings(normalized_component_storage_ptr->bindings, (DummyNode<TypeId, NormalizedBindingData>*)nullptr, (DummyNode<TypeId, NormalizedBindingData>*)nullptr, normalized_component_storage_ptr->max_bucketed_bindings, memory_resource),
+    multibindings(&normalized_component_storage_ptr->multibindings),
+    multibinding_vectors(MemoryResourceAllocator<std::shared_ptr<char>>(memory_resource)) {
+  
+  object_offsets = normalized_component_storage_ptr->object_offsets.data();
+  num_object_offsets = normalized_component_storage_ptr->object_offsets.size();
+  initMultibindingState();
 
 #ifdef FRUIT_EXTRA_DEBUG
   bindings.checkFullyConstructed();
 #endif
 }
 
-InjectorStorage::InjectorStorage(const NormalizedComponentStorage& normalized_component,
-                                 const ComponentStorage& component,
-                                 std::vector<TypeId>&& exposed_types)
-  : multibindings(normalized_component.multibindings) {
-
-  FixedSizeAllocator::FixedSizeAllocatorData fixed_size_allocator_data = normalized_component.fixed_size_allocator_data;
-  
-  ;
+std::vector<std::pair<TypeId, BindingData>> InjectorStorage::normalizeComponentBindings(
+    const NormalizedComponentStorage& normalized_component,
+    const ComponentStorage& component,
+    std::vector<TypeId>&& exposed_types,
+    FixedSizeAllocator::FixedSizeAllocatorData& fixed_size_allocator_data) {
   
   // Step 1: Remove duplicates among the new bindings, and check for inconsistent bindings within `component' alone.
   // Note that we do NOT use component.compressed_bindings here, to avoid having to check if these compressions can be undone.
@@ -115,12 +136,13 @@ InjectorStorage::InjectorStorage(const NormalizedComponentStorage& normalized_co
                             [&normalized_component, &binding_compressions_to_undo](const std::pair<TypeId, BindingData>& p) {
                               if (!p.second.isCreated()) {
                                 for (std::size_t i = 0; i < p.second.getDeps()->num_deps; ++i) {
-                                  auto binding_compression_itr = 
-                                      normalized_component.bindingCompressionInfoMap->find(p.second.getDeps()->deps[i]);
-                                  if (binding_compression_itr != normalized_component.bindingCompressionInfoMap->end()
-                                      && binding_compression_itr->second.iTypeId != p.first) {
+                                  const BindingNormalization::BindingCompressionInfo* binding_compression_info =
+                                      BindingNormalization::findBindingCompressionInfo(
+                                          normalized_component.bindingCompressionInfoMap, p.second.getDeps()->deps[i]);
+                                  if (binding_compression_info != nullptr
+                                      && binding_compression_info->iTypeId != p.first) {
                                     // The binding compression for `p.second.getDeps()->deps[i]' must be undone because something
-                                    // different from binding_compression_itr->iTypeId is now bound to it.
+                                    // different from binding_compression_info->iTypeId is now bound to it.
                                     binding_compressions_to_undo.insert(p.second.getDeps()->deps[i]);
                                   }
                                 }
@@ -130,7 +152,8 @@ InjectorStorage::InjectorStorage(const NormalizedComponentStorage& normalized_co
                                 // Not bound yet, keep the new binding.
                                 return false;
                               }
-                              if (!(node_itr.getNode() == NormalizedBindingData(p.second))) {
+                              if (!(node_itr.getNode() == NormalizedBindingData(p.second))
+                                  && !normalized_component.isHoistedBinding(p.first, p.second)) {
                                 std::cerr << multipleBindingsError(p.first) << std::endl;
                                 exit(1);
                               }
@@ -141,55 +164,672 @@ InjectorStorage::InjectorStorage(const NormalizedComponentStorage& normalized_co
   
   // Step 3: undo any binding compressions that can no longer be applied.
   for (TypeId cTypeId : binding_compressions_to_undo) {
-    auto binding_compression_itr = normalized_component.bindingCompressionInfoMap->find(cTypeId);
-    FruitAssert(binding_compression_itr != normalized_component.bindingCompressionInfoMap->end());
-    FruitAssert(!binding_compression_itr->second.iBinding.needsAllocation());
-    normalized_bindings.emplace_back(cTypeId, binding_compression_itr->second.cBinding);
+    const BindingNormalization::BindingCompressionInfo* binding_compression_info =
+        BindingNormalization::findBindingCompressionInfo(normalized_component.bindingCompressionInfoMap, cTypeId);
+    FruitAssert(binding_compression_info != nullptr);
+    FruitAssert(!binding_compression_info->iBinding.needsAllocation());
+    // The space for C might have been moved to the fixed layout (at the offset of I's node) by computeObjectLayout(), but
+    // I's node won't allocate anything once the compression is undone, and C gets a new node without a fixed offset. So
+    // C needs its own space in the bump-allocated area.
+    if (binding_compression_info->cBinding.needsAllocation()) {
+      fixed_size_allocator_data.addType(cTypeId);
+    }
+    normalized_bindings.emplace_back(cTypeId, binding_compression_info->cBinding);
     // This TypeId is already in normalized_component.bindings, we overwrite it here.
-    FruitAssert(!(normalized_component.bindings.find(binding_compression_itr->second.iTypeId) == normalized_component.bindings.end()));
-    normalized_bindings.emplace_back(binding_compression_itr->second.iTypeId, binding_compression_itr->second.iBinding);
+    FruitAssert(!(normalized_component.bindings.find(binding_compression_info->iTypeId) == normalized_component.bindings.end()));
+    normalized_bindings.emplace_back(binding_compression_info->iTypeId, binding_compression_info->iBinding);
 #ifdef FRUIT_EXTRA_DEBUG
-    std::cout << "InjectorStorage: undoing binding compression for: " << binding_compression_itr->second.iTypeId << "->" << cTypeId << std::endl;  
+    std::cout << "InjectorStorage: undoing binding compression for: " << binding_compression_info->iTypeId << "->" << cTypeId << std::endl;  
 #endif
   }
   
+  return normalized_bindings;
+}
+
+InjectorStorage::InjectorStorage(const NormalizedComponentStorage& normalized_component,
+                                 const ComponentStorage& component,
+                                 std::vector<TypeId>&& exposed_types,
+                                 MemoryResource* memory_resource)
+  : memory_resource(memory_resource),
+    multibinding_vectors(MemoryResourceAllocator<std::shared_ptr<char>>(memory_resource)) {
+
+  FixedSizeAllocator::FixedSizeAllocatorData fixed_size_allocator_data = normalized_component.fixed_size_allocator_data;
+  
+  std::vector<std::pair<TypeId, BindingData>> normalized_bindings =
+      normalizeComponentBindings(normalized_component, component, std::move(exposed_types), fixed_size_allocator_data);
+  
   bindings = Graph(normalized_component.bindings,
                    BindingDataNodeIter{normalized_bindings.begin()},
-                   BindingDataNodeIter{normalized_bindings.end()});
+                   BindingDataNodeIter{normalized_bindings.end()},
+                   normalized_component.max_bucketed_bindings,
+                   memory_resource);
+  object_offsets = normalized_component.object_offsets.data();
+  num_object_offsets = normalized_component.object_offsets.size();
   
-  // Step 4: Add multibindings.
-  BindingNormalization::addMultibindings(multibindings, fixed_size_allocator_data, std::move(component.multibindings));
+  // Step 4: Add multibindings. The multibindings of the normalized component are shared unless new ones are added.
+  if (component.multibindings.empty()) {
+    multibindings = &normalized_component.multibindings;
+  } else {
+    owned_multibindings.reset(new NormalizedMultibindingSet(BindingNormalization::addMultibindings(
+        normalized_component.multibindings, fixed_size_allocator_data, component.multibindings)));
+    multibindings = owned_multibindings.get();
+  }
+  initMultibindingState();
   
-  allocator = FixedSizeAllocator(fixed_size_allocator_data);
+  allocator = FixedSizeAllocator(fixed_size_allocator_data,
+                                 memory_resource != nullptr ? memory_resource : &normalized_component.chunk_cache);
+  
+#ifdef FRUIT_EXTRA_DEBUG
+  bindings.checkFullyConstructed();
+#endif
+}
+
+InjectorStorage::InjectorStorage(const NormalizedComponentStorage& normalized_component,
+                                 MemoryResource* memory_resource)
+  : memory_resource(memory_resource),
+    allocator(normalized_component.fixed_size_allocator_data,
+              memory_resource != nullptr ? memory_resource : &normalized_component.chunk_cache),
+    // This copies the nodes of the normalized graph, without adding any new node.
+    bindings(normalized_component.bindings, (DummyNode<TypeId, NormalizedBindingData>*)nullptr, (DummyNode<TypeId, NormalizedBindingData>*)nullptr, normalized_component.max_bucketed_bindings, memory_resource),
+    multibindings(&normalized_component.multibindings),
+    multibinding_vectors(MemoryResourceAllocator<std::shared_ptr<char>>(memory_resource)) {
+  // This is empty while the NormalizedComponentStorage is hoisting its bindings, and the offsets are computed later.
+  object_offsets = normalized_component.object_offsets.data();
+  num_object_offsets = normalized_component.object_offsets.size();
+  initMultibindingState();
+  
+  // Unlike in the other constructors, the graph is not checked with checkFullyConstructed() since the requirements of
+  // the normalized component are not bound.
+}
+
+InjectorStorage::InjectorStorage(const PreparedInjectorStorage& prepared_storage,
+                                 const ComponentStorage& component,
+                                 MemoryResource* memory_resource)
+  : memory_resource(memory_resource),
+    allocator(prepared_storage.fixed_size_allocator_data,
+              memory_resource != nullptr ? memory_resource : prepared_storage.chunk_cache),
+    // This copies the nodes of the prepared graph, without adding any new node.
+    bindings(prepared_storage.bindings, (DummyNode<TypeId, NormalizedBindingData>*)nullptr, (DummyNode<TypeId, NormalizedBindingData>*)nullptr, prepared_storage.max_bucketed_bindings, memory_resource),
+    multibindings(&prepared_storage.multibindings),
+    multibinding_vectors(MemoryResourceAllocator<std::shared_ptr<char>>(memory_resource)) {
+  
+  object_offsets = prepared_storage.object_offsets->data();
+  num_object_offsets = prepared_storage.object_offsets->size();
+  initMultibindingState();
+  
+  if (component.bindings.size() != prepared_storage.component_bindings.size()
+      || component.multibindings.size() != prepared_storage.component_multibindings.size()) {
+    fatal(preparedInjectorMismatchError());
+  }
+  
+  for (std::size_t i = 0; i < component.bindings.size(); ++i) {
+    const std::pair<TypeId, BindingData>& binding = component.bindings[i];
+    const std::pair<TypeId, BindingData>& prepared_binding = prepared_storage.component_bindings[i];
+    if (binding.first != prepared_binding.first
+        || binding.second.isCreated() != prepared_binding.second.isCreated()) {
+      fatal(preparedInjectorMismatchError());
+    }
+    if (!binding.second.isCreated()) {
+      if (!(binding.second == prepared_binding.second)) {
+        fatal(preparedInjectorMismatchError());
+      }
+      continue;
+    }
+    // An instance binding, the object might be different from the one in the prepared injector.
+    NormalizedBindingData& binding_data = bindings.at(binding.first).getNode();
+    if (prepared_storage.instance_binding_is_stored[i]) {
+      binding_data = NormalizedBindingData(binding.second.getObject());
+    } else if (binding_data.getObject() != binding.second.getObject()) {
+      // The type was already bound in the normalized component (or earlier in this component) to a different object.
+      std::cerr << multipleBindingsError(binding.first) << std::endl;
+      exit(1);
+    }
+  }
+  
+  for (std::size_t i = 0; i < component.multibindings.size(); ++i) {
+    const std::pair<TypeId, MultibindingData>& multibinding = component.multibindings[i];
+    const std::pair<TypeId, MultibindingData>& prepared_multibinding = prepared_storage.component_multibindings[i];
+    if (multibinding.first != prepared_multibinding.first
+        || multibinding.second.create != prepared_multibinding.second.create
+        || multibinding.second.deps != prepared_multibinding.second.deps
+        || multibinding.second.get_multibindings_vector != prepared_multibinding.second.get_multibindings_vector
+        || multibinding.second.needs_allocation != prepared_multibinding.second.needs_allocation) {
+      fatal(preparedInjectorMismatchError());
+    }
+    if (multibinding.second.create == nullptr) {
+      // An instance multibinding, store the (possibly different) object.
+      multibinding_objects[prepared_storage.multibinding_elem_indexes[i]] = multibinding.second.object;
+    }
+  }
   
 #ifdef FRUIT_EXTRA_DEBUG
   bindings.checkFullyConstructed();
 #endif
 }
 
+InjectorStorage::InjectorStorage(InjectorStorage& parent,
+                                 const ComponentStorage& component,
+                                 const std::vector<TypeId>& exposed_types,
+                                 MemoryResource* memory_resource)
+  : memory_resource(memory_resource),
+    multibinding_vectors(MemoryResourceAllocator<std::shared_ptr<char>>(memory_resource)),
+    parent(&parent) {
+
+  FixedSizeAllocator::FixedSizeAllocatorData fixed_size_allocator_data;
+
+  // As in normalizeComponentBindings(), binding compressions are not performed here.
+  BindingNormalization::BindingCompressionInfoMap bindingCompressionInfoMapUnused;
+  std::vector<std::pair<TypeId, BindingData>> normalized_bindings =
+      BindingNormalization::normalizeBindings(component.bindings,
+                                              fixed_size_allocator_data,
+                                              std::vector<CompressedBinding>{},
+                                              component.multibindings,
+                                              exposed_types,
+                                              bindingCompressionInfoMapUnused);
+  FruitAssert(bindingCompressionInfoMapUnused.empty());
+
+  // Find the types that are needed by this injector but only bound in the parent injector (or one of its ancestors).
+  HashSet<TypeId> bound_types = createHashSet<TypeId>(normalized_bindings.size());
+  for (const std::pair<TypeId, BindingData>& p : normalized_bindings) {
+    bound_types.insert(p.first);
+  }
+  std::vector<TypeId> parent_types;
+  auto add_parent_type = [&](TypeId type) {
+    if (!bound_types.insert(type).second) {
+      return;
+    }
+    InjectorStorage* storage = &parent;
+    while (storage != nullptr && storage->bindings.find(type) == storage->bindings.end()) {
+      storage = storage->parent;
+    }
+    if (storage == nullptr) {
+      fatal("the type " + type.type_info->name() + " is needed by the component of a child injector, but it's not bound "
+            + "in the parent injector.");
+    }
+    parent_types.push_back(type);
+  };
+  for (const std::pair<TypeId, BindingData>& p : normalized_bindings) {
+    if (!p.second.isCreated()) {
+      const BindingDeps* deps = p.second.getDeps();
+      for (std::size_t i = 0; i < deps->num_deps; ++i) {
+        add_parent_type(deps->deps[i]);
+      }
+    }
+  }
+  for (const std::pair<TypeId, MultibindingData>& p : component.multibindings) {
+    if (p.second.create != nullptr) {
+      for (std::size_t i = 0; i < p.second.deps->num_deps; ++i) {
+        add_parent_type(p.second.deps->deps[i]);
+      }
+    }
+  }
+  for (TypeId type : exposed_types) {
+    add_parent_type(type);
+  }
+
+  // The nodes for these types have no outgoing edges: their objects are owned by the parent, so the dependencies of the
+  // parent's bindings are not copied here.
+  parent_bindings.reserve(parent_types.size());
+  normalized_bindings.reserve(normalized_bindings.size() + parent_types.size());
+  for (TypeId type : parent_types) {
+    parent_bindings.push_back(ParentBinding{type, BindingDeps{nullptr, 0, nullptr}, BindingData::CreateData{nullptr, nullptr}});
+    ParentBinding& parent_binding = parent_bindings.back();
+    parent_binding.deps.deps = &parent_binding.type;
+    parent_binding.create_data = BindingData::CreateData{createFromParent, &parent_binding.deps};
+    normalized_bindings.emplace_back(type, BindingData(&parent_binding.create_data, false /* needs_allocation */));
+  }
+
+  bindings = Graph(BindingDataNodeIter{normalized_bindings.begin()},
+                   BindingDataNodeIter{normalized_bindings.end()},
+                   Graph::Layout::UNSPECIFIED,
+                   1 /* num_threads */,
+                   memory_resource);
+  bindings.buildDenseIndex(BindingDataNodeIter{normalized_bindings.begin()},
+                           BindingDataNodeIter{normalized_bindings.end()},
+                           [](TypeId type) { return type.type_info->denseIndex(); });
+
+  owned_multibindings.reset(new NormalizedMultibindingSet(BindingNormalization::addMultibindings(
+      NormalizedMultibindingSet(), fixed_size_allocator_data, component.multibindings)));
+  multibindings = owned_multibindings.get();
+  initMultibindingState();
+
+  allocator = FixedSizeAllocator(fixed_size_allocator_data, memory_resource);
+
+#ifdef FRUIT_EXTRA_DEBUG
+  bindings.checkFullyConstructed();
+#endif
+}
+
+BindingData::object_t InjectorStorage::createFromParent(InjectorStorage& storage, Graph::node_iterator node_itr) {
+  FruitAssert(storage.parent != nullptr);
+  TypeId type = node_itr.getNode().getDeps()->deps[0];
+  void* object = storage.parent->unsafeGetPtr(type);
+  FruitAssert(object != nullptr);
+  return object;
+}
+
 InjectorStorage::~InjectorStorage() {
 }
 
-void InjectorStorage::ensureConstructedMultibinding(NormalizedMultibindingData& bindingDataForMultibinding) {
-  for (NormalizedMultibindingData::Elem& elem : bindingDataForMultibinding.elems) {
-    if (elem.object == nullptr) {
-      elem.object = elem.create(*this);
+void InjectorStorage::initMultibindingState() {
+  multibinding_objects = FixedSizeVector<MultibindingData::object_t>(memory_resource, multibindings->elems.size());
+  for (const NormalizedMultibindingSet::Elem& elem : multibindings->elems) {
+    multibinding_objects.push_back(elem.object);
+  }
+  multibinding_vectors.resize(multibindings->types.size());
+}
+
+void InjectorStorage::ensureConstructedMultibinding(const NormalizedMultibindingData& multibinding_data) {
+  for (std::size_t i = multibinding_data.elems_begin; i < multibinding_data.elems_end; ++i) {
+    if (multibinding_objects[i] == nullptr) {
+      multibinding_objects[i] = multibindings->elems[i].create(*this);
     }
   }
 }
 
 void* InjectorStorage::getMultibindings(TypeId typeInfo) {
-  NormalizedMultibindingData* bindingDataVector = getNormalizedMultibindingData(typeInfo);
-  if (bindingDataVector == nullptr) {
-    // Not registered.
-    return nullptr;
+  const NormalizedMultibindingData* multibinding_data = getNormalizedMultibindingData(typeInfo);
+  if (multibinding_data == nullptr) {
+    // Not registered (in a child injector, the parent's multibindings are used).
+    return parent != nullptr ? parent->getMultibindings(typeInfo) : nullptr;
   }
-  return bindingDataVector->get_multibindings_vector(*this).get();
+  if (thread_safe) {
+    std::lock_guard<std::mutex> lock(multibindings_mutex);
+    return multibinding_data->get_multibindings_vector(*this, *multibinding_data).get();
+  }
+  return multibinding_data->get_multibindings_vector(*this, *multibinding_data).get();
+}
+
+std::pair<void* const*, void* const*> InjectorStorage::getMultibindingObjects(TypeId typeInfo) {
+  const NormalizedMultibindingData* multibinding_data = getNormalizedMultibindingData(typeInfo);
+  if (multibinding_data == nullptr) {
+    if (parent != nullptr) {
+      return parent->getMultibindingObjects(typeInfo);
+    }
+    return std::pair<void* const*, void* const*>(nullptr, nullptr);
+  }
+  {
+    std::unique_lock<std::mutex> lock(multibindings_mutex, std::defer_lock);
+    if (thread_safe) {
+      lock.lock();
+    }
+    ensureConstructedMultibinding(*multibinding_data);
+  }
+  const MultibindingData::object_t* objects = multibinding_objects.data();
+  return std::pair<void* const*, void* const*>(objects + multibinding_data->elems_begin,
+                                               objects + multibinding_data->elems_end);
+}
+
+InjectorStorage* InjectorStorage::findMultibindingElems(TypeId typeInfo,
+                                                       std::size_t& elems_begin,
+                                                       std::size_t& elems_end) {
+  const NormalizedMultibindingData* multibinding_data = getNormalizedMultibindingData(typeInfo);
+  if (multibinding_data == nullptr) {
+    if (parent != nullptr) {
+      return parent->findMultibindingElems(typeInfo, elems_begin, elems_end);
+    }
+    elems_begin = 0;
+    elems_end = 0;
+    return this;
+  }
+  elems_begin = multibinding_data->elems_begin;
+  elems_end = multibinding_data->elems_end;
+  return this;
+}
+
+MultibindingData::object_t InjectorStorage::getMultibindingObject(std::size_t elem_index) {
+  std::unique_lock<std::mutex> lock(multibindings_mutex, std::defer_lock);
+  if (thread_safe) {
+    lock.lock();
+  }
+  MultibindingData::object_t& object = multibinding_objects[elem_index];
+  if (object == nullptr) {
+    object = multibindings->elems[elem_index].create(*this);
+  }
+  return object;
+}
+
+void InjectorStorage::constructMultibindingsInParallel(TypeId typeInfo, std::size_t num_threads) {
+  const NormalizedMultibindingData* multibinding_data = getNormalizedMultibindingData(typeInfo);
+  if (multibinding_data == nullptr) {
+    if (parent != nullptr) {
+      parent->constructMultibindingsInParallel(typeInfo, num_threads);
+    }
+    return;
+  }
+  num_threads = getNumThreads(num_threads);
+  enableThreadSafety();
+  
+  // As in eagerlyInjectAll(), each element is constructed by a single thread, and the dependencies shared by different
+  // elements are constructed once (by the first thread that needs them) while the other threads wait for them.
+  // These are indexes in multibinding_objects.
+  std::vector<std::size_t> multibinding_elems;
+  for (std::size_t i = multibinding_data->elems_begin; i < multibinding_data->elems_end; ++i) {
+    if (multibinding_objects[i] == nullptr) {
+      multibinding_elems.push_back(i);
+    }
+  }
+  
+  runTasksInParallel(multibinding_elems.size(), num_threads, [&](std::size_t i) {
+    std::size_t elem_index = multibinding_elems[i];
+    multibinding_objects[elem_index] = multibindings->elems[elem_index].create(*this);
+  });
 }
 
 void InjectorStorage::eagerlyInjectMultibindings() {
-  for (auto& typeInfoInfoPair : multibindings) {
-    typeInfoInfoPair.second.get_multibindings_vector(*this);
+  std::unique_lock<std::mutex> lock(multibindings_mutex, std::defer_lock);
+  if (thread_safe) {
+    lock.lock();
+  }
+  for (const std::pair<TypeId, NormalizedMultibindingData>& p : multibindings->types) {
+    p.second.get_multibindings_vector(*this, p.second);
+  }
+}
+
+void InjectorStorage::eagerlyInjectAll(const std::vector<TypeId>& types, std::size_t num_threads) {
+  num_threads = getNumThreads(num_threads);
+  enableThreadSafety();
+  
+  // Each task constructs either a node of `bindings' that's not terminal yet or a multibinding element that wasn't
+  // constructed yet, and is only started once the tasks for its non-lazy deps have finished. This way the create operation
+  // of a node finds its deps already constructed (so it doesn't recurse), and independent subgraphs of the same type's
+  // dependencies are constructed in parallel. Deps injected as a Provider are not waited for, since they're only
+  // constructed when the Provider's get() is called.
+  // The tasks are planned here, before starting any thread.
+  static constexpr std::size_t no_task = ~std::size_t(0);
+  
+  // The node tasks come first, in task_nodes. The task for multibinding_elems[i] has index task_nodes.size() + i.
+  std::vector<Graph::node_iterator> task_nodes;
+  // These are indexes in multibinding_objects. Each element is constructed by a single task, so there's no need to lock
+  // multibindings_mutex.
+  std::vector<std::size_t> multibinding_elems;
+  // The (dep node task, multibinding_elems index) edges, added once the number of node tasks is known.
+  std::vector<std::pair<std::size_t, std::size_t>> multibinding_edges;
+  std::vector<std::size_t> num_deps;
+  std::vector<std::vector<std::size_t>> dependents;
+  
+  // task_by_node[bindings.indexOf(node_itr)] is the index of the task for node_itr, or no_task.
+  std::vector<std::size_t> task_by_node(bindings.size(), no_task);
+  std::vector<Graph::node_iterator> nodes_to_visit;
+  Graph::node_iterator bindings_begin = bindings.begin();
+  
+  // Returns the task for the node, creating it if needed. Returns no_task if the node is already constructed.
+  auto getNodeTask = [&](Graph::node_iterator node_itr) {
+    if (node_itr.isTerminalAcquire()) {
+      return no_task;
+    }
+    std::size_t& task = task_by_node[bindings.indexOf(node_itr)];
+    if (task == no_task) {
+      task = task_nodes.size();
+      task_nodes.push_back(node_itr);
+      num_deps.push_back(0);
+      dependents.emplace_back();
+      nodes_to_visit.push_back(node_itr);
+    }
+    return task;
+  };
+  
+  // Creates the tasks for all nodes reachable from nodes_to_visit, with their edges.
+  auto visitNodes = [&]() {
+    while (!nodes_to_visit.empty()) {
+      Graph::node_iterator node_itr = nodes_to_visit.back();
+      nodes_to_visit.pop_back();
+      std::size_t task = task_by_node[bindings.indexOf(node_itr)];
+      const BindingDeps* deps = node_itr.getNode().getDeps();
+      for (std::size_t i = 0; i < deps->num_deps; ++i) {
+        if (deps->is_lazy[i]) {
+          continue;
+        }
+        std::size_t dep_task = getNodeTask(node_itr.neighborsBegin().getNodeIterator(i, bindings_begin));
+        if (dep_task != no_task) {
+          dependents[dep_task].push_back(task);
+          ++num_deps[task];
+        }
+      }
+    }
+  };
+  
+  for (TypeId type : types) {
+    Graph::node_iterator node_itr = bindings.find(type);
+    if (!(node_itr == bindings.end())) {
+      getNodeTask(node_itr);
+    }
+  }
+  visitNodes();
+  
+  for (std::size_t elem_index = 0; elem_index < multibinding_objects.size(); ++elem_index) {
+    if (multibinding_objects[elem_index] != nullptr) {
+      continue;
+    }
+    const BindingDeps* deps = multibindings->elems[elem_index].deps;
+    for (std::size_t i = 0; i < deps->num_deps; ++i) {
+      if (deps->is_lazy[i]) {
+        continue;
+      }
+      Graph::node_iterator dep_itr = bindings.find(deps->deps[i]);
+      if (dep_itr == bindings.end()) {
+        // Bound in a parent injector, the create operation will get it from there.
+        continue;
+      }
+      std::size_t dep_task = getNodeTask(dep_itr);
+      if (dep_task != no_task) {
+        multibinding_edges.emplace_back(dep_task, multibinding_elems.size());
+      }
+    }
+    multibinding_elems.push_back(elem_index);
+  }
+  // Nodes that are only reachable from multibindings.
+  visitNodes();
+  
+  std::size_t num_node_tasks = task_nodes.size();
+  num_deps.resize(num_node_tasks + multibinding_elems.size(), 0);
+  dependents.resize(num_node_tasks + multibinding_elems.size());
+  for (const std::pair<std::size_t, std::size_t>& edge : multibinding_edges) {
+    dependents[edge.first].push_back(num_node_tasks + edge.second);
+    ++num_deps[num_node_tasks + edge.second];
+  }
+  
+  runTaskGraphInParallel(std::move(num_deps), dependents, num_threads, [&](std::size_t task) {
+    if (task < num_node_tasks) {
+      // This doesn't construct anything if the node was already constructed in the meantime (e.g. by a Provider).
+      constructNodeConcurrently(task_nodes[task]);
+    } else {
+      std::size_t elem_index = multibinding_elems[task - num_node_tasks];
+      multibinding_objects[elem_index] = multibindings->elems[elem_index].create(*this);
+    }
+  });
+  
+  // All the multibinding objects are already constructed at this point, this only creates the vectors.
+  eagerlyInjectMultibindings();
+}
+
+void InjectorStorage::constructLockedNode(Graph::node_iterator node_itr) {
+  NormalizedBindingData& bindingData = node_itr.getNode();
+  ConstructedNode constructed_node{node_itr, bindingData, node_itr.neighborsBegin()};
+  bindingData.create(*this, node_itr);
+  if (reset_enabled) {
+    constructed_nodes.concurrent_push_back(constructed_node);
+  } else {
+    constructed_before_enable_reset.store(true, std::memory_order_relaxed);
+  }
+  // This publishes the object stored by create() to the threads that see the node as terminal.
+  node_itr.setTerminalAndUnlock();
+}
+
+void InjectorStorage::constructNodeConcurrently(Graph::node_iterator node_itr) {
+  while (true) {
+    if (node_itr.tryLock()) {
+      // This thread is now the only one that can construct the object.
+      try {
+        constructLockedNode(node_itr);
+      } catch (...) {
+        // Let other threads (if any) try again.
+        node_itr.unlock();
+        throw;
+      }
+      return;
+    }
+    
+    // Another thread is constructing the object (or has just finished constructing it).
+    while (node_itr.isLocked()) {
+      std::this_thread::yield();
+    }
+    if (node_itr.isTerminalAcquire()) {
+      return;
+    }
+    // The construction in the other thread failed with an exception, try again.
+  }
+}
+
+void InjectorStorage::constructIteratively(Graph::node_iterator root_itr) {
+  // In thread-safe mode each thread has its own stack, shared by all injectors. As for construction_stack, this method
+  // can be re-entered (e.g. by a Provider's get() in a constructor), and each call only uses the frames above stack_base.
+  static thread_local std::vector<ConstructionFrame> thread_construction_stack;
+  std::vector<ConstructionFrame>& stack = thread_safe ? thread_construction_stack : construction_stack;
+  std::size_t stack_base = stack.size();
+  
+  Graph::node_iterator bindings_begin = bindings.begin();
+  auto isTerminal = [this](Graph::node_iterator node_itr) {
+    return thread_safe ? node_itr.isTerminalAcquire() : node_itr.isTerminal();
+  };
+  
+  stack.push_back(ConstructionFrame{root_itr, nullptr, 0});
+  try {
+    while (stack.size() > stack_base) {
+      ConstructionFrame& frame = stack.back();
+      if (frame.deps == nullptr) {
+        if (thread_safe) {
+          if (!frame.node_itr.tryLock()) {
+            // Either already constructed, or being constructed by another thread.
+            while (frame.node_itr.isLocked()) {
+              std::this_thread::yield();
+            }
+            if (frame.node_itr.isTerminalAcquire()) {
+              stack.pop_back();
+            }
+            // Otherwise the construction in the other thread failed with an exception, try again.
+            continue;
+          }
+        } else if (frame.node_itr.isTerminal()) {
+          // Already constructed (e.g. because it's also a dependency of a node that was lower in the stack).
+          stack.pop_back();
+          continue;
+        }
+        // The deps are only reachable while the node is not terminal, and in thread-safe mode the lock ensures that no
+        // other thread constructs the object in the meantime.
+        frame.deps = frame.node_itr.getNode().getDeps();
+      }
+      
+      bool found_unconstructed_dep = false;
+      while (frame.next_dep_index < frame.deps->num_deps) {
+        std::size_t dep_index = frame.next_dep_index;
+        ++frame.next_dep_index;
+        if (frame.deps->is_lazy[dep_index]) {
+          continue;
+        }
+        Graph::node_iterator dep_itr = frame.node_itr.neighborsBegin().getNodeIterator(dep_index, bindings_begin);
+        if (!isTerminal(dep_itr)) {
+          // Note that this invalidates `frame'.
+          stack.push_back(ConstructionFrame{dep_itr, nullptr, 0});
+          found_unconstructed_dep = true;
+          break;
+        }
+      }
+      
+      if (!found_unconstructed_dep) {
+        // All the (non-lazy) deps are constructed, so the create operation won't recurse. It might still re-enter this
+        // method (e.g. through a Provider), but such calls leave the stack as they found it.
+        Graph::node_iterator node_itr = frame.node_itr;
+        if (thread_safe) {
+          constructLockedNode(node_itr);
+        } else {
+          constructNode(node_itr);
+        }
+        stack.pop_back();
+      }
+    }
+  } catch (...) {
+    if (thread_safe) {
+      // Let other threads (if any) try again.
+      for (std::size_t i = stack_base; i < stack.size(); ++i) {
+        if (stack[i].deps != nullptr) {
+          stack[i].node_itr.unlock();
+        }
+      }
+    }
+    stack.erase(stack.begin() + stack_base, stack.end());
+    throw;
+  }
+}
+
+void InjectorStorage::enableIterativeConstruction() {
+  iterative_construction = true;
+}
+
+void InjectorStorage::enableFastExit() {
+  allocator.enableFastExit();
+}
+
+BindingLookupStatistics InjectorStorage::getBindingLookupStatistics() const {
+  return getBindingLookupStatistics(bindings);
+}
+
+BindingLookupStatistics InjectorStorage::getBindingLookupStatistics(const Graph& graph) {
+  using Map = SemistaticMap<TypeId, SemistaticGraphInternalNodeId>;
+  Map::Statistics map_statistics = graph.getLookupStatistics();
+  BindingLookupStatistics statistics;
+  statistics.num_perfect_hash_types = map_statistics.num_perfect_hash_elems;
+  statistics.num_perfect_hash_slots = map_statistics.num_perfect_hash_slots;
+  statistics.perfect_hash_table_shared = map_statistics.strategy == Map::Strategy::SHARED_PERFECT_HASH;
+  statistics.num_bucketed_types = map_statistics.num_bucketed_elems;
+  statistics.num_buckets = map_statistics.num_buckets;
+  statistics.max_bucket_size = map_statistics.max_bucket_size;
+  return statistics;
+}
+
+void InjectorStorage::enableThreadSafety() {
+  // The nodes of a child injector for the types bound in `parent' call parent->unsafeGetPtr(), and getMultibindings()
+  // can also forward to `parent', so the ancestors must be thread-safe too. An injector is only made thread-safe together
+  // with all its ancestors, so the walk can stop at the first one that already is.
+  for (InjectorStorage* storage = this; storage != nullptr && !storage->thread_safe; storage = storage->parent) {
+    storage->thread_safe = true;
+    storage->allocator.enableThreadSafety();
+  }
+}
+
+void InjectorStorage::enableReset() {
+  if (constructed_before_enable_reset.load(std::memory_order_relaxed)) {
+    fatal("enableReset() was called on an injector that already injected some objects. It must be called before "
+          "injecting anything from the injector.");
+  }
+  if (!reset_enabled) {
+    reset_enabled = true;
+    constructed_nodes = FixedSizeVector<ConstructedNode>(memory_resource, bindings.size());
+  }
+}
+
+void InjectorStorage::reset() {
+  if (!reset_enabled) {
+    fatal("reset() was called on an injector, but enableReset() wasn't called on it.");
+  }
+  
+  // This destroys all the constructed objects, in reverse construction order.
+  allocator.reset();
+  
+  for (ConstructedNode& constructed_node : constructed_nodes) {
+    constructed_node.node_itr.getNode() = constructed_node.binding_data;
+    constructed_node.node_itr.setNonTerminal(constructed_node.neighbors_begin);
+  }
+  constructed_nodes.clear();
+  
+  for (std::size_t i = 0; i < multibinding_objects.size(); ++i) {
+    if (multibindings->elems[i].create != nullptr) {
+      // Not an instance multibinding, the object was constructed by this injector.
+      multibinding_objects[i] = nullptr;
+    }
+  }
+  for (std::shared_ptr<char>& multibinding_vector : multibinding_vectors) {
+    multibinding_vector.reset();
   }
 }
 
@@ -21,6 +21,7 @@
 #include <vector>
 #include <iostream>
 #include <algorithm>
+#include <thread>
 #include <fruit/impl/util/type_info.h>
 
 #include <fruit/impl/storage/normalized_component_storage.h>
@@ -28,6 +29,7 @@
 
 #include <fruit/impl/data_structures/semistatic_map.templates.h>
 #include <fruit/impl/data_structures/semistatic_graph.templates.h>
+#include <fruit/impl/util/parallel_ranges.h>
 
 using std::cout;
 using std::endl;
@@ -38,23 +40,98 @@ using namespace fruit::impl;
 namespace fruit {
 namespace impl {
 
-NormalizedComponentStorage::NormalizedComponentStorage(const ComponentStorage& component, const std::vector<TypeId>& exposed_types)
-  : bindingCompressionInfoMap(
-      std::unique_ptr<BindingNormalization::BindingCompressionInfoMap>(
-          new BindingNormalization::BindingCompressionInfoMap(
-              createHashMap<TypeId, BindingNormalization::BindingCompressionInfo>()))) {
+NormalizedComponentStorage::NormalizedComponentStorage(const ComponentStorage& component, const std::vector<TypeId>& exposed_types,
+                                                       std::size_t num_threads, bool prune_unreachable_bindings,
+                                                       bool hoist_request_independent_bindings,
+                                                       std::size_t max_bucketed_bindings,
+                                                       MemoryResource* memory_resource)
+  : max_bucketed_bindings(max_bucketed_bindings) {
+  num_threads = getNumThreads(num_threads);
   std::vector<std::pair<TypeId, BindingData>> normalized_bindings =
       BindingNormalization::normalizeBindings(component.bindings,
                                               fixed_size_allocator_data,
                                               std::vector<CompressedBinding>(component.compressed_bindings.begin(), component.compressed_bindings.end()),
                                               std::vector<std::pair<TypeId, MultibindingData>>(component.multibindings.begin(), component.multibindings.end()),
                                               exposed_types,
-                                              *bindingCompressionInfoMap);
+                                              bindingCompressionInfoMap,
+                                              num_threads,
+                                              prune_unreachable_bindings ? &pruning_statistics : nullptr);
   
+  auto add_multibindings = [this, &component]() {
+    multibindings = BindingNormalization::addMultibindings(NormalizedMultibindingSet(), fixed_size_allocator_data, std::vector<std::pair<TypeId, MultibindingData>>(component.multibindings.begin(), component.multibindings.end()));
+  };
+  
+  // The multibindings don't depend on the graph, so they can be added while the graph is built.
+  std::thread multibindings_thread;
+  if (num_threads > 1) {
+    multibindings_thread = std::thread(add_multibindings);
+  }
+  
+  // The dependency order improves the locality of cascaded constructions in injectors.
   bindings = SemistaticGraph<TypeId, NormalizedBindingData>(InjectorStorage::BindingDataNodeIter{normalized_bindings.begin()},
-                                                            InjectorStorage::BindingDataNodeIter{normalized_bindings.end()});
+                                                            InjectorStorage::BindingDataNodeIter{normalized_bindings.end()},
+                                                            SemistaticGraph<TypeId, NormalizedBindingData>::Layout::DEPENDENCY_ORDER,
+                                                            num_threads,
+                                                            memory_resource);
+  bindings.buildDenseIndex(InjectorStorage::BindingDataNodeIter{normalized_bindings.begin()},
+                           InjectorStorage::BindingDataNodeIter{normalized_bindings.end()},
+                           [](TypeId type) { return type.type_info->denseIndex(); });
+  
+  if (multibindings_thread.joinable()) {
+    multibindings_thread.join();
+  } else {
+    add_multibindings();
+  }
+  
+  if (hoist_request_independent_bindings) {
+    // This must be done before computing the object layout, so that the hoisted objects don't take space in the
+    // injectors' allocators.
+    hoistRequestIndependentBindings(normalized_bindings, memory_resource);
+  }
+  
+  // This must be done after adding the multibindings, since that also modifies fixed_size_allocator_data.
+  BindingNormalization::computeObjectLayout(normalized_bindings, bindingCompressionInfoMap, bindings,
+                                            fixed_size_allocator_data, object_offsets);
+}
+
+void NormalizedComponentStorage::hoistRequestIndependentBindings(
+    const std::vector<std::pair<TypeId, BindingData>>& normalized_bindings, MemoryResource* memory_resource) {
+  std::vector<TypeId> hoisted_types =
+      BindingNormalization::findRequestIndependentBindings(normalized_bindings, bindingCompressionInfoMap);
+  if (hoisted_types.empty()) {
+    return;
+  }
+  
+  // The graph of this injector copies the nodes of `bindings', so the nodes of `bindings' can still be modified below.
+  hoisted_objects_storage.reset(new InjectorStorage(*this, memory_resource));
+  for (TypeId type : hoisted_types) {
+    hoisted_objects_storage->unsafeGetPtr(type);
+  }
   
-  BindingNormalization::addMultibindings(multibindings, fixed_size_allocator_data, std::vector<std::pair<TypeId, MultibindingData>>(component.multibindings.begin(), component.multibindings.end()));
+  hoisted_bindings.reserve(hoisted_types.size());
+  for (const auto& p : normalized_bindings) {
+    Graph::node_iterator hoisted_node_itr = hoisted_objects_storage->bindings.at(p.first);
+    if (p.second.isCreated() || !hoisted_node_itr.isTerminal()) {
+      continue;
+    }
+    hoisted_bindings.push_back(p);
+    Graph::node_iterator node_itr = bindings.at(p.first);
+    node_itr.getNode() = hoisted_node_itr.getNode();
+    node_itr.setTerminal();
+  }
+  FruitAssert(hoisted_bindings.size() == hoisted_types.size());
+  std::sort(hoisted_bindings.begin(), hoisted_bindings.end(),
+            [](const std::pair<TypeId, BindingData>& x, const std::pair<TypeId, BindingData>& y) {
+              return x.first < y.first;
+            });
+}
+
+bool NormalizedComponentStorage::isHoistedBinding(TypeId type, const BindingData& binding) const {
+  auto itr = std::lower_bound(hoisted_bindings.begin(), hoisted_bindings.end(), type,
+                              [](const std::pair<TypeId, BindingData>& x, TypeId y) {
+                                return x.first < y;
+                              });
+  return itr != hoisted_bindings.end() && itr->first == type && itr->second == binding;
 }
 
 NormalizedComponentStorage::~NormalizedComponentStorage() {
@@ -18,6 +18,7 @@
 
 #include <fruit/impl/storage/normalized_component_storage_holder.h>
 #include <fruit/impl/storage/normalized_component_storage.h>
+#include <fruit/normalized_component.h>
 
 using namespace fruit;
 using namespace fruit::impl;
@@ -26,8 +27,37 @@ namespace fruit {
 namespace impl {
 
 NormalizedComponentStorageHolder::NormalizedComponentStorageHolder(
-  const ComponentStorage& component, const std::vector<TypeId>& exposed_types)
-  : storage(new NormalizedComponentStorage(component, exposed_types)) {
+  const ComponentStorage& component, const std::vector<TypeId>& exposed_types,
+  const NormalizedComponentOptions& options, MemoryResource* memory_resource)
+  : storage(new NormalizedComponentStorage(component, exposed_types, options.num_threads,
+                                           options.prune_unreachable_bindings,
+                                           options.hoist_request_independent_bindings,
+                                           options.max_bucketed_bindings,
+                                           memory_resource)) {
+}
+
+std::size_t NormalizedComponentStorageHolder::getNumPrunedBindings() const {
+  return storage->pruning_statistics.num_pruned_bindings;
+}
+
+std::size_t NormalizedComponentStorageHolder::getNumPrunedBytes() const {
+  return storage->pruning_statistics.num_pruned_bytes;
+}
+
+std::size_t NormalizedComponentStorageHolder::getNumHoistedBindings() const {
+  return storage->hoisted_bindings.size();
+}
+
+BindingLookupStatistics NormalizedComponentStorageHolder::getBindingLookupStatistics() const {
+  return InjectorStorage::getBindingLookupStatistics(storage->bindings);
+}
+
+std::size_t NormalizedComponentStorageHolder::getNumChunkCacheHits() const {
+  return storage->chunk_cache.getNumHits();
+}
+
+std::size_t NormalizedComponentStorageHolder::getNumChunkCacheMisses() const {
+  return storage->chunk_cache.getNumMisses();
 }
 
 NormalizedComponentStorageHolder::~NormalizedComponentStorageHolder() {
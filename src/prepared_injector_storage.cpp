@@ -0,0 +1,93 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define IN_FRUIT_CPP_FILE
+
+#include <fruit/impl/storage/prepared_injector_storage.h>
+#include <fruit/impl/storage/normalized_component_storage.h>
+#include <fruit/impl/storage/component_storage.h>
+
+#include <fruit/impl/data_structures/semistatic_graph.templates.h>
+#include <fruit/impl/util/hash_helpers.h>
+
+using namespace fruit;
+using namespace fruit::impl;
+
+namespace fruit {
+namespace impl {
+
+PreparedInjectorStorage::PreparedInjectorStorage(const NormalizedComponentStorage& normalized_component,
+                                                 const ComponentStorage& component,
+                                                 std::vector<TypeId>&& exposed_types)
+  : fixed_size_allocator_data(normalized_component.fixed_size_allocator_data),
+    chunk_cache(&normalized_component.chunk_cache),
+    max_bucketed_bindings(normalized_component.max_bucketed_bindings),
+    object_offsets(&normalized_component.object_offsets),
+    component_bindings(component.bindings),
+    component_multibindings(component.multibindings) {
+
+  // These are the same steps performed by the InjectorStorage constructor that takes a NormalizedComponentStorage.
+  std::vector<std::pair<TypeId, BindingData>> normalized_bindings =
+      InjectorStorage::normalizeComponentBindings(normalized_component, component, std::move(exposed_types),
+                                                  fixed_size_allocator_data);
+
+  bindings = Graph(normalized_component.bindings,
+                   InjectorStorage::BindingDataNodeIter{normalized_bindings.begin()},
+                   InjectorStorage::BindingDataNodeIter{normalized_bindings.end()},
+                   normalized_component.max_bucketed_bindings);
+
+  multibindings = BindingNormalization::addMultibindings(normalized_component.multibindings, fixed_size_allocator_data,
+                                                         component.multibindings);
+
+  // Now determine where the objects of instance bindings will have to be stored.
+  HashSet<TypeId> instance_bound_types = createHashSet<TypeId>();
+  instance_binding_is_stored.reserve(component_bindings.size());
+  for (const std::pair<TypeId, BindingData>& p : component_bindings) {
+    bool is_stored = p.second.isCreated()
+        && instance_bound_types.insert(p.first).second
+        && normalized_component.bindings.find(p.first) == normalized_component.bindings.end();
+    instance_binding_is_stored.push_back(is_stored);
+  }
+
+  // addMultibindings() appends the new multibindings of each type after the ones in the normalized component, preserving
+  // their relative order.
+  HashMap<TypeId, std::size_t> next_elem_index = createHashMap<TypeId, std::size_t>();
+  multibinding_elem_indexes.reserve(component_multibindings.size());
+  for (const std::pair<TypeId, MultibindingData>& p : component_multibindings) {
+    auto itr = next_elem_index.find(p.first);
+    if (itr == next_elem_index.end()) {
+      const NormalizedMultibindingData* normalized_component_data = normalized_component.multibindings.find(p.first);
+      std::size_t num_normalized_component_elems = (normalized_component_data == nullptr)
+          ? 0
+          : normalized_component_data->elems_end - normalized_component_data->elems_begin;
+      itr = next_elem_index.insert(std::make_pair(p.first,
+                                                  multibindings.find(p.first)->elems_begin + num_normalized_component_elems))
+          .first;
+    }
+    multibinding_elem_indexes.push_back(itr->second);
+    ++itr->second;
+  }
+
+#ifdef FRUIT_EXTRA_DEBUG
+  bindings.checkFullyConstructed();
+#endif
+}
+
+PreparedInjectorStorage::~PreparedInjectorStorage() {
+}
+
+} // namespace impl
+} // namespace fruit
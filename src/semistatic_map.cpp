@@ -21,6 +21,7 @@
 #include <fruit/impl/data_structures/semistatic_graph.h>
 
 #include <fruit/impl/util/type_info.h>
+#include <fruit/impl/binding_data.h>
 
 using namespace fruit::impl;
 
@@ -29,6 +30,7 @@ namespace fruit {
 namespace impl {
 
 template class SemistaticMap<TypeId, SemistaticGraphInternalNodeId>;
+template class SemistaticMap<TypeId, NormalizedMultibindingData>;
 
 } // namespace impl
 } // namespace fruit
@@ -0,0 +1,32 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define IN_FRUIT_CPP_FILE
+
+#include <fruit/impl/util/type_info.h>
+
+#include <atomic>
+
+namespace fruit {
+namespace impl {
+
+std::size_t allocateDenseTypeIndex() {
+  static std::atomic<std::size_t> next_index(0);
+  return next_index.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace impl
+} // namespace fruit
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_common.h"
+
+#define IN_FRUIT_CPP_FILE
+#include <fruit/impl/storage/component_storage.h>
+#include <fruit/impl/storage/normalized_component_storage.h>
+#include <fruit/impl/storage/injector_storage.h>
+
+using namespace std;
+using namespace fruit::impl;
+
+// The compressed bindings aren't emitted by the public API for the I->C bindings, so this test builds the
+// ComponentStorage objects directly.
+
+struct I {
+  virtual ~I() = default;
+  virtual bool check() const = 0;
+};
+
+struct C : public I {
+  char data[1000];
+  
+  C() {
+    for (std::size_t i = 0; i < sizeof(data); ++i) {
+      data[i] = char(i);
+    }
+    ++num_instances;
+  }
+  
+  ~C() {
+    Assert(check());
+    --num_instances;
+  }
+  
+  bool check() const override {
+    for (std::size_t i = 0; i < sizeof(data); ++i) {
+      if (data[i] != char(i)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  
+  static int num_instances;
+};
+
+int C::num_instances = 0;
+
+// This depends on C directly, so the compression of I->C must be undone in an injector that binds X.
+struct X {
+  C* c;
+  char data[1000];
+  
+  X(C* c)
+    : c(c) {
+    for (std::size_t i = 0; i < sizeof(data); ++i) {
+      data[i] = char(i + 1);
+    }
+  }
+  
+  bool check() const {
+    for (std::size_t i = 0; i < sizeof(data); ++i) {
+      if (data[i] != char(i + 1)) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+void test_undo_compression_with_data_members() {
+  ComponentStorage component;
+  component.addBinding(InjectorStorage::createBindingDataForBind<I, C>());
+  component.addBinding(InjectorStorage::createBindingDataForConstructor<C()>());
+  component.addCompressedBinding(InjectorStorage::createBindingDataForCompressedConstructor<C(), I>());
+  NormalizedComponentStorage normalized_component(component, std::vector<TypeId>{getTypeId<I>()});
+  
+  {
+    ComponentStorage request_component;
+    request_component.addBinding(InjectorStorage::createBindingDataForConstructor<X(C*)>());
+    InjectorStorage injector(normalized_component, request_component,
+                             std::vector<TypeId>{getTypeId<I>(), getTypeId<X>()});
+    
+    I* i = injector.get<I*>();
+    X* x = injector.get<X*>();
+    Assert(C::num_instances == 1);
+    Assert(static_cast<I*>(x->c) == i);
+    Assert(i->check());
+    Assert(x->c->check());
+    Assert(x->check());
+  }
+  Assert(C::num_instances == 0);
+  
+  {
+    // The compression is still performed in injectors that don't need to undo it.
+    InjectorStorage injector(normalized_component, ComponentStorage(), std::vector<TypeId>{getTypeId<I>()});
+    Assert(injector.get<I*>()->check());
+    Assert(C::num_instances == 1);
+  }
+  Assert(C::num_instances == 0);
+}
+
+int main() {
+  test_undo_compression_with_data_members();
+  
+  return 0;
+}
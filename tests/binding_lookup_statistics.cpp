@@ -0,0 +1,95 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "test_common.h"
+
+struct Request {};
+
+struct Handler {
+  INJECT(Handler(Request&)) {
+  }
+};
+
+// These are only bound in the injectors' components.
+struct Extra1 {
+  INJECT(Extra1()) = default;
+};
+
+struct Extra2 {
+  INJECT(Extra2(Extra1&)) {
+  }
+};
+
+fruit::Component<fruit::Required<Request>, Handler> getHandlerComponent() {
+  return fruit::createComponent();
+}
+
+fruit::Component<Request, Extra2> getRequestComponent(Request& request) {
+  return fruit::createComponent()
+    .bindInstance(request);
+}
+
+int main() {
+  fruit::NormalizedComponent<fruit::Required<Request>, Handler> default_normalized_component(getHandlerComponent());
+  fruit::BindingLookupStatistics normalized_statistics = default_normalized_component.getBindingLookupStatistics();
+  Assert(!normalized_statistics.perfect_hash_table_shared);
+  Assert(normalized_statistics.num_bucketed_types == 0);
+  // Handler and Request.
+  Assert(normalized_statistics.num_perfect_hash_types == 2);
+  Assert(normalized_statistics.num_perfect_hash_slots >= 2);
+  
+  Request request;
+  
+  {
+    // Extra1 and Extra2 are added to the bucketed hash table, the perfect hash table is shared.
+    fruit::Injector<Handler, Extra2> injector(default_normalized_component, getRequestComponent(request));
+    fruit::BindingLookupStatistics statistics = injector.getBindingLookupStatistics();
+    Assert(statistics.perfect_hash_table_shared);
+    Assert(statistics.num_perfect_hash_types == 2);
+    Assert(statistics.num_bucketed_types == 2);
+    Assert(statistics.num_buckets >= 1);
+    Assert(statistics.max_bucket_size >= 1);
+    injector.get<Handler*>();
+    injector.get<Extra2*>();
+  }
+  
+  fruit::NormalizedComponentOptions options;
+  options.max_bucketed_bindings = 1;
+  fruit::NormalizedComponent<fruit::Required<Request>, Handler> normalized_component(getHandlerComponent(), options);
+  
+  {
+    // There are too many new types, so the injector builds its own perfect hash table.
+    fruit::Injector<Handler, Extra2> injector(normalized_component, getRequestComponent(request));
+    fruit::BindingLookupStatistics statistics = injector.getBindingLookupStatistics();
+    Assert(!statistics.perfect_hash_table_shared);
+    Assert(statistics.num_perfect_hash_types == 4);
+    Assert(statistics.num_bucketed_types == 0);
+    injector.get<Handler*>();
+    injector.get<Extra2*>();
+  }
+  
+  {
+    // The same limit applies to PreparedInjector. The injectors created from it share its perfect hash table.
+    fruit::PreparedInjector<Handler, Extra2> prepared_injector(normalized_component, getRequestComponent(request));
+    fruit::Injector<Handler, Extra2> injector(prepared_injector, getRequestComponent(request));
+    fruit::BindingLookupStatistics statistics = injector.getBindingLookupStatistics();
+    Assert(statistics.num_perfect_hash_types == 4);
+    Assert(statistics.num_bucketed_types == 0);
+  }
+  
+  return 0;
+}
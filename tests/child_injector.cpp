@@ -0,0 +1,235 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_common.h"
+
+#include <thread>
+
+struct X {
+  INJECT(X()) {
+    ++num_constructions;
+    ++num_instances;
+  }
+  
+  ~X() {
+    --num_instances;
+  }
+  
+  static int num_constructions;
+  static int num_instances;
+};
+
+int X::num_constructions = 0;
+int X::num_instances = 0;
+
+struct Request {
+  int id;
+};
+
+struct Y {
+  X& x;
+  Request& request;
+  
+  INJECT(Y(X& x, Request& request))
+    : x(x), request(request) {
+    ++num_instances;
+  }
+  
+  ~Y() {
+    // X is owned by the parent injector, so it must still exist.
+    Assert(X::num_instances == 1);
+    --num_instances;
+  }
+  
+  static int num_instances;
+};
+
+int Y::num_instances = 0;
+
+struct Interface {
+  virtual int f() = 0;
+  virtual ~Interface() = default;
+};
+
+struct ImplA : public Interface {
+  INJECT(ImplA()) = default;
+  
+  int f() override {
+    return 1;
+  }
+};
+
+struct ImplB : public Interface {
+  INJECT(ImplB()) = default;
+  
+  int f() override {
+    return 2;
+  }
+};
+
+struct Z {
+};
+
+// Bound in the parent injector. All the Dep<n> share the same X, so it must be constructed only once even if they're
+// constructed concurrently.
+template <int n>
+struct Dep {
+  INJECT(Dep(X&)) {
+    // Make it more likely that the other Dep<n> are constructed in other threads in the meantime.
+    std::this_thread::yield();
+  }
+};
+
+// Only depends on types bound in the parent injector.
+template <int n>
+struct Consumer {
+  X& x;
+  Dep<n>& dep;
+  
+  INJECT(Consumer(X& x, Dep<n>& dep))
+    : x(x), dep(dep) {
+  }
+};
+
+fruit::Component<X, Interface> getParentComponent() {
+  return fruit::createComponent()
+    .bind<Interface, ImplA>()
+    .addMultibindingProvider([](){return new Z();});
+}
+
+fruit::Component<fruit::Required<X>, Request, Y> getRequestComponent(Request& request) {
+  return fruit::createComponent()
+    .bindInstance(request);
+}
+
+fruit::Component<Interface> getOverridingComponent() {
+  return fruit::createComponent()
+    .bind<Interface, ImplB>();
+}
+
+fruit::Component<X, Dep<1>, Dep<2>, Dep<3>, Dep<4>> getDepsComponent() {
+  return fruit::createComponent();
+}
+
+fruit::Component<fruit::Required<X, Dep<1>, Dep<2>, Dep<3>, Dep<4>>, Consumer<1>, Consumer<2>, Consumer<3>, Consumer<4>>
+    getConsumersComponent() {
+  return fruit::createComponent();
+}
+
+void test_objects_shared_with_parent() {
+  fruit::Injector<X, Interface> parent(getParentComponent());
+  X* x = parent.get<X*>();
+  Assert(X::num_constructions == 1);
+  
+  for (int i = 1; i <= 3; ++i) {
+    Request request{i};
+    fruit::Injector<X, Y> injector(parent, getRequestComponent(request));
+    Y* y = injector.get<Y*>();
+    Assert(&(y->x) == x);
+    Assert(&(y->request) == &request);
+    Assert(injector.get<X*>() == x);
+    Assert(injector.unsafeGet<Interface>() == parent.get<Interface*>());
+    Assert(Y::num_instances == 1);
+  }
+  
+  Assert(X::num_constructions == 1);
+  Assert(X::num_instances == 1);
+  Assert(Y::num_instances == 0);
+}
+
+void test_parent_objects_constructed_on_demand() {
+  X::num_constructions = 0;
+  fruit::Injector<X, Interface> parent(getParentComponent());
+  Request request{1};
+  fruit::Injector<Y> injector(parent, getRequestComponent(request));
+  Assert(X::num_constructions == 0);
+  
+  injector.get<Y*>();
+  Assert(X::num_constructions == 1);
+  Assert(parent.get<X*>() == &(injector.get<Y&>().x));
+  Assert(X::num_constructions == 1);
+}
+
+void test_override() {
+  fruit::Injector<X, Interface> parent(getParentComponent());
+  fruit::Injector<Interface> injector(parent, getOverridingComponent());
+  Assert(injector.get<Interface*>()->f() == 2);
+  Assert(parent.get<Interface*>()->f() == 1);
+}
+
+void test_multibindings_from_parent() {
+  fruit::Injector<X, Interface> parent(getParentComponent());
+  Request request{1};
+  fruit::Injector<Y> injector(parent, getRequestComponent(request));
+  const std::vector<Z*>& multibindings = injector.getMultibindings<Z>();
+  Assert(multibindings.size() == 1);
+  Assert(multibindings[0] == parent.getMultibindings<Z>()[0]);
+}
+
+void test_grandchild() {
+  fruit::Injector<X, Interface> parent(getParentComponent());
+  fruit::Injector<X, Interface> child(parent, getOverridingComponent());
+  Request request{1};
+  fruit::Injector<X, Interface, Y> grandchild(child, getRequestComponent(request));
+  Assert(&(grandchild.get<Y*>()->x) == parent.get<X*>());
+  Assert(grandchild.get<X*>() == parent.get<X*>());
+  Assert(grandchild.get<Interface*>() == child.get<Interface*>());
+  Assert(grandchild.get<Interface*>()->f() == 2);
+}
+
+void test_parallel_eager_injection_with_deps_in_parent() {
+  X::num_constructions = 0;
+  fruit::Injector<X, Dep<1>, Dep<2>, Dep<3>, Dep<4>> parent(getDepsComponent());
+  fruit::Injector<Consumer<1>, Consumer<2>, Consumer<3>, Consumer<4>> injector(parent, getConsumersComponent());
+  
+  // All the deps of the consumers are constructed by the parent (from the threads used here), so this must make the
+  // parent thread-safe too.
+  injector.eagerlyInjectAll(4);
+  Assert(X::num_constructions == 1);
+  X* x = parent.get<X*>();
+  Assert(&(injector.get<Consumer<1>&>().x) == x);
+  Assert(&(injector.get<Consumer<4>&>().x) == x);
+  Assert(&(injector.get<Consumer<1>&>().dep) == parent.get<Dep<1>*>());
+  Assert(&(injector.get<Consumer<2>&>().dep) == parent.get<Dep<2>*>());
+  Assert(&(injector.get<Consumer<3>&>().dep) == parent.get<Dep<3>*>());
+  Assert(&(injector.get<Consumer<4>&>().dep) == parent.get<Dep<4>*>());
+  Assert(X::num_constructions == 1);
+}
+
+void test_parallel_multibindings_from_parent() {
+  fruit::Injector<X, Interface> parent(getParentComponent());
+  fruit::Injector<X, Interface> child(parent, getOverridingComponent());
+  Request request{1};
+  fruit::Injector<Y> grandchild(child, getRequestComponent(request));
+  const std::vector<Z*>& multibindings = grandchild.getMultibindingsParallel<Z>(4);
+  Assert(multibindings.size() == 1);
+  Assert(multibindings[0] == parent.getMultibindings<Z>()[0]);
+}
+
+int main() {
+  test_objects_shared_with_parent();
+  test_parent_objects_constructed_on_demand();
+  test_override();
+  test_multibindings_from_parent();
+  test_grandchild();
+  test_parallel_eager_injection_with_deps_in_parent();
+  test_parallel_multibindings_from_parent();
+  
+  Assert(X::num_instances == 0);
+  Assert(Y::num_instances == 0);
+  
+  return 0;
+}
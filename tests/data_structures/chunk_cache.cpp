@@ -0,0 +1,90 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_common.h"
+
+#define IN_FRUIT_CPP_FILE
+#include <fruit/impl/data_structures/chunk_cache.h>
+
+#include <thread>
+
+using namespace std;
+using namespace fruit::impl;
+
+void test_reuse() {
+  ChunkCache cache;
+  void* p = cache.allocate(100, 1);
+  Assert(cache.getNumMisses() == 1);
+  cache.deallocate(p, 100, 1);
+  Assert(cache.allocate(100, 1) == p);
+  Assert(cache.getNumHits() == 1);
+  // A chunk of a different size is not reused.
+  void* q = cache.allocate(200, 1);
+  Assert(q != p);
+  Assert(cache.getNumHits() == 1);
+  Assert(cache.getNumMisses() == 2);
+  cache.deallocate(p, 100, 1);
+  cache.deallocate(q, 200, 1);
+}
+
+void test_limit() {
+  ChunkCache cache;
+  std::vector<void*> chunks;
+  for (int i = 0; i < 100; ++i) {
+    chunks.push_back(cache.allocate(16, 8));
+  }
+  for (void* p : chunks) {
+    cache.deallocate(p, 16, 8);
+  }
+  chunks.clear();
+  for (int i = 0; i < 100; ++i) {
+    chunks.push_back(cache.allocate(16, 8));
+  }
+  // Only some of the chunks were kept.
+  Assert(cache.getNumHits() != 0);
+  Assert(cache.getNumHits() < 100);
+  Assert(cache.getNumHits() + cache.getNumMisses() == 200);
+  for (void* p : chunks) {
+    cache.deallocate(p, 16, 8);
+  }
+}
+
+void test_threads() {
+  ChunkCache cache;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&cache]() {
+      for (int j = 0; j < 1000; ++j) {
+        void* p = cache.allocate(64, 8);
+        cache.deallocate(p, 64, 8);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  Assert(cache.getNumHits() + cache.getNumMisses() == 4000);
+  // Each thread reuses the chunks that it deallocated.
+  Assert(cache.getNumHits() >= 3000);
+}
+
+int main() {
+  test_reuse();
+  test_limit();
+  test_threads();
+  
+  return 0;
+}
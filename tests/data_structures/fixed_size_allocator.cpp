@@ -54,6 +54,40 @@ struct Y {
 
 int Y::num_instances = 0;
 
+// Records the order in which the objects are destroyed.
+std::vector<int> destroyed_ids;
+
+template <int n>
+struct Z {
+  int id;
+  
+  Z(int id) : id(id) {
+  }
+  
+  ~Z() {
+    destroyed_ids.push_back(id);
+  }
+};
+
+struct LeakSafe {
+  static int num_instances;
+  
+  LeakSafe() {
+    ++num_instances;
+  }
+  
+  ~LeakSafe() {
+    --num_instances;
+  }
+};
+
+int LeakSafe::num_instances = 0;
+
+namespace fruit {
+template <>
+struct IsLeakSafe<LeakSafe> : public std::true_type {};
+}
+
 template <int n>
 struct alignas(n) TypeWithAlignment {
   TypeWithAlignment() {
@@ -157,6 +191,125 @@ void test_move_constructor() {
   Assert(Y::num_instances == 0);
 }
 
+void test_reset() {
+  {
+    FixedSizeAllocator::FixedSizeAllocatorData allocator_data;
+    allocator_data.addExternallyAllocatedType(getTypeId<X>());
+    allocator_data.addType(getTypeId<Y>());
+    FixedSizeAllocator allocator(allocator_data);
+    for (int i = 0; i < 3; ++i) {
+      allocator.registerExternallyAllocatedObject(new X(15));
+      Y* y = allocator.constructObject<Y>();
+      Assert(X::num_instances == 1);
+      Assert(Y::num_instances == 1);
+      allocator.reset();
+      Assert(X::num_instances == 0);
+      Assert(Y::num_instances == 0);
+      // The memory is reused.
+      Assert(allocator.constructObject<Y>() == y);
+      allocator.reset();
+    }
+    allocator.constructObject<Y>();
+    Assert(Y::num_instances == 1);
+  }
+  Assert(X::num_instances == 0);
+  Assert(Y::num_instances == 0);
+}
+
+void test_fixed_offsets() {
+  {
+    FixedSizeAllocator::FixedSizeAllocatorData allocator_data;
+    // In order of decreasing alignment, so there's no padding.
+    std::size_t offset128 = allocator_data.addTypeAtFixedOffset(getTypeId<TypeWithAlignment<128>>());
+    std::size_t offset8 = allocator_data.addTypeAtFixedOffset(getTypeId<TypeWithAlignment<8>>());
+    std::size_t offset_x = allocator_data.addTypeAtFixedOffset(getTypeId<X>());
+    std::size_t offset2 = allocator_data.addTypeAtFixedOffset(getTypeId<TypeWithAlignment<2>>());
+    Assert(offset128 == 0);
+    Assert(offset8 == sizeof(TypeWithAlignment<128>));
+    Assert(offset_x == offset8 + sizeof(TypeWithAlignment<8>));
+    Assert(offset2 == offset_x + sizeof(X));
+    allocator_data.addType(getTypeId<Y>());
+    FixedSizeAllocator allocator(allocator_data);
+    for (int i = 0; i < 2; ++i) {
+      TypeWithAlignment<2>* p2 = allocator.constructObjectAt<TypeWithAlignment<2>>(offset2);
+      X* x = allocator.constructObjectAt<X>(offset_x, 15);
+      TypeWithAlignment<128>* p128 = allocator.constructObjectAt<TypeWithAlignment<128>>(offset128);
+      allocator.constructObjectAt<TypeWithAlignment<8>>(offset8);
+      allocator.constructObjectAt<Y>(FixedSizeAllocator::no_object_offset);
+      Assert(reinterpret_cast<char*>(x) - reinterpret_cast<char*>(p128) == std::ptrdiff_t(offset_x));
+      Assert(reinterpret_cast<char*>(p2) - reinterpret_cast<char*>(p128) == std::ptrdiff_t(offset2));
+      Assert(X::num_instances == 1);
+      Assert(Y::num_instances == 1);
+      allocator.reset();
+      Assert(X::num_instances == 0);
+      Assert(Y::num_instances == 0);
+    }
+    allocator.constructObjectAt<X>(offset_x, 15);
+  }
+  Assert(X::num_instances == 0);
+}
+
+// Constructs objects with ids 0..6, with runs of objects of the same type interleaved with other objects.
+void constructObjectsForDestructionOrderTest(FixedSizeAllocator& allocator) {
+  allocator.constructObject<Z<1>>(0);
+  allocator.constructObject<Z<1>>(1);
+  allocator.constructObject<Z<2>>(2);
+  allocator.constructObject<Z<1>>(3);
+  allocator.registerExternallyAllocatedObject(new Z<1>(4));
+  allocator.registerExternallyAllocatedObject(new Z<1>(5));
+  allocator.constructObject<Z<1>>(6);
+}
+
+void test_destruction_order() {
+  {
+    FixedSizeAllocator::FixedSizeAllocatorData allocator_data;
+    for (int i = 0; i < 4; ++i) {
+      allocator_data.addType(getTypeId<Z<1>>());
+    }
+    allocator_data.addType(getTypeId<Z<2>>());
+    allocator_data.addExternallyAllocatedType(getTypeId<Z<1>>());
+    allocator_data.addExternallyAllocatedType(getTypeId<Z<1>>());
+    FixedSizeAllocator allocator(allocator_data);
+    constructObjectsForDestructionOrderTest(allocator);
+    allocator.reset();
+    Assert((destroyed_ids == std::vector<int>{6, 5, 4, 3, 2, 1, 0}));
+    destroyed_ids.clear();
+    constructObjectsForDestructionOrderTest(allocator);
+  }
+  Assert((destroyed_ids == std::vector<int>{6, 5, 4, 3, 2, 1, 0}));
+  destroyed_ids.clear();
+}
+
+void test_fast_exit() {
+  {
+    FixedSizeAllocator::FixedSizeAllocatorData allocator_data;
+    allocator_data.addType(getTypeId<LeakSafe>());
+    allocator_data.addType(getTypeId<Z<1>>());
+    allocator_data.addType(getTypeId<LeakSafe>());
+    FixedSizeAllocator allocator(allocator_data);
+    allocator.enableFastExit();
+    allocator.constructObject<LeakSafe>();
+    allocator.constructObject<Z<1>>(0);
+    allocator.constructObject<LeakSafe>();
+    Assert(LeakSafe::num_instances == 2);
+    
+    // reset() still destroys all objects.
+    allocator.reset();
+    Assert(LeakSafe::num_instances == 0);
+    Assert((destroyed_ids == std::vector<int>{0}));
+    destroyed_ids.clear();
+    
+    allocator.constructObject<LeakSafe>();
+    allocator.constructObject<Z<1>>(1);
+    allocator.constructObject<LeakSafe>();
+  }
+  // Only the object that is not leak-safe was destroyed.
+  Assert(LeakSafe::num_instances == 2);
+  Assert((destroyed_ids == std::vector<int>{1}));
+  destroyed_ids.clear();
+  LeakSafe::num_instances = 0;
+}
+
 int main() {
   test_empty_allocator();
   test_2_types();
@@ -165,6 +318,10 @@ int main() {
   test_remove_type();
   test_alignment();
   test_move_constructor();
+  test_reset();
+  test_fixed_offsets();
+  test_destruction_order();
+  test_fast_exit();
   
   return 0;
 }
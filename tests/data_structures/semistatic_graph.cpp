@@ -271,6 +271,70 @@ void test_incomplete_graph() {
   Assert(cgraph.find(2) == cgraph.end());
 }
 
+void test_dense_index() {
+  vector<SimpleNode> old_values{{2, "foo", &no_neighbors, false}, {4, "baz", &no_neighbors, true}};
+  Graph old_graph(old_values.begin(), old_values.end());
+  // The dense index of node n is n/2.
+  old_graph.buildDenseIndex(old_values.begin(), old_values.end(), [](int n) { return n / 2; });
+  Assert(old_graph.atDenseIndex(1, 2).getNode() == string("foo"));
+  Assert(old_graph.atDenseIndex(2, 4).getNode() == string("baz"));
+  vector<int> neighbors = {2, 4};
+  vector<SimpleNode> new_values{{6, "bar", &neighbors, false}};
+  Graph graph(old_graph, new_values.begin(), new_values.end());
+  Assert(graph.atDenseIndex(1, 2).getNode() == string("foo"));
+  Assert(graph.atDenseIndex(2, 4).getNode() == string("baz"));
+  Assert(graph.atDenseIndex(2, 4).isTerminal() == true);
+  // This node is not in the dense index, it's found with a hash lookup.
+  Assert(graph.atDenseIndex(3, 6).getNode() == string("bar"));
+  Assert(graph.atDenseIndex(3, 6).isTerminal() == false);
+}
+
+void test_dependency_order_layout() {
+  // 1 -> {2, 3}, 2 -> {4}, 3 -> {4, 5}. 5 is only a neighbor.
+  vector<int> neighbors1 = {2, 3};
+  vector<int> neighbors2 = {4};
+  vector<int> neighbors3 = {4, 5};
+  vector<SimpleNode> values{{4, "4", &no_neighbors, true},
+                            {3, "3", &neighbors3, false},
+                            {1, "1", &neighbors1, false},
+                            {2, "2", &neighbors2, false}};
+  Graph graph(values.begin(), values.end(), Graph::Layout::DEPENDENCY_ORDER);
+  Assert(graph.at(1).getNode() == string("1"));
+  Assert(graph.at(2).getNode() == string("2"));
+  Assert(graph.at(3).getNode() == string("3"));
+  Assert(graph.at(4).getNode() == string("4"));
+  Assert(graph.at(4).isTerminal());
+  Assert(graph.find(5) == graph.end());
+  edge_iterator itr = graph.at(3).neighborsBegin();
+  Assert(itr.getNodeIterator(graph.begin()).getNode() == string("4"));
+  
+  // The visit starts from 4 (the first node), then continues from 3 (reaching 5), then 1 (reaching 2).
+  Assert(&graph.at(4).getNode() < &graph.at(3).getNode());
+  Assert(&graph.at(3).getNode() < &graph.at(1).getNode());
+  Assert(&graph.at(1).getNode() < &graph.at(2).getNode());
+}
+
+void test_parallel_construction() {
+  vector<int> neighbors1 = {2, 3};
+  vector<int> neighbors2 = {4};
+  vector<int> neighbors3 = {4, 5};
+  vector<SimpleNode> values{{4, "4", &no_neighbors, true},
+                            {3, "3", &neighbors3, false},
+                            {1, "1", &neighbors1, false},
+                            {2, "2", &neighbors2, false}};
+  for (Graph::Layout layout : {Graph::Layout::UNSPECIFIED, Graph::Layout::DEPENDENCY_ORDER}) {
+    Graph graph(values.begin(), values.end(), layout, 3);
+    Assert(graph.at(1).getNode() == string("1"));
+    Assert(graph.at(4).isTerminal());
+    edge_iterator itr = graph.at(1).neighborsBegin();
+    Assert(itr.getNodeIterator(graph.begin()).getNode() == string("2"));
+    ++itr;
+    Assert(itr.getNodeIterator(graph.begin()).getNode() == string("3"));
+    itr = graph.at(3).neighborsBegin();
+    Assert(itr.getNodeIterator(graph.begin()).getNode() == string("4"));
+  }
+}
+
 int main() {
   
   test_empty();
@@ -284,6 +348,9 @@ int main() {
   test_move_constructor();
   test_move_assignment();
   test_incomplete_graph();
+  test_dense_index();
+  test_dependency_order_layout();
+  test_parallel_construction();
   
   return 0;
 }
@@ -132,6 +132,112 @@ void test_move_assignment() {
   Assert(map.find(5) == nullptr);
 }
 
+void test_many_elems(std::uint_fast64_t seed) {
+  vector<pair<int, std::string>> values;
+  for (int i = 0; i < 1000; ++i) {
+    values.push_back(std::make_pair(i * 7, std::to_string(i * 7)));
+  }
+  SemistaticMap<int, std::string> map(values.begin(), values.size(), seed);
+  for (int i = 0; i < 7000; ++i) {
+    if (i % 7 == 0) {
+      Assert(map.find(i) != nullptr);
+      Assert(map.at(i) == std::to_string(i));
+    } else {
+      Assert(map.find(i) == nullptr);
+    }
+  }
+}
+
+void test_many_elems_many_inserted() {
+  vector<pair<int, std::string>> values;
+  for (int i = 0; i < 1000; ++i) {
+    values.push_back(std::make_pair(i * 2, std::to_string(i * 2)));
+  }
+  SemistaticMap<int, std::string> old_map(values.begin(), values.size());
+  vector<pair<int, std::string>> new_values;
+  for (int i = 0; i < 100; ++i) {
+    new_values.push_back(std::make_pair(i * 2 + 1, std::to_string(i * 2 + 1)));
+  }
+  SemistaticMap<int, std::string> map(old_map, std::move(new_values));
+  vector<pair<int, std::string>> newer_values{{201, "201"}};
+  SemistaticMap<int, std::string> newer_map(map, std::move(newer_values));
+  for (int i = 0; i < 2000; ++i) {
+    if (i % 2 == 0 || i < 200) {
+      Assert(map.find(i) != nullptr);
+      Assert(map.at(i) == std::to_string(i));
+    } else {
+      Assert(map.find(i) == nullptr);
+    }
+    if (i % 2 == 0 || i < 202) {
+      Assert(newer_map.find(i) != nullptr);
+      Assert(newer_map.at(i) == std::to_string(i));
+    } else {
+      Assert(newer_map.find(i) == nullptr);
+    }
+  }
+}
+
+void test_many_inserted_elems_with_64_bit_keys() {
+  // All these elements are stored in the bucketed hash table, since the original map is empty.
+  vector<pair<std::uint64_t, int>> values;
+  SemistaticMap<std::uint64_t, int> old_map(values.begin(), values.size());
+  vector<pair<std::uint64_t, int>> new_values;
+  for (int i = 0; i < 1000; ++i) {
+    new_values.push_back(std::make_pair((std::uint64_t(i) << 32) + 2 * i, i));
+  }
+  SemistaticMap<std::uint64_t, int> map(old_map, std::move(new_values));
+  for (int i = 0; i < 1000; ++i) {
+    Assert(map.find((std::uint64_t(i) << 32) + 2 * i) != nullptr);
+    Assert(map.at((std::uint64_t(i) << 32) + 2 * i) == i);
+    // Only one of the two 32-bit halves matches.
+    Assert(map.find((std::uint64_t(i) << 32) + 2 * i + 1) == nullptr);
+    Assert(map.find((std::uint64_t(i + 1) << 32) + 2 * i) == nullptr);
+  }
+}
+
+void test_overlay_strategy() {
+  using Map = SemistaticMap<int, int>;
+  vector<pair<int, int>> values;
+  for (int i = 0; i < 1000; ++i) {
+    values.push_back(std::make_pair(i * 2, i));
+  }
+  Map old_map(values.begin(), values.size());
+  Map::Statistics old_statistics = old_map.getStatistics();
+  Assert(old_statistics.strategy == Map::Strategy::PERFECT_HASH);
+  Assert(old_statistics.num_perfect_hash_elems == 1000);
+  Assert(old_statistics.num_bucketed_elems == 0);
+  
+  vector<pair<int, int>> new_values;
+  for (int i = 0; i < 100; ++i) {
+    new_values.push_back(std::make_pair(i * 2 + 1, i));
+  }
+  
+  // With a high threshold, the new elements go in the bucketed hash table.
+  Map shared_map(old_map, vector<pair<int, int>>(new_values), 100);
+  Map::Statistics shared_statistics = shared_map.getStatistics();
+  Assert(shared_statistics.strategy == Map::Strategy::SHARED_PERFECT_HASH);
+  Assert(shared_statistics.num_perfect_hash_elems == 1000);
+  Assert(shared_statistics.num_bucketed_elems == 100);
+  Assert(shared_statistics.max_bucket_size < 4);
+  
+  // Otherwise, a new perfect hash table is built.
+  Map rebuilt_map(old_map, vector<pair<int, int>>(new_values), 99);
+  Map::Statistics rebuilt_statistics = rebuilt_map.getStatistics();
+  Assert(rebuilt_statistics.strategy == Map::Strategy::PERFECT_HASH);
+  Assert(rebuilt_statistics.num_perfect_hash_elems == 1100);
+  Assert(rebuilt_statistics.num_bucketed_elems == 0);
+  
+  for (int i = 0; i < 2000; ++i) {
+    if (i % 2 == 0 || i < 200) {
+      Assert(shared_map.at(i) == i / 2);
+      Assert(rebuilt_map.at(i) == i / 2);
+    } else {
+      Assert(shared_map.find(i) == nullptr);
+      Assert(rebuilt_map.find(i) == nullptr);
+    }
+  }
+}
+
 int main() {
   
   test_empty();
@@ -142,6 +248,11 @@ int main() {
   test_3_elem_3_inserted();
   test_move_constructor();
   test_move_assignment();
+  test_many_elems(SemistaticMap<int, std::string>::default_seed);
+  test_many_elems(12345);
+  test_many_elems_many_inserted();
+  test_many_inserted_elems_with_64_bit_keys();
+  test_overlay_strategy();
   
   return 0;
 }
@@ -0,0 +1,182 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_common.h"
+
+#include <cstdlib>
+#include <new>
+
+std::size_t num_allocations = 0;
+
+void* operator new(std::size_t size) {
+  ++num_allocations;
+  void* p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+struct X {
+  INJECT(X()) = default;
+  
+  int value = 1;
+};
+
+struct Y {
+  INJECT(Y()) = default;
+  
+  int value = 10;
+};
+
+struct Point {
+  int sum;
+  
+  Point(int sum)
+    : sum(sum) {
+  }
+};
+
+struct Annotation {};
+
+fruit::Component<fruit::Factory<Point(int)>, fruit::Annotated<Annotation, fruit::Factory<Point(int)>>> getPointComponent() {
+  return fruit::createComponent()
+    .registerFruitFactory<Point(X&, Y*, fruit::Assisted<int>)>(
+        [](X& x, Y* y, int n) {
+          return Point(x.value + y->value + n);
+        })
+    .registerFruitFactory<fruit::Annotated<Annotation, Point>(fruit::Assisted<int>)>(
+        [](int n) {
+          return Point(-n);
+        });
+}
+
+void test_register_factory() {
+  fruit::Injector<fruit::Factory<Point(int)>, fruit::Annotated<Annotation, fruit::Factory<Point(int)>>> injector(
+      getPointComponent());
+  
+  fruit::Factory<Point(int)> factory(injector);
+  Assert(factory(100).sum == 111);
+  
+  fruit::Factory<Point(int)> annotated_factory =
+      injector.get<fruit::Annotated<Annotation, fruit::Factory<Point(int)>>>();
+  Assert(annotated_factory(5).sum == -5);
+  
+  // Copying and calling a Factory doesn't allocate memory.
+  std::size_t num_allocations_before = num_allocations;
+  fruit::Factory<Point(int)> factory_copy = factory;
+  Assert(factory_copy(200).sum == 211);
+  Assert(num_allocations == num_allocations_before);
+}
+
+Point makePoint(X& x, int n) {
+  return Point(x.value + n);
+}
+
+fruit::Component<std::function<Point(int)>, fruit::Factory<Point(int)>> getPointFunctionComponent() {
+  return fruit::createComponent()
+    .registerFactory<Point(X&, fruit::Assisted<int>)>(
+        [](X& x, int n) {
+          return makePoint(x, n);
+        })
+    .registerFruitFactory<Point(X&, fruit::Assisted<int>)>(
+        [](X& x, int n) {
+          return makePoint(x, n);
+        });
+}
+
+void test_factory_and_std_function_are_equivalent() {
+  fruit::Injector<std::function<Point(int)>, fruit::Factory<Point(int)>> injector(getPointFunctionComponent());
+  
+  std::function<Point(int)> function(injector);
+  fruit::Factory<Point(int)> factory(injector);
+  Assert(function(3).sum == 4);
+  Assert(factory(3).sum == 4);
+}
+
+struct Widget {
+  INJECT(Widget(X& x, ASSISTED(int) n))
+    : x(x), n(n) {
+  }
+  
+  X& x;
+  int n;
+};
+
+struct WidgetUser {
+  INJECT(WidgetUser(fruit::Factory<Widget(int)> widget_factory,
+                    fruit::Factory<std::unique_ptr<Widget>(int)> widget_ptr_factory))
+    : widget_factory(widget_factory), widget_ptr_factory(widget_ptr_factory) {
+  }
+  
+  fruit::Factory<Widget(int)> widget_factory;
+  fruit::Factory<std::unique_ptr<Widget>(int)> widget_ptr_factory;
+};
+
+fruit::Component<WidgetUser> getWidgetUserComponent() {
+  return fruit::createComponent();
+}
+
+void test_auto_registered_factory() {
+  fruit::Injector<WidgetUser> injector(getWidgetUserComponent());
+  
+  WidgetUser& widget_user = injector.get<WidgetUser&>();
+  Widget widget = widget_user.widget_factory(5);
+  Assert(widget.n == 5);
+  
+  std::unique_ptr<Widget> widget_ptr = widget_user.widget_ptr_factory(7);
+  Assert(widget_ptr->n == 7);
+  Assert(&widget_ptr->x == &widget.x);
+}
+
+fruit::Component<std::function<Widget(int)>> getWidgetFunctionComponent() {
+  return fruit::createComponent();
+}
+
+fruit::Component<std::function<Widget(int)>, fruit::Factory<Widget(int)>> getWidgetFunctionAndFactoryComponent() {
+  return fruit::createComponent();
+}
+
+std::size_t getNumBindings(const fruit::BindingLookupStatistics& statistics) {
+  return statistics.num_perfect_hash_types + statistics.num_bucketed_types;
+}
+
+void test_factory_only_bound_when_requested() {
+  fruit::Injector<std::function<Widget(int)>> injector(getWidgetFunctionComponent());
+  fruit::Injector<std::function<Widget(int)>, fruit::Factory<Widget(int)>> injector_with_factory(
+      getWidgetFunctionAndFactoryComponent());
+  
+  // Requesting the Factory only adds the bindings for Factory<Widget(int)> and for the object that implements it.
+  Assert(getNumBindings(injector_with_factory.getBindingLookupStatistics())
+         == getNumBindings(injector.getBindingLookupStatistics()) + 2);
+}
+
+int main() {
+  test_register_factory();
+  test_factory_and_std_function_are_equivalent();
+  test_auto_registered_factory();
+  test_factory_only_bound_when_requested();
+  
+  return 0;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_common.h"
+
+#include <thread>
+
+// The typical use of a NormalizedComponent: one injector per request, where each request provides its own
+// RequestContext and the rest of the bindings are shared.
+struct RequestContext {
+  int id;
+};
+
+struct Session {
+  INJECT(Session()) {
+    ++num_instances;
+  }
+  
+  ~Session() {
+    --num_instances;
+  }
+  
+  static int num_instances;
+};
+
+int Session::num_instances = 0;
+
+struct RequestHandler {
+  INJECT(RequestHandler(Session& session, RequestContext& context))
+    : session(session), context(context) {
+  }
+  
+  Session& session;
+  RequestContext& context;
+};
+
+fruit::Component<fruit::Required<RequestContext>, RequestHandler> getRequestHandlerComponent() {
+  return fruit::createComponent();
+}
+
+fruit::Component<RequestContext> getRequestContextComponent(RequestContext& context) {
+  return fruit::createComponent()
+    .bindInstance(context);
+}
+
+int main() {
+  fruit::NormalizedComponent<fruit::Required<RequestContext>, RequestHandler> normalized_component(
+      getRequestHandlerComponent());
+  Assert(normalized_component.getNumAllocatorCacheHits() == 0);
+  Assert(normalized_component.getNumAllocatorCacheMisses() == 0);
+  
+  RequestHandler* first_handler = nullptr;
+  for (int i = 0; i < 10; ++i) {
+    RequestContext context{i};
+    fruit::Injector<RequestHandler> injector(normalized_component, getRequestContextComponent(context));
+    RequestHandler* handler = injector.get<RequestHandler*>();
+    Assert(handler->context.id == i);
+    if (i == 0) {
+      first_handler = handler;
+    } else {
+      // The chunk of the first request's injector is reused.
+      Assert(handler == first_handler);
+    }
+  }
+  Assert(Session::num_instances == 0);
+  // The first injector allocates the chunk (and the vector of objects to destroy), the others reuse them.
+  std::size_t num_misses = normalized_component.getNumAllocatorCacheMisses();
+  Assert(num_misses != 0);
+  Assert(num_misses <= 2);
+  Assert(normalized_component.getNumAllocatorCacheHits() == 9 * num_misses);
+  
+  // Injectors created through a PreparedInjector use the same cache.
+  RequestContext prepared_context{10};
+  fruit::PreparedInjector<RequestHandler> prepared_injector(normalized_component,
+                                                            getRequestContextComponent(prepared_context));
+  {
+    RequestContext context{11};
+    fruit::Injector<RequestHandler> injector(prepared_injector, getRequestContextComponent(context));
+    Assert(injector.get<RequestHandler*>() == first_handler);
+  }
+  Assert(normalized_component.getNumAllocatorCacheMisses() == num_misses);
+  
+  // Requests can be served concurrently, each thread either reuses a cached chunk or allocates a new one.
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&normalized_component, i]() {
+      for (int j = 0; j < 100; ++j) {
+        RequestContext context{100 * i + j};
+        fruit::Injector<RequestHandler> injector(normalized_component, getRequestContextComponent(context));
+        Assert(injector.get<RequestHandler&>().context.id == 100 * i + j);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  Assert(Session::num_instances == 0);
+  Assert(normalized_component.getNumAllocatorCacheHits() + normalized_component.getNumAllocatorCacheMisses()
+         == 411 * num_misses);
+  Assert(normalized_component.getNumAllocatorCacheMisses() <= 5 * num_misses);
+  
+  return 0;
+}
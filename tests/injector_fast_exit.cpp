@@ -0,0 +1,88 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_common.h"
+
+std::vector<int> destroyed_ids;
+
+// Only owns memory, so it doesn't need to be destroyed at exit.
+struct Cache {
+  INJECT(Cache()) {
+    ++num_instances;
+  }
+  
+  ~Cache() {
+    --num_instances;
+  }
+  
+  static int num_instances;
+};
+
+int Cache::num_instances = 0;
+
+namespace fruit {
+template <>
+struct IsLeakSafe<Cache> : public std::true_type {};
+}
+
+struct ListenerImpl {
+  int id;
+  
+  ListenerImpl(int id) : id(id) {
+  }
+  
+  ~ListenerImpl() {
+    destroyed_ids.push_back(id);
+  }
+};
+
+struct Server {
+  INJECT(Server(Cache&)) {
+  }
+  
+  ~Server() {
+    destroyed_ids.push_back(100);
+  }
+};
+
+fruit::Component<Server> getServerComponent() {
+  return fruit::createComponent()
+    .addMultibindingProvider([](Cache&) { return ListenerImpl(1); })
+    .addMultibindingProvider([]() { return ListenerImpl(2); })
+    .addMultibindingProvider([]() { return ListenerImpl(3); });
+}
+
+int main() {
+  for (bool fast_exit : {false, true}) {
+    {
+      fruit::Injector<Server> injector(getServerComponent());
+      if (fast_exit) {
+        injector.enableFastExit();
+      }
+      injector.get<Server&>();
+      Assert(injector.getMultibindings<ListenerImpl>().size() == 3);
+      Assert(Cache::num_instances == 1);
+      // The providers might have destroyed temporaries.
+      destroyed_ids.clear();
+    }
+    // The objects that are not leak-safe are still destroyed in reverse order of construction.
+    Assert((destroyed_ids == std::vector<int>{3, 2, 1, 100}));
+    destroyed_ids.clear();
+    Assert(Cache::num_instances == (fast_exit ? 1 : 0));
+  }
+  
+  return 0;
+}
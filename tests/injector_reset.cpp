@@ -0,0 +1,139 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_common.h"
+
+struct X {
+  INJECT(X()) {
+    ++num_constructions;
+    ++num_instances;
+  }
+  
+  ~X() {
+    --num_instances;
+  }
+  
+  static int num_constructions;
+  static int num_instances;
+};
+
+int X::num_constructions = 0;
+int X::num_instances = 0;
+
+struct Y {
+  X& x;
+  
+  INJECT(Y(X& x))
+    : x(x) {
+    ++num_constructions;
+    ++num_instances;
+  }
+  
+  ~Y() {
+    // X must be destroyed after Y.
+    Assert(X::num_instances == 1);
+    --num_instances;
+  }
+  
+  static int num_constructions;
+  static int num_instances;
+};
+
+int Y::num_constructions = 0;
+int Y::num_instances = 0;
+
+struct Z {
+  Z() {
+    ++num_instances;
+  }
+  
+  ~Z() {
+    --num_instances;
+  }
+  
+  static int num_instances;
+};
+
+int Z::num_instances = 0;
+
+struct Request {
+  int id;
+};
+
+fruit::Component<fruit::Required<Request>, Y> getComponent() {
+  return fruit::createComponent()
+    .addMultibindingProvider([](){return new Z();});
+}
+
+fruit::Component<Request> getRequestComponent(Request& request) {
+  return fruit::createComponent()
+    .bindInstance(request);
+}
+
+void test_reset() {
+  Request request{1};
+  fruit::Injector<Y> injector(fruit::Component<Y>(fruit::createComponent()
+      .install(getComponent())
+      .install(getRequestComponent(request))));
+  injector.enableReset();
+  
+  for (int i = 1; i <= 3; ++i) {
+    injector.get<Y*>();
+    Assert(injector.getMultibindings<Z>().size() == 1);
+    Assert(X::num_constructions == i);
+    Assert(Y::num_constructions == i);
+    Assert(X::num_instances == 1);
+    Assert(Y::num_instances == 1);
+    Assert(Z::num_instances == 1);
+    
+    injector.reset();
+    
+    Assert(X::num_instances == 0);
+    Assert(Y::num_instances == 0);
+    Assert(Z::num_instances == 0);
+  }
+}
+
+void test_reset_with_normalized_component() {
+  fruit::NormalizedComponent<fruit::Required<Request>, Y> normalized_component(getComponent());
+  Request request{1};
+  fruit::Injector<Request, Y> injector(normalized_component, getRequestComponent(request));
+  injector.enableReset();
+  
+  injector.eagerlyInjectAll();
+  Assert(Y::num_instances == 1);
+  Assert(Z::num_instances == 1);
+  injector.reset();
+  Assert(Y::num_instances == 0);
+  Assert(Z::num_instances == 0);
+  
+  // Instance bindings are not affected.
+  Assert(injector.get<Request*>() == &request);
+  injector.get<Y*>();
+  Assert(X::num_instances == 1);
+  Assert(Y::num_instances == 1);
+}
+
+int main() {
+  test_reset();
+  test_reset_with_normalized_component();
+  
+  Assert(X::num_instances == 0);
+  Assert(Y::num_instances == 0);
+  Assert(Z::num_instances == 0);
+  
+  return 0;
+}
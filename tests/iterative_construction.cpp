@@ -0,0 +1,179 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_common.h"
+
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// The dependency chain is resolved at compile time too, so this is limited by the maximum template instantiation depth.
+static const int chain_length = 20;
+
+static std::vector<int> construction_order;
+
+template <int n>
+struct Node {
+  Node<n - 1>& previous;
+  
+  INJECT(Node(Node<n - 1>& previous))
+    : previous(previous) {
+    construction_order.push_back(n);
+  }
+};
+
+template <>
+struct Node<0> {
+  INJECT(Node()) {
+    construction_order.push_back(0);
+  }
+};
+
+struct OnlyProvided {
+  INJECT(OnlyProvided()) {
+    ++num_constructions;
+  }
+  
+  static int num_constructions;
+};
+
+int OnlyProvided::num_constructions = 0;
+
+struct Root {
+  Node<chain_length>& last;
+  fruit::Provider<OnlyProvided> provider;
+  
+  INJECT(Root(Node<chain_length>& last, fruit::Provider<OnlyProvided> provider))
+    : last(last), provider(provider) {
+  }
+};
+
+fruit::Component<Root> getRootComponent() {
+  return fruit::createComponent();
+}
+
+void test_iterative_construction() {
+  construction_order.clear();
+  fruit::Injector<Root> injector(getRootComponent());
+  injector.enableIterativeConstruction();
+  
+  Root& root = injector.get<Root&>();
+  Assert(construction_order.size() == chain_length + 1);
+  for (int i = 0; i <= chain_length; ++i) {
+    Assert(construction_order[i] == i);
+  }
+  
+  // Provider deps are not constructed eagerly.
+  Assert(OnlyProvided::num_constructions == 0);
+  root.provider.get();
+  Assert(OnlyProvided::num_constructions == 1);
+  
+  Assert(&injector.get<Root&>() == &root);
+  Assert(construction_order.size() == chain_length + 1);
+}
+
+void test_iterative_construction_with_thread_safety() {
+  construction_order.clear();
+  OnlyProvided::num_constructions = 0;
+  fruit::Injector<Root> injector(getRootComponent());
+  injector.enableThreadSafety();
+  injector.enableIterativeConstruction();
+  
+  Root* root = nullptr;
+  std::vector<Root*> roots(4);
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < roots.size(); ++i) {
+    threads.emplace_back([&injector, &roots, i]() {
+      roots[i] = injector.get<Root*>();
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  root = roots[0];
+  for (Root* other_root : roots) {
+    Assert(other_root == root);
+  }
+  Assert(construction_order.size() == chain_length + 1);
+  Assert(OnlyProvided::num_constructions == 0);
+}
+
+// Calls get() on a Provider while it's being constructed, so the construction is re-entered.
+struct ReentrantRoot {
+  Root& root;
+  
+  INJECT(ReentrantRoot(fruit::Provider<Root> root_provider))
+    : root(*root_provider.get<Root*>()) {
+  }
+};
+
+void test_iterative_construction_reentrant() {
+  construction_order.clear();
+  fruit::Injector<ReentrantRoot> injector(fruit::Component<ReentrantRoot>(fruit::createComponent()));
+  injector.enableIterativeConstruction();
+  
+  injector.get<ReentrantRoot&>();
+  Assert(construction_order.size() == chain_length + 1);
+  for (int i = 0; i <= chain_length; ++i) {
+    Assert(construction_order[i] == i);
+  }
+}
+
+struct ThrowingOnce {
+  INJECT(ThrowingOnce(Node<chain_length>&)) {
+    if (should_throw) {
+      should_throw = false;
+      throw std::runtime_error("ThrowingOnce::ThrowingOnce()");
+    }
+  }
+  
+  static bool should_throw;
+};
+
+bool ThrowingOnce::should_throw = true;
+
+struct ThrowingRoot {
+  INJECT(ThrowingRoot(Node<0>&, ThrowingOnce&)) {
+  }
+};
+
+void test_iterative_construction_with_thread_safety_exception() {
+  construction_order.clear();
+  fruit::Injector<ThrowingRoot> injector(fruit::Component<ThrowingRoot>(fruit::createComponent()));
+  injector.enableThreadSafety();
+  injector.enableIterativeConstruction();
+  
+  try {
+    injector.get<ThrowingRoot*>();
+    Assert(false);
+  } catch (const std::runtime_error&) {
+  }
+  // The nodes that were being constructed are unlocked, so another thread can construct them.
+  std::thread thread([&injector]() {
+    injector.get<ThrowingRoot*>();
+  });
+  thread.join();
+  Assert(construction_order.size() == chain_length + 1);
+}
+
+int main() {
+  test_iterative_construction();
+  test_iterative_construction_with_thread_safety();
+  test_iterative_construction_reentrant();
+  test_iterative_construction_with_thread_safety_exception();
+  
+  return 0;
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_common.h"
+
+#include <map>
+
+// A MemoryResource that keeps track of the blocks that are currently allocated from it.
+class CountingResource : public fruit::MemoryResource {
+public:
+  ~CountingResource() {
+    Assert(blocks.empty());
+  }
+  
+  void* allocate(std::size_t size, std::size_t alignment) override {
+    void* p = operator new(size);
+    Assert(std::uintptr_t(p) % std::min(alignment, alignof(std::max_align_t)) == 0);
+    blocks[reinterpret_cast<char*>(p)] = size;
+    ++num_allocations;
+    return p;
+  }
+  
+  void deallocate(void* p, std::size_t size, std::size_t alignment) override {
+    (void)alignment;
+    auto itr = blocks.find(reinterpret_cast<char*>(p));
+    Assert(itr != blocks.end());
+    Assert(itr->second == size);
+    blocks.erase(itr);
+    operator delete(p);
+  }
+  
+  // Returns true if `p' points into one of the allocated blocks.
+  bool contains(const void* p) const {
+    const char* c = reinterpret_cast<const char*>(p);
+    auto itr = blocks.upper_bound(const_cast<char*>(c));
+    if (itr == blocks.begin()) {
+      return false;
+    }
+    --itr;
+    return c < itr->first + itr->second;
+  }
+  
+  std::map<char*, std::size_t> blocks;
+  std::size_t num_allocations = 0;
+};
+
+// Bound with bindInstance(), so it's owned by the caller and must not be allocated from the resource.
+struct Config {
+  int port = 8080;
+};
+
+// Constructed (and destroyed) by the injector.
+struct Connection {
+  INJECT(Connection()) {
+    ++num_open;
+  }
+  
+  ~Connection() {
+    --num_open;
+  }
+  
+  static int num_open;
+};
+
+int Connection::num_open = 0;
+
+struct Server {
+  INJECT(Server(Connection& connection, const Config& config))
+    : connection(connection), config(config) {
+  }
+  
+  Connection& connection;
+  const Config& config;
+};
+
+fruit::Component<fruit::Required<Config>, Server> getServerComponent() {
+  return fruit::createComponent()
+    .addMultibinding<Connection, Connection>()
+    .addMultibindingProvider([]() { return 5; });
+}
+
+fruit::Component<Config> getConfigComponent(Config& config) {
+  return fruit::createComponent()
+    .bindInstance(config);
+}
+
+fruit::Component<Server> getRootComponent(Config& config) {
+  return fruit::createComponent()
+    .install(getServerComponent())
+    .install(getConfigComponent(config));
+}
+
+// Checks that everything that `injector' constructed (but not the instance bound with bindInstance()) lives in
+// `resource'.
+void checkAllocatedFromResource(fruit::Injector<Server>& injector, CountingResource& resource, Config& config) {
+  Server& server = injector.get<Server&>();
+  Assert(&server.config == &config);
+  Assert(!resource.contains(&config));
+  Assert(resource.contains(&server));
+  Assert(resource.contains(&server.connection));
+  
+  const std::vector<Connection*>& connections = injector.getMultibindings<Connection>();
+  Assert(connections.size() == 1);
+  Assert(resource.contains(connections[0]));
+  
+  const std::vector<int*>& ints = injector.getMultibindings<int>();
+  Assert(ints.size() == 1);
+  Assert(*ints[0] == 5);
+  Assert(resource.contains(ints[0]));
+  Assert(resource.contains(&ints));
+}
+
+int main() {
+  Config config;
+  
+  // An injector created from a Component returns all its memory to the resource when it's destroyed.
+  {
+    CountingResource resource;
+    {
+      fruit::Injector<Server> injector(getRootComponent(config), resource);
+      checkAllocatedFromResource(injector, resource, config);
+    }
+    Assert(resource.blocks.empty());
+    Assert(resource.num_allocations != 0);
+    Assert(Connection::num_open == 0);
+  }
+  
+  // The NormalizedComponent and the injectors created from it (directly or through a PreparedInjector) can use
+  // different resources, and the injectors never allocate from the NormalizedComponent's one.
+  {
+    CountingResource normalized_component_resource;
+    CountingResource injector_resource;
+    {
+      fruit::NormalizedComponent<fruit::Required<Config>, Server> normalized_component(
+          getServerComponent(), normalized_component_resource);
+      Assert(normalized_component_resource.num_allocations != 0);
+      std::size_t num_normalized_component_blocks = normalized_component_resource.blocks.size();
+      
+      for (int i = 0; i < 2; ++i) {
+        {
+          fruit::Injector<Server> injector(normalized_component, getConfigComponent(config), injector_resource);
+          checkAllocatedFromResource(injector, injector_resource, config);
+        }
+        Assert(injector_resource.blocks.empty());
+        Assert(Connection::num_open == 0);
+      }
+      
+      fruit::PreparedInjector<Server> prepared_injector(normalized_component, getConfigComponent(config));
+      {
+        fruit::Injector<Server> injector(prepared_injector, getConfigComponent(config), injector_resource);
+        checkAllocatedFromResource(injector, injector_resource, config);
+      }
+      Assert(injector_resource.blocks.empty());
+      Assert(Connection::num_open == 0);
+      
+      Assert(normalized_component_resource.blocks.size() == num_normalized_component_blocks);
+    }
+    Assert(normalized_component_resource.blocks.empty());
+  }
+  
+  return 0;
+}
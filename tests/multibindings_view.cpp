@@ -0,0 +1,239 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_common.h"
+
+#include <cstdlib>
+#include <new>
+#include <set>
+
+std::size_t num_allocations = 0;
+
+void* operator new(std::size_t size) {
+  ++num_allocations;
+  void* p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+struct Listener {
+  virtual int id() = 0;
+  
+  virtual ~Listener() = default;
+};
+
+template <int n>
+struct ListenerImpl : public Listener {
+  INJECT(ListenerImpl()) = default;
+  
+  int id() override {
+    return n;
+  }
+};
+
+struct Annotation {};
+
+using ListenerAnnot = fruit::Annotated<Annotation, Listener>;
+
+ListenerImpl<10> instance_listener;
+
+fruit::Component<> getListenersComponent() {
+  return fruit::createComponent()
+    .addMultibinding<Listener, ListenerImpl<1>>()
+    .addMultibindingProvider([](){return static_cast<Listener*>(new ListenerImpl<2>());})
+    .addInstanceMultibinding<Listener>(instance_listener)
+    .addMultibinding<ListenerAnnot, ListenerImpl<3>>();
+}
+
+void test_view_matches_vector() {
+  fruit::Injector<> injector(getListenersComponent());
+  
+  fruit::MultibindingsView<Listener> listeners = injector.getMultibindingsView<Listener>();
+  Assert(listeners.size() == 3);
+  Assert(!listeners.empty());
+  
+  // Same elements, in the same order.
+  const std::vector<Listener*>& listeners_vector = injector.getMultibindings<Listener>();
+  Assert(listeners.toVector() == listeners_vector);
+  for (std::size_t i = 0; i < listeners.size(); ++i) {
+    Assert(listeners[i] == listeners_vector[i]);
+  }
+  
+  std::set<int> ids;
+  for (Listener* listener : listeners) {
+    ids.insert(listener->id());
+  }
+  Assert(ids == std::set<int>({1, 2, 10}));
+  Assert(listeners.end() - listeners.begin() == 3);
+  
+  fruit::MultibindingsView<Listener> annotated_listeners = injector.getMultibindingsView<ListenerAnnot>();
+  Assert(annotated_listeners.size() == 1);
+  Assert(annotated_listeners[0]->id() == 3);
+  
+  Assert(injector.getMultibindingsView<int>().empty());
+  Assert(injector.getMultibindingsView<int>().begin() == injector.getMultibindingsView<int>().end());
+}
+
+void test_view_does_not_allocate() {
+  fruit::Injector<> injector(getListenersComponent());
+  
+  // The constructed objects are allocated in the injector's memory, that was already allocated above.
+  std::size_t num_allocations_before = num_allocations;
+  fruit::MultibindingsView<Listener> listeners = injector.getMultibindingsView<Listener>();
+  Assert(listeners.size() == 3);
+  fruit::MultibindingsView<Listener> listeners2 = injector.getMultibindingsView<Listener>();
+  Assert(listeners2[0] == listeners[0]);
+  Assert(injector.getMultibindingsView<int>().empty());
+  // ListenerImpl<2> is constructed with new by the provider, that's the only allocation.
+  Assert(num_allocations == num_allocations_before + 1);
+}
+
+void test_view_after_reset() {
+  fruit::Injector<> injector(getListenersComponent());
+  injector.enableReset();
+  
+  std::vector<int> ids_before_reset;
+  for (Listener* listener : injector.getMultibindingsView<Listener>()) {
+    ids_before_reset.push_back(listener->id());
+  }
+  injector.reset();
+  fruit::MultibindingsView<Listener> listeners = injector.getMultibindingsView<Listener>();
+  Assert(listeners.size() == 3);
+  for (std::size_t i = 0; i < listeners.size(); ++i) {
+    Assert(listeners[i]->id() == ids_before_reset[i]);
+  }
+}
+
+struct Handler {
+  virtual bool canHandle(int request) = 0;
+  
+  virtual ~Handler() = default;
+  
+  static int num_constructed;
+};
+
+int Handler::num_constructed = 0;
+
+template <int n>
+struct HandlerImpl : public Handler {
+  INJECT(HandlerImpl()) {
+    ++num_constructed;
+  }
+  
+  bool canHandle(int request) override {
+    return request == n;
+  }
+};
+
+fruit::Component<> getHandlersComponent() {
+  return fruit::createComponent()
+    .addMultibinding<Handler, HandlerImpl<1>>()
+    .addMultibinding<Handler, HandlerImpl<2>>()
+    .addMultibinding<Handler, HandlerImpl<3>>()
+    .addMultibinding<Handler, HandlerImpl<4>>();
+}
+
+void test_lazy_view_constructs_on_access() {
+  Handler::num_constructed = 0;
+  fruit::Injector<> injector(getHandlersComponent());
+  
+  fruit::LazyMultibindingsView<Handler> handlers = injector.getLazyMultibindings<Handler>();
+  Assert(handlers.size() == 4);
+  Assert(Handler::num_constructed == 0);
+  
+  // Each object is constructed once, when it's first accessed.
+  Handler* handler = handlers[2];
+  Assert(Handler::num_constructed == 1);
+  Assert(handlers[2] == handler);
+  Assert(Handler::num_constructed == 1);
+  
+  std::size_t n = 0;
+  for (Handler* h : handlers) {
+    (void)h;
+    ++n;
+  }
+  Assert(n == 4);
+  Assert(Handler::num_constructed == 4);
+  
+  // The eager view returns the same objects.
+  const std::vector<Handler*>& handlers_vector = injector.getMultibindings<Handler>();
+  Assert(handlers_vector.size() == 4);
+  Assert(Handler::num_constructed == 4);
+  for (std::size_t i = 0; i < handlers.size(); ++i) {
+    Assert(handlers[i] == handlers_vector[i]);
+  }
+  
+  Assert(injector.getLazyMultibindings<int>().empty());
+  Assert(injector.getLazyMultibindings<int>().begin() == injector.getLazyMultibindings<int>().end());
+}
+
+void test_lazy_view_find_first() {
+  Handler::num_constructed = 0;
+  fruit::Injector<> injector(getHandlersComponent());
+  
+  fruit::LazyMultibindingsView<Handler> handlers = injector.getLazyMultibindings<Handler>();
+  Handler* handler = handlers.findFirst([](Handler* h) { return h->canHandle(3); });
+  Assert(handler != nullptr);
+  Assert(handler->canHandle(3));
+  
+  // Only the handlers up to the returned one were constructed (accessing them again doesn't construct anything).
+  std::size_t position = 0;
+  while (handlers[position] != handler) {
+    ++position;
+  }
+  Assert(Handler::num_constructed == int(position) + 1);
+  
+  Assert(handlers.findFirst([](Handler* h) { return h->canHandle(5); }) == nullptr);
+  Assert(Handler::num_constructed == 4);
+}
+
+fruit::Component<> getEmptyComponent() {
+  return fruit::createComponent();
+}
+
+void test_lazy_view_in_child_injector() {
+  Handler::num_constructed = 0;
+  fruit::Injector<> parent(getHandlersComponent());
+  fruit::Injector<> child(parent, getEmptyComponent());
+  
+  // The child injector has no multibindings for Handler, so the parent's ones are used (and constructed in the parent).
+  Handler* handler = child.getLazyMultibindings<Handler>()[0];
+  Assert(Handler::num_constructed == 1);
+  Assert(parent.getLazyMultibindings<Handler>()[0] == handler);
+  Assert(parent.getMultibindingsView<Handler>()[0] == handler);
+  Assert(Handler::num_constructed == 4);
+}
+
+int main() {
+  test_view_matches_vector();
+  test_view_does_not_allocate();
+  test_view_after_reset();
+  test_lazy_view_constructs_on_access();
+  test_lazy_view_find_first();
+  test_lazy_view_in_child_injector();
+  
+  return 0;
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_common.h"
+
+struct Listener {
+  int id;
+  
+  Listener(int id)
+    : id(id) {
+    ++num_instances;
+  }
+  
+  ~Listener() {
+    --num_instances;
+  }
+  
+  static int num_instances;
+};
+
+int Listener::num_instances = 0;
+
+int five = 5;
+
+struct Request {
+  int id;
+};
+
+fruit::Component<fruit::Required<Request>> getComponent() {
+  return fruit::createComponent()
+    .addMultibindingProvider([](){return new Listener(1);})
+    .addMultibindingProvider([](){return new Listener(2);})
+    .addMultibindingProvider([](Request& request){return new Listener(100 + request.id);})
+    .addInstanceMultibinding(five);
+}
+
+fruit::Component<Request> getRequestComponent(Request& request) {
+  return fruit::createComponent()
+    .bindInstance(request);
+}
+
+fruit::Component<Request> getRequestComponentWithListener(Request& request) {
+  return fruit::createComponent()
+    .bindInstance(request)
+    .addMultibindingProvider([](){return new Listener(3);});
+}
+
+void test_injectors_share_multibindings() {
+  fruit::NormalizedComponent<fruit::Required<Request>> normalized_component(getComponent());
+  
+  Request request1{1};
+  Request request2{2};
+  fruit::Injector<Request> injector1(normalized_component, getRequestComponent(request1));
+  fruit::Injector<Request> injector2(normalized_component, getRequestComponent(request2));
+  
+  const std::vector<Listener*>& listeners1 = injector1.getMultibindings<Listener>();
+  const std::vector<Listener*>& listeners2 = injector2.getMultibindings<Listener>();
+  Assert(listeners1.size() == 3);
+  Assert(listeners2.size() == 3);
+  Assert(listeners1[0]->id == 1);
+  Assert(listeners1[1]->id == 2);
+  Assert(listeners1[2]->id == 101);
+  Assert(listeners2[2]->id == 102);
+  // Each injector constructs its own objects.
+  Assert(listeners1[0] != listeners2[0]);
+  Assert(Listener::num_instances == 6);
+  
+  Assert(injector1.getMultibindings<int>().size() == 1);
+  Assert(injector1.getMultibindings<int>()[0] == &five);
+  Assert(injector2.getMultibindings<int>()[0] == &five);
+  Assert(injector1.getMultibindings<double>().empty());
+}
+
+void test_injector_adds_multibindings() {
+  fruit::NormalizedComponent<fruit::Required<Request>> normalized_component(getComponent());
+  
+  Request request{1};
+  fruit::Injector<Request> injector(normalized_component, getRequestComponentWithListener(request));
+  const std::vector<Listener*>& listeners = injector.getMultibindings<Listener>();
+  Assert(listeners.size() == 4);
+  Assert(listeners[0]->id == 1);
+  Assert(listeners[1]->id == 2);
+  Assert(listeners[2]->id == 101);
+  Assert(listeners[3]->id == 3);
+  
+  fruit::Injector<Request> injector2(normalized_component, getRequestComponent(request));
+  Assert(injector2.getMultibindings<Listener>().size() == 3);
+}
+
+int main() {
+  test_injectors_share_multibindings();
+  test_injector_adds_multibindings();
+  
+  Assert(Listener::num_instances == 0);
+  
+  return 0;
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_common.h"
+
+#include <vector>
+
+// A chain of types, where X<n> depends on X<n-1> and on the interface I<n>, bound to the implementation Impl<n>.
+template <int n>
+struct I {
+  virtual int get() = 0;
+};
+
+template <int n>
+struct Impl : public I<n> {
+  INJECT(Impl()) = default;
+  
+  int get() override {
+    return n;
+  }
+};
+
+template <int n>
+struct X {
+  INJECT(X(X<n - 1>& x, I<n>* i))
+    : value(x.value + i->get()) {
+  }
+  
+  int value;
+};
+
+template <>
+struct X<0> {
+  INJECT(X()) = default;
+  
+  int value = 0;
+};
+
+template <int n>
+struct ChainComponent {
+  fruit::Component<X<n>> operator()() {
+    return fruit::createComponent()
+      .install(ChainComponent<n - 1>()())
+      .template bind<I<n>, Impl<n>>()
+      .addMultibindingProvider([](X<n>& x) { return new int(x.value); });
+  }
+};
+
+template <>
+struct ChainComponent<0> {
+  fruit::Component<X<0>> operator()() {
+    return fruit::createComponent();
+  }
+};
+
+constexpr int chain_length = 40;
+
+fruit::Component<X<chain_length>> getComponent() {
+  return fruit::createComponent()
+    .install(ChainComponent<chain_length>()());
+}
+
+void checkInjector(fruit::NormalizedComponent<X<chain_length>>& normalized_component) {
+  fruit::Injector<X<chain_length>> injector(normalized_component, fruit::Component<>(fruit::createComponent()));
+  
+  Assert(injector.get<X<chain_length>&>().value == chain_length * (chain_length + 1) / 2);
+  
+  std::vector<int*> multibindings = injector.getMultibindings<int>();
+  Assert(multibindings.size() == chain_length);
+  int sum = 0;
+  for (int* x : multibindings) {
+    sum += *x;
+  }
+  int expected_sum = 0;
+  for (int n = 1; n <= chain_length; ++n) {
+    expected_sum += n * (n + 1) / 2;
+  }
+  Assert(sum == expected_sum);
+}
+
+int main() {
+  fruit::NormalizedComponent<X<chain_length>> sequential_normalized_component(getComponent());
+  checkInjector(sequential_normalized_component);
+  
+  for (std::size_t num_threads : {1, 2, 3, 4, 16, 0}) {
+    fruit::NormalizedComponent<X<chain_length>> normalized_component(getComponent(), num_threads);
+    checkInjector(normalized_component);
+  }
+  
+  return 0;
+}
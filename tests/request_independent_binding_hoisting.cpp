@@ -0,0 +1,126 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_common.h"
+
+static int num_config_constructed = 0;
+static int num_config_destroyed = 0;
+
+struct Request {
+};
+
+struct Config {
+  INJECT(Config()) {
+    ++num_config_constructed;
+  }
+  
+  ~Config() {
+    ++num_config_destroyed;
+  }
+};
+
+struct Service {
+  INJECT(Service(Config& config))
+    : config(config) {
+  }
+  
+  Config& config;
+};
+
+// Depends on the required type, so it's constructed in each injector.
+struct Handler {
+  INJECT(Handler(Service& service, Request& request))
+    : service(service), request(request) {
+  }
+  
+  Service& service;
+  Request& request;
+};
+
+// Depends on a Provider, so it's constructed in each injector.
+struct LazyUser {
+  INJECT(LazyUser(fruit::Provider<Config> provider))
+    : provider(provider) {
+  }
+  
+  fruit::Provider<Config> provider;
+};
+
+fruit::Component<Service> getServiceComponent() {
+  return fruit::createComponent();
+}
+
+fruit::Component<fruit::Required<Request>, Handler, LazyUser> getHandlerComponent() {
+  return fruit::createComponent()
+    .install(getServiceComponent());
+}
+
+// This binds Service and Config in the same way as the normalized component.
+fruit::Component<Request, Service> getRequestComponent(Request& request) {
+  return fruit::createComponent()
+    .install(getServiceComponent())
+    .bindInstance(request);
+}
+
+int main() {
+  {
+    fruit::NormalizedComponent<fruit::Required<Request>, Handler, LazyUser> normalized_component(getHandlerComponent());
+    Assert(normalized_component.getNumHoistedBindings() == 0);
+    Assert(num_config_constructed == 0);
+  }
+  
+  for (std::size_t num_threads : {1, 3}) {
+    num_config_constructed = 0;
+    num_config_destroyed = 0;
+    {
+      fruit::NormalizedComponentOptions options;
+      options.num_threads = num_threads;
+      options.hoist_request_independent_bindings = true;
+      fruit::NormalizedComponent<fruit::Required<Request>, Handler, LazyUser> normalized_component(
+          getHandlerComponent(), options);
+      
+      // Config and Service.
+      Assert(normalized_component.getNumHoistedBindings() == 2);
+      Assert(num_config_constructed == 1);
+      
+      Request request1;
+      Request request2;
+      fruit::Injector<Handler, LazyUser> injector1(normalized_component, getRequestComponent(request1));
+      fruit::Injector<Handler, LazyUser> injector2(normalized_component, getRequestComponent(request2));
+      
+      Handler& handler1 = injector1.get<Handler&>();
+      Handler& handler2 = injector2.get<Handler&>();
+      Assert(&handler1 != &handler2);
+      Assert(&handler1.request == &request1);
+      Assert(&handler2.request == &request2);
+      Assert(&handler1.service == &handler2.service);
+      
+      LazyUser& lazy_user1 = injector1.get<LazyUser&>();
+      LazyUser& lazy_user2 = injector2.get<LazyUser&>();
+      Assert(&lazy_user1 != &lazy_user2);
+      Assert(lazy_user1.provider.get<Config*>() == &handler1.service.config);
+      Assert(lazy_user2.provider.get<Config*>() == &handler1.service.config);
+      
+      injector1.eagerlyInjectAll();
+      injector2.eagerlyInjectAll();
+      Assert(num_config_constructed == 1);
+    }
+    // The shared objects are destroyed with the NormalizedComponent.
+    Assert(num_config_destroyed == 1);
+  }
+  
+  return 0;
+}
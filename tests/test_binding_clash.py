@@ -376,3 +376,37 @@ def test_during_component_merge_consistent_ok(XAnnot):
 if __name__== '__main__':
     code = pytest.main(args=[os.path.realpath(__file__)])
     exit(code)
+
+@pytest.mark.parametrize('First,Second', [
+    ('X', 'Y'),
+    ('Y', 'X'),
+])
+@pytest.mark.parametrize('NumThreads', ['1', '2', '4'])
+def test_multiple_conflicts_first_conflicting_type_reported(First, Second, NumThreads):
+    source = '''
+        struct X {};
+        struct Y {};
+
+        fruit::Component<> getBindings(First& first, Second& second) {
+          return fruit::createComponent()
+            .bindInstance(first)
+            .bindInstance(second);
+        }
+
+        fruit::Component<> getComponent(First& first1, Second& second1, First& first2, Second& second2) {
+          return fruit::createComponent()
+            .install(getBindings(first1, second1))
+            .install(getBindings(first2, second2));
+        }
+
+        int main() {
+          First first1, first2;
+          Second second1, second2;
+          fruit::NormalizedComponent<> normalizedComponent(getComponent(first1, second1, first2, second2), NumThreads);
+        }
+        '''
+    expect_runtime_error(
+        'Fatal injection error: the type (struct )?First was provided more than once, with different bindings.',
+        COMMON_DEFINITIONS,
+        source,
+        locals())
@@ -154,6 +154,36 @@ def test_compression_undone():
         COMMON_DEFINITIONS,
         source)
 
+def test_compression_not_performed_when_class_is_exposed():
+    source = '''
+        struct I {
+          virtual ~I() = default;
+        };
+        struct C : public I, ConstructionTracker<C> {
+          INJECT(C()) = default;
+        };
+
+        fruit::Component<I, C> getComponent() {
+          return fruit::createComponent()
+              .bind<I, C>();
+        }
+
+        int main() {
+          // Both I and C are exposed, so the binding I->C can't be compressed and neither binding can be pruned.
+          fruit::NormalizedComponentOptions options;
+          options.prune_unreachable_bindings = true;
+          fruit::NormalizedComponent<I, C> normalizedComponent(getComponent(), options);
+          Assert(normalizedComponent.getNumPrunedBindings() == 0);
+
+          fruit::Injector<I, C> injector(normalizedComponent, fruit::Component<>(fruit::createComponent()));
+          Assert(injector.get<I*>() == injector.get<C*>());
+          Assert(C::num_objects_constructed == 1);
+        }
+        '''
+    expect_success(
+        COMMON_DEFINITIONS,
+        source)
+
 if __name__== '__main__':
     code = pytest.main(args=[os.path.realpath(__file__)])
     exit(code)
@@ -90,6 +90,30 @@ def test_error_types_not_provided(XAnnot):
         source,
         locals())
 
+@pytest.mark.parametrize('XAnnot', [
+    'X',
+    'fruit::Annotated<Annotation1, X>',
+])
+def test_error_child_injector_with_unsatisfied_requirements(XAnnot):
+    source = '''
+        struct X {};
+
+        fruit::Component<fruit::Required<XAnnot>> getComponent() {
+          return fruit::createComponent();
+        }
+
+        int main() {
+          fruit::Injector<> parent(fruit::Component<>(fruit::createComponent()));
+          fruit::Injector<> injector(parent, getComponent());
+        }
+        '''
+    expect_compile_error(
+        'UnsatisfiedRequirementsInChildInjectorError<XAnnot>',
+        'The requirements in UnsatisfiedRequirements are required by the Component used to create a child injector but are not provided by the parent Injector.',
+        COMMON_DEFINITIONS,
+        source,
+        locals())
+
 @pytest.mark.parametrize('XAnnot', [
     'X',
     'fruit::Annotated<Annotation1, X>',
@@ -191,6 +215,27 @@ def test_error_type_not_provided_with_annotation(XAnnot, YAnnot):
         source,
         locals())
 
+def test_enable_reset_after_injection_error():
+    source = '''
+        struct X {
+          using Inject = X();
+        };
+
+        fruit::Component<X> getComponent() {
+          return fruit::createComponent();
+        }
+
+        int main() {
+          fruit::Injector<X> injector(getComponent());
+          injector.get<X*>();
+          injector.enableReset();
+        }
+        '''
+    expect_runtime_error(
+        'Fatal injection error: enableReset\(\) was called on an injector that already injected some objects',
+        COMMON_DEFINITIONS,
+        source)
+
 if __name__== '__main__':
     code = pytest.main(args=[os.path.realpath(__file__)])
     exit(code)
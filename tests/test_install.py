@@ -114,6 +114,59 @@ def test_with_requirements_not_specified_in_child_component_error():
         COMMON_DEFINITIONS,
         source)
 
+def test_type_bound_in_two_installed_components_is_allocated_once():
+    source = '''
+        // Y is bound (in the same way) by both getX1Component() and getX2Component(), but nothing depends on it.
+        struct Y {
+          INJECT(Y()) = default;
+          char data[1000];
+        };
+
+        struct X1 {
+          INJECT(X1()) = default;
+        };
+
+        struct X2 {
+          INJECT(X2()) = default;
+        };
+
+        fruit::Component<X1> getX1Component() {
+          return fruit::createComponent()
+            .registerConstructor<Y()>();
+        }
+
+        fruit::Component<X2> getX2Component() {
+          return fruit::createComponent()
+            .registerConstructor<Y()>();
+        }
+
+        fruit::Component<X1, X2> getComponentWithOneY() {
+          return fruit::createComponent()
+            .install(getX1Component())
+            .registerConstructor<X2()>();
+        }
+
+        fruit::Component<X1, X2> getComponentWithTwoYs() {
+          return fruit::createComponent()
+            .install(getX1Component())
+            .install(getX2Component());
+        }
+
+        int main() {
+          fruit::NormalizedComponentOptions options;
+          options.prune_unreachable_bindings = true;
+          fruit::NormalizedComponent<X1, X2> normalizedComponentWithOneY(getComponentWithOneY(), options);
+          fruit::NormalizedComponent<X1, X2> normalizedComponentWithTwoYs(getComponentWithTwoYs(), options);
+
+          // Space for Y is reserved once per type, not once per binding.
+          Assert(normalizedComponentWithOneY.getNumPrunedBindings() == 1);
+          Assert(normalizedComponentWithTwoYs.getNumPrunedBindings() == 1);
+          Assert(normalizedComponentWithOneY.getNumPrunedBytes() >= sizeof(Y));
+          Assert(normalizedComponentWithTwoYs.getNumPrunedBytes() == normalizedComponentWithOneY.getNumPrunedBytes());
+        }
+        '''
+    expect_success(COMMON_DEFINITIONS, source)
+
 if __name__== '__main__':
     code = pytest.main(args=[os.path.realpath(__file__)])
     exit(code)
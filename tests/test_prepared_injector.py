@@ -0,0 +1,221 @@
+#!/usr/bin/env python3
+#  Copyright 2016 Google Inc. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS-IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+import pytest
+
+from fruit_test_common import *
+
+COMMON_DEFINITIONS = '''
+    #include "test_common.h"
+
+    struct X {
+      int value;
+    };
+
+    struct Y {
+      X& x;
+    };
+
+    struct Annotation1 {};
+    using XAnnot1 = fruit::Annotated<Annotation1, X>;
+
+    struct Annotation2 {};
+    using YAnnot2 = fruit::Annotated<Annotation2, Y>;
+    '''
+
+@pytest.mark.parametrize('XAnnot,XRefAnnot,YAnnot,YPtrAnnot', [
+    ('X', 'X&', 'Y', 'Y*'),
+    ('fruit::Annotated<Annotation1, X>', 'fruit::Annotated<Annotation1, X&>', 'fruit::Annotated<Annotation2, Y>', 'fruit::Annotated<Annotation2, Y*>'),
+])
+def test_success(XAnnot, XRefAnnot, YAnnot, YPtrAnnot):
+    source = '''
+        fruit::Component<fruit::Required<XAnnot>, YAnnot> getComponent() {
+          return fruit::createComponent()
+            .registerProvider<YAnnot(XRefAnnot)>([](X& x) { return Y{x}; });
+        }
+
+        fruit::Component<XAnnot> getXComponent(X& x) {
+          return fruit::createComponent()
+            .bindInstance<XAnnot, X>(x);
+        }
+
+        int main() {
+          fruit::NormalizedComponent<fruit::Required<XAnnot>, YAnnot> normalizedComponent(getComponent());
+
+          X sampleX{0};
+          fruit::PreparedInjector<YAnnot> preparedInjector(normalizedComponent, getXComponent(sampleX));
+
+          for (int i = 1; i <= 3; ++i) {
+            X x{i};
+            fruit::Injector<YAnnot> injector(preparedInjector, getXComponent(x));
+            Y* y = injector.get<YPtrAnnot>();
+            Assert(&(y->x) == &x);
+            Assert(y->x.value == i);
+          }
+        }
+        '''
+    expect_success(
+        COMMON_DEFINITIONS,
+        source,
+        locals())
+
+def test_success_with_exposed_instance():
+    source = '''
+        fruit::Component<fruit::Required<X>, Y> getComponent() {
+          return fruit::createComponent()
+            .registerProvider([](X& x) { return Y{x}; });
+        }
+
+        fruit::Component<X> getXComponent(X& x) {
+          return fruit::createComponent()
+            .bindInstance(x);
+        }
+
+        int main() {
+          fruit::NormalizedComponent<fruit::Required<X>, Y> normalizedComponent(getComponent());
+
+          X sampleX{0};
+          fruit::PreparedInjector<X, Y> preparedInjector(normalizedComponent, getXComponent(sampleX));
+
+          X x1{1};
+          X x2{2};
+          fruit::Injector<X, Y> injector1(preparedInjector, getXComponent(x1));
+          fruit::Injector<X, Y> injector2(preparedInjector, getXComponent(x2));
+          Assert(&(injector1.get<X&>()) == &x1);
+          Assert(&(injector2.get<X&>()) == &x2);
+          Assert(&(injector1.get<Y&>().x) == &x1);
+          Assert(&(injector2.get<Y&>().x) == &x2);
+        }
+        '''
+    expect_success(
+        COMMON_DEFINITIONS,
+        source)
+
+def test_success_multibindings():
+    source = '''
+        fruit::Component<> getComponent() {
+          static X x1{1};
+          return fruit::createComponent()
+            .addInstanceMultibinding(x1);
+        }
+
+        fruit::Component<> getRequestComponent(X& x) {
+          static X x3{3};
+          return fruit::createComponent()
+            .addInstanceMultibinding(x)
+            .addInstanceMultibinding(x3);
+        }
+
+        int main() {
+          fruit::NormalizedComponent<> normalizedComponent(getComponent());
+
+          X sampleX{0};
+          fruit::PreparedInjector<> preparedInjector(normalizedComponent, getRequestComponent(sampleX));
+
+          X x2{2};
+          fruit::Injector<> injector(preparedInjector, getRequestComponent(x2));
+          const std::vector<X*>& multibindings = injector.getMultibindings<X>();
+          Assert(multibindings.size() == 3);
+          Assert(multibindings[0]->value == 1);
+          Assert(multibindings[1] == &x2);
+          Assert(multibindings[2]->value == 3);
+        }
+        '''
+    expect_success(
+        COMMON_DEFINITIONS,
+        source)
+
+def test_different_bindings_error():
+    source = '''
+        fruit::Component<fruit::Required<X>, Y> getComponent() {
+          return fruit::createComponent()
+            .registerProvider([](X& x) { return Y{x}; });
+        }
+
+        fruit::Component<X> getXComponent(X& x) {
+          return fruit::createComponent()
+            .bindInstance(x);
+        }
+
+        fruit::Component<X> getOtherXComponent() {
+          return fruit::createComponent()
+            .registerProvider([]() { return X{1}; });
+        }
+
+        int main() {
+          fruit::NormalizedComponent<fruit::Required<X>, Y> normalizedComponent(getComponent());
+
+          X sampleX{0};
+          fruit::PreparedInjector<Y> preparedInjector(normalizedComponent, getXComponent(sampleX));
+
+          fruit::Injector<Y> injector(preparedInjector, getOtherXComponent());
+        }
+        '''
+    expect_runtime_error(
+        'Fatal injection error: the Component used to create this injector doesn.t have the same bindings as the one used to create the PreparedInjector',
+        COMMON_DEFINITIONS,
+        source)
+
+def test_component_with_requirements_error():
+    source = '''
+        fruit::Component<fruit::Required<X>, Y> getComponent() {
+          return fruit::createComponent()
+            .registerProvider([](X& x) { return Y{x}; });
+        }
+
+        fruit::Component<X> getXComponent(X& x) {
+          return fruit::createComponent()
+            .bindInstance(x);
+        }
+
+        fruit::Component<fruit::Required<X>> getEmptyComponent() {
+          return fruit::createComponent();
+        }
+
+        int main() {
+          fruit::NormalizedComponent<fruit::Required<X>, Y> normalizedComponent(getComponent());
+
+          X sampleX{0};
+          fruit::PreparedInjector<Y> preparedInjector(normalizedComponent, getXComponent(sampleX));
+
+          fruit::Injector<Y> injector(preparedInjector, getEmptyComponent());
+        }
+        '''
+    expect_compile_error(
+        'ComponentWithRequirementsInInjectorError<X>',
+        'When using the two-argument constructor of Injector, the component used as second parameter must not have requirements',
+        COMMON_DEFINITIONS,
+        source)
+
+def test_unsatisfied_requirements_error():
+    source = '''
+        fruit::Component<fruit::Required<X>, Y> getComponent() {
+          return fruit::createComponent()
+            .registerProvider([](X& x) { return Y{x}; });
+        }
+
+        int main() {
+          fruit::NormalizedComponent<fruit::Required<X>, Y> normalizedComponent(getComponent());
+          fruit::PreparedInjector<Y> preparedInjector(normalizedComponent, fruit::Component<>(fruit::createComponent()));
+        }
+        '''
+    expect_compile_error(
+        'UnsatisfiedRequirementsInNormalizedComponentError<X>',
+        'The requirements in UnsatisfiedRequirements are required by the NormalizedComponent but are not provided by the Component',
+        COMMON_DEFINITIONS,
+        source)
+
+if __name__== '__main__':
+    code = pytest.main(args=[os.path.realpath(__file__)])
+    exit(code)
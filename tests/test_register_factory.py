@@ -1161,6 +1161,40 @@ def test_error_not_function():
         COMMON_DEFINITIONS,
         source)
 
+def test_register_factory_does_not_bind_fruit_factory():
+    source = '''
+        struct X {
+          X(int) {}
+        };
+
+        fruit::Component<fruit::Factory<X(int)>> getComponent() {
+          return fruit::createComponent()
+            .registerFactory<X(fruit::Assisted<int>)>([](int n){return X(n);});
+        }
+        '''
+    expect_compile_error(
+        'NoBindingFoundError<fruit::Factory<X\\(int\\)>>',
+        'No explicit binding nor C::Inject definition was found for T.',
+        COMMON_DEFINITIONS,
+        source)
+
+def test_register_fruit_factory_does_not_bind_std_function():
+    source = '''
+        struct X {
+          X(int) {}
+        };
+
+        fruit::Component<std::function<X(int)>> getComponent() {
+          return fruit::createComponent()
+            .registerFruitFactory<X(fruit::Assisted<int>)>([](int n){return X(n);});
+        }
+        '''
+    expect_compile_error(
+        'NoBindingFoundError<std::function<X\\(int\\)>>',
+        'No explicit binding nor C::Inject definition was found for T.',
+        COMMON_DEFINITIONS,
+        source)
+
 @pytest.mark.parametrize('ScalerAnnot,ScalerImplAnnot,ScalerImplPtrAnnot,ScalerFactoryAnnot,ScalerImplFactorySignatureAnnotRegex', [
     ('Scaler',
      'ScalerImpl',
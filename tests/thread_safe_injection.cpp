@@ -0,0 +1,337 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_common.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const int num_threads = 8;
+static const int num_iterations = 100;
+
+struct X {
+  INJECT(X()) {
+    ++num_constructions;
+    // Make it more likely that other threads try to get this object while it's being constructed.
+    std::this_thread::yield();
+  }
+  
+  static std::atomic<int> num_constructions;
+};
+
+std::atomic<int> X::num_constructions{0};
+
+struct Y {
+  X& x;
+  
+  INJECT(Y(X& x))
+    : x(x) {
+    ++num_constructions;
+  }
+  
+  static std::atomic<int> num_constructions;
+};
+
+std::atomic<int> Y::num_constructions{0};
+
+struct Z {
+  INJECT(Z(X& x, fruit::Provider<Y> y_provider))
+    : x(x), y(y_provider.get()) {
+    ++num_constructions;
+  }
+  
+  X& x;
+  Y* y;
+  
+  static std::atomic<int> num_constructions;
+};
+
+std::atomic<int> Z::num_constructions{0};
+
+struct Listener {
+  virtual ~Listener() = default;
+};
+
+struct ListenerImpl : public Listener {
+  INJECT(ListenerImpl()) = default;
+};
+
+fruit::Component<Y, Z> getComponent() {
+  return fruit::createComponent()
+    .addMultibinding<Listener, ListenerImpl>();
+}
+
+void resetCounts() {
+  X::num_constructions = 0;
+  Y::num_constructions = 0;
+  Z::num_constructions = 0;
+}
+
+void test_concurrent_get() {
+  resetCounts();
+  fruit::Injector<Y, Z> injector(getComponent());
+  injector.enableThreadSafety();
+  
+  std::vector<Y*> ys(num_threads);
+  std::vector<Z*> zs(num_threads);
+  std::vector<const std::vector<Listener*>*> listeners(num_threads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.emplace_back([&injector, &ys, &zs, &listeners, i]() {
+      for (int j = 0; j < num_iterations; ++j) {
+        // Even and odd threads get the objects in different orders.
+        if (i % 2 == 0) {
+          ys[i] = injector.get<Y*>();
+          zs[i] = injector.get<Z*>();
+        } else {
+          zs[i] = injector.get<Z*>();
+          ys[i] = injector.get<Y*>();
+        }
+        listeners[i] = &injector.getMultibindings<Listener>();
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  
+  Assert(X::num_constructions == 1);
+  Assert(Y::num_constructions == 1);
+  Assert(Z::num_constructions == 1);
+  for (int i = 0; i < num_threads; ++i) {
+    Assert(ys[i] == ys[0]);
+    Assert(zs[i] == zs[0]);
+    Assert(listeners[i] == listeners[0]);
+  }
+  Assert(&ys[0]->x == &zs[0]->x);
+  Assert(zs[0]->y == ys[0]);
+  Assert(listeners[0]->size() == 1);
+}
+
+void test_concurrent_get_after_reset() {
+  resetCounts();
+  fruit::Injector<Y, Z> injector(getComponent());
+  injector.enableReset();
+  injector.enableThreadSafety();
+  
+  for (int k = 1; k <= 3; ++k) {
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; ++i) {
+      threads.emplace_back([&injector]() {
+        injector.get<Z*>();
+      });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    Assert(X::num_constructions == k);
+    Assert(Y::num_constructions == k);
+    Assert(Z::num_constructions == k);
+    
+    injector.reset();
+  }
+}
+
+void test_eagerly_inject_all_with_threads() {
+  resetCounts();
+  fruit::Injector<Y, Z> injector(getComponent());
+  injector.eagerlyInjectAll(num_threads);
+  
+  Assert(X::num_constructions == 1);
+  Assert(Y::num_constructions == 1);
+  Assert(Z::num_constructions == 1);
+  Assert(injector.getMultibindings<Listener>().size() == 1);
+  Assert(&injector.get<Y&>().x == &injector.get<Z&>().x);
+  Assert(injector.get<Z&>().y == injector.get<Y*>());
+}
+
+struct OnlyProvided {
+  INJECT(OnlyProvided()) {
+    ++num_constructions;
+  }
+  
+  static std::atomic<int> num_constructions;
+};
+
+std::atomic<int> OnlyProvided::num_constructions{0};
+
+struct W {
+  INJECT(W(fruit::Provider<OnlyProvided>)) {
+  }
+};
+
+void test_eagerly_inject_all_with_threads_skips_provided_types() {
+  fruit::Injector<W> injector(fruit::Component<W>(fruit::createComponent()));
+  injector.eagerlyInjectAll(num_threads);
+  Assert(OnlyProvided::num_constructions == 0);
+}
+
+struct Throwing {
+  INJECT(Throwing()) {
+    throw std::runtime_error("Throwing::Throwing()");
+  }
+};
+
+void test_eagerly_inject_all_with_threads_exception() {
+  resetCounts();
+  fruit::Injector<Y, Throwing> injector(fruit::Component<Y, Throwing>(fruit::createComponent()));
+  try {
+    injector.eagerlyInjectAll(num_threads);
+    Assert(false);
+  } catch (const std::runtime_error& e) {
+    Assert(std::string(e.what()) == "Throwing::Throwing()");
+  }
+  // The injector can still be used.
+  injector.get<Y*>();
+  Assert(Y::num_constructions == 1);
+}
+
+// LeftBranch and RightBranch are independent deps of the same root. Each constructor waits (up to a timeout) until the
+// other one has started, so they're only both constructed successfully if they run concurrently.
+std::atomic<int> num_started_branches{0};
+
+bool waitForOtherBranch() {
+  ++num_started_branches;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (num_started_branches < 2) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::yield();
+  }
+  return true;
+}
+
+struct LeftLeaf {
+  INJECT(LeftLeaf()) = default;
+};
+
+struct LeftBranch {
+  INJECT(LeftBranch(LeftLeaf&))
+    : saw_other_branch(waitForOtherBranch()) {
+  }
+  
+  bool saw_other_branch;
+};
+
+struct RightBranch {
+  INJECT(RightBranch())
+    : saw_other_branch(waitForOtherBranch()) {
+  }
+  
+  bool saw_other_branch;
+};
+
+struct Root {
+  INJECT(Root(LeftBranch& left, RightBranch& right))
+    : left(left), right(right) {
+  }
+  
+  LeftBranch& left;
+  RightBranch& right;
+};
+
+void test_eagerly_inject_all_with_threads_constructs_subtrees_concurrently() {
+  fruit::Injector<Root> injector(fruit::Component<Root>(fruit::createComponent()));
+  injector.eagerlyInjectAll(2);
+  Root& root = injector.get<Root&>();
+  Assert(root.left.saw_other_branch);
+  Assert(root.right.saw_other_branch);
+}
+
+struct Exporter {
+  X& x;
+  int id;
+  
+  Exporter(X& x, int id)
+    : x(x), id(id) {
+    // Make it more likely that the elements are constructed concurrently.
+    std::this_thread::yield();
+  }
+};
+
+fruit::Component<> getExportersComponent() {
+  return fruit::createComponent()
+    .addMultibindingProvider([](X& x) { return new Exporter(x, 1); })
+    .addMultibindingProvider([](X& x) { return new Exporter(x, 2); })
+    .addMultibindingProvider([](X& x) { return new Exporter(x, 3); })
+    .addMultibindingProvider([](X& x) { return new Exporter(x, 4); })
+    .addMultibindingProvider([](X& x) { return new Exporter(x, 5); });
+}
+
+void test_get_multibindings_parallel() {
+  std::vector<int> expected_ids;
+  {
+    fruit::Injector<> injector(getExportersComponent());
+    for (Exporter* exporter : injector.getMultibindings<Exporter>()) {
+      expected_ids.push_back(exporter->id);
+    }
+  }
+  
+  for (int i = 0; i < num_iterations; ++i) {
+    resetCounts();
+    fruit::Injector<> injector(getExportersComponent());
+    const std::vector<Exporter*>& exporters = injector.getMultibindingsParallel<Exporter>(num_threads);
+    
+    // The shared dependency is constructed once, and the order is the same as with getMultibindings().
+    Assert(X::num_constructions == 1);
+    Assert(exporters.size() == expected_ids.size());
+    for (std::size_t j = 0; j < exporters.size(); ++j) {
+      Assert(exporters[j]->id == expected_ids[j]);
+      Assert(&exporters[j]->x == &exporters[0]->x);
+    }
+    Assert(&injector.getMultibindings<Exporter>() == &exporters);
+  }
+  
+  // There are no multibindings for this type.
+  fruit::Injector<> injector(getExportersComponent());
+  Assert(injector.getMultibindingsParallel<Listener>(num_threads).empty());
+}
+
+struct ThrowingListener : public Listener {
+  INJECT(ThrowingListener()) {
+    throw std::runtime_error("ThrowingListener::ThrowingListener()");
+  }
+};
+
+void test_get_multibindings_parallel_exception() {
+  fruit::Injector<> injector(fruit::Component<>(fruit::createComponent()
+      .addMultibinding<Listener, ListenerImpl>()
+      .addMultibinding<Listener, ThrowingListener>()));
+  try {
+    injector.getMultibindingsParallel<Listener>(num_threads);
+    Assert(false);
+  } catch (const std::runtime_error& e) {
+    Assert(std::string(e.what()) == "ThrowingListener::ThrowingListener()");
+  }
+}
+
+int main() {
+  test_concurrent_get();
+  test_concurrent_get_after_reset();
+  test_eagerly_inject_all_with_threads();
+  test_eagerly_inject_all_with_threads_skips_provided_types();
+  test_eagerly_inject_all_with_threads_exception();
+  test_eagerly_inject_all_with_threads_constructs_subtrees_concurrently();
+  test_get_multibindings_parallel();
+  test_get_multibindings_parallel_exception();
+  
+  return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_common.h"
+
+// I->C is a binding compression reachable from X, J->D is one that's unreachable.
+struct I {
+  virtual ~I() = default;
+};
+
+struct C : public I {
+  INJECT(C()) = default;
+};
+
+struct J {
+  virtual ~J() = default;
+};
+
+struct D : public J {
+  INJECT(D()) = default;
+};
+
+// Only reachable through the multibinding.
+struct W {
+  INJECT(W()) = default;
+  
+  int value = 5;
+};
+
+struct X {
+  INJECT(X(I* i, double& d))
+    : i(i), d(d) {
+  }
+  
+  I* i;
+  double& d;
+};
+
+// Y and Z are unreachable (and so are J and D, since only Z depends on J).
+struct Y {
+  INJECT(Y()) {
+    Assert(false);
+  }
+};
+
+struct Z {
+  Z(Y&, J*) {
+    Assert(false);
+  }
+};
+
+fruit::Component<fruit::Required<double>, X> getComponent() {
+  return fruit::createComponent()
+    .bind<I, C>()
+    .bind<J, D>()
+    .registerConstructor<Z(Y&, J*)>()
+    .addMultibindingProvider([](W& w) { return new int(w.value); });
+}
+
+fruit::Component<double> getDoubleComponent(double& d) {
+  return fruit::createComponent()
+    .bindInstance(d);
+}
+
+int main() {
+  fruit::NormalizedComponent<fruit::Required<double>, X> normalized_component(getComponent());
+  Assert(normalized_component.getNumPrunedBindings() == 0);
+  Assert(normalized_component.getNumPrunedBytes() == 0);
+  
+  for (std::size_t num_threads : {1, 3}) {
+    fruit::NormalizedComponentOptions options;
+    options.num_threads = num_threads;
+    options.prune_unreachable_bindings = true;
+    fruit::NormalizedComponent<fruit::Required<double>, X> pruned_normalized_component(getComponent(), options);
+    
+    // J, D, Y and Z.
+    Assert(pruned_normalized_component.getNumPrunedBindings() == 4);
+    Assert(pruned_normalized_component.getNumPrunedBytes() >= sizeof(D) + sizeof(Y) + sizeof(Z));
+    
+    double d = 1.0;
+    fruit::Injector<X> injector(pruned_normalized_component, getDoubleComponent(d));
+    X& x = injector.get<X&>();
+    Assert(&x.d == &d);
+    Assert(dynamic_cast<C*>(x.i) != nullptr);
+    
+    std::vector<int*> multibindings = injector.getMultibindings<int>();
+    Assert(multibindings.size() == 1);
+    Assert(*multibindings[0] == 5);
+    
+    injector.eagerlyInjectAll();
+  }
+  
+  return 0;
+}